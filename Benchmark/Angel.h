@@ -0,0 +1,238 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Angel.h ---
+//
+//   The main header file for all examples from Angel 6th Edition
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ANGEL_H__
+#define __ANGEL_H__
+
+//----------------------------------------------------------------------------
+// 
+// --- Include system headers ---
+//
+
+#include <cmath>	 // 包含C++数学库
+#include <iostream>  // 包含C++标准输入输出库
+#include <memory>
+
+//  Define M_PI in the case it's not defined in the math header file
+#ifndef M_PI
+#  define M_PI  3.14159265358979323846
+#endif
+
+//----------------------------------------------------------------------------
+//
+// --- Include OpenGL header files and helpers ---
+//
+//   The location of these files vary by operating system.  We've included
+//     copies of open-soruce project headers in the "GL" directory local
+//     this this "include" directory.
+//
+
+#ifdef __APPLE__  // include Mac OS X verions of headers
+#  include <OpenGL/OpenGL.h>
+#  include <GLUT/glut.h>
+#else // non-Mac OS X operating systems
+#  include <GL/glew.h>
+#  include <GL/freeglut.h>
+#  include <GL/freeglut_ext.h>
+#pragma comment (lib, "glew32.lib")  // Zou Kun额外增加，用于链接glew库
+#endif  // __APPLE__
+
+// Define a helpful macro for handling offsets into buffer objects
+// 定义buffer对象偏移量宏，主要实现类型转化
+#define BUFFER_OFFSET( offset )   ((GLvoid*) (offset))
+
+//----------------------------------------------------------------------------
+//
+//  --- Include our class libraries and constants ---
+//
+
+namespace Angel
+{
+	struct Shader
+	{
+		const char*    filename; // shader文件名
+		GLenum         type;     // shader类型
+		const GLchar*  source;   // shader程序字符串(指向映射的文件或嵌入的常量，不以 '\0' 结尾)
+		GLint          length;   // 源码长度
+	}; // 定义Shader结构体数组shaders
+
+	//  声明加载顶点和片元shader的函数，此函数定义于InitShader.cpp中
+	//  读取、编译或链接失败时输出错误信息并退出程序
+	GLuint InitShader(const char* vertexShaderFile, const char* fragmentShaderFile);
+
+	//  异步编译的shader程序(类似 std::future)，由 InitShaderAsync 返回
+	//  ready() 查询编译是否完成，不阻塞；get() 等待完成并返回程序对象，在第一次使用程序时调用。
+//  失败时与 InitShader 一样退出程序，只有重新编译(attribLocationsFrom 非 0)失败时返回 0
+	class ShaderFuture
+	{
+	public:
+		struct State;
+
+		bool ready() const;
+		GLuint get();
+
+	private:
+		std::shared_ptr<State> _state;
+		friend ShaderFuture InitShaderAsync(const char* vertexShaderFile, const char* fragmentShaderFile,
+			GLuint attribLocationsFrom);
+	};
+
+	//  提交编译后立即返回，同一场景的所有程序先一起提交，做完不需要程序的初始化(生成网格等)后再逐个 get()。
+	//  有 KHR_parallel_shader_compile 时由驱动并行编译，否则在 Windows 上每个程序由一个后台线程(共享上下文)编译；
+	//  其他平台没有该扩展时不能在后台编译，get() 在主线程中依次等待，多个程序之间没有并行
+	//  attribLocationsFrom 非 0 时新程序的属性位置与该程序相同(重新编译时原来的 VAO 仍然有效)
+	ShaderFuture InitShaderAsync(const char* vertexShaderFile, const char* fragmentShaderFile,
+		GLuint attribLocationsFrom = 0);
+
+	//  shader 热重载：源文件修改后在后台重新编译，成功时替换 program(复制 uniform 的值，属性位置不变)，
+	//  失败时输出错误信息并保留原程序。program 必须是一直有效的变量(通常为全局变量)。
+//  重新编译在 GLUT 定时器中检查，ready() 后才取结果；Linux 等没有 KHR_parallel_shader_compile 的非 Windows 平台上
+//  ready() 总是为 true，编译在定时器回调的 get() 中同步完成，期间 GLUT 主循环停顿(一般为几十毫秒)
+	void WatchShader(GLuint& program, const char* vertexShaderFile, const char* fragmentShaderFile);
+
+	//  获取 uniform 变量的位置，WatchShader 登记的 program 重新编译后自动更新 location
+	void WatchUniform(GLuint& program, const char* name, GLuint& location);
+
+	//  定义最小浮点数，防止被0除
+	constexpr GLfloat DivideByZeroTolerance = GLfloat(1.0e-07);
+
+	//  角度转弧度的系数 
+	constexpr GLfloat DegreesToRadians = M_PI / 180.0;
+
+}  // namespace Angel
+
+/*包含自定义的头文件*/
+#include "vec.h"
+#include "mat.h"
+#include "quat.h"
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace Angel
+{
+	//----------------------------------------------------------------------------
+	//
+	//  --- span ---
+	//
+	//   连续内存的只读/可写视图(指针 + 元素个数)，不拥有内存。
+	//   顶点数组(new 出来的数组、静态数组、std::vector、映射的缓冲区)都可以包装成 span，
+	//   再直接交给 BufferData / BufferSubData，字节数由 size_bytes() 给出，
+	//   不会再出现把 sizeof(指针) 当作数组大小的错误
+	//
+
+	template <typename T>
+	class span
+	{
+		T* _data;
+		size_t _size;
+
+	public:
+		constexpr span() : _data(nullptr), _size(0) {}
+		constexpr span(T* data, size_t size) : _data(data), _size(size) {}
+
+		template <size_t N>
+		constexpr span(T(&arr)[N]) : _data(arr), _size(N) {}
+
+		// span<T> 可隐式转为 span<const T>
+		template <typename U, typename = typename std::enable_if<
+			std::is_convertible<U(*)[], T(*)[]>::value>::type>
+		constexpr span(const span<U>& s) : _data(s.data()), _size(s.size()) {}
+
+		constexpr T* data() const { return _data; }
+		constexpr size_t size() const { return _size; }
+		constexpr size_t size_bytes() const { return _size * sizeof(T); }
+		constexpr bool empty() const { return _size == 0; }
+
+		constexpr T* begin() const { return _data; }
+		constexpr T* end() const { return _data + _size; }
+		constexpr T& operator [] (size_t i) const { return _data[i]; }
+
+		// 从第 offset 个元素开始的 count 个元素
+		constexpr span subspan(size_t offset, size_t count) const
+		{
+			return span(_data + offset, count);
+		}
+	};
+
+	template <typename T>
+	constexpr span<T> make_span(T* data, size_t size)
+	{
+		return span<T>(data, size);
+	}
+
+	template <typename T, size_t N>
+	constexpr span<T> make_span(T(&arr)[N])
+	{
+		return span<T>(arr);
+	}
+
+	template <typename T, typename A>
+	span<T> make_span(std::vector<T, A>& v)
+	{
+		return span<T>(v.data(), v.size());
+	}
+
+	template <typename T, typename A>
+	span<const T> make_span(const std::vector<T, A>& v)
+	{
+		return span<const T>(v.data(), v.size());
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  --- Buffer upload helpers ---
+	//
+	//   直接把 span 指向的内存交给 OpenGL，不经过中间拷贝。元素类型必须可平凡复制
+	//
+
+	// 为当前绑定到 target 的缓冲区分配空间并上传 data
+	template <typename T>
+	void BufferData(GLenum target, span<T> data, GLenum usage)
+	{
+		static_assert(std::is_trivially_copyable<typename std::remove_const<T>::type>::value,
+			"buffer data must be trivially copyable");
+		glBufferData(target, data.size_bytes(), data.data(), usage);
+	}
+
+	// 更新当前绑定到 target 的缓冲区中从 offset 字节开始的数据
+	template <typename T>
+	void BufferSubData(GLenum target, GLintptr offset, span<T> data)
+	{
+		static_assert(std::is_trivially_copyable<typename std::remove_const<T>::type>::value,
+			"buffer data must be trivially copyable");
+		glBufferSubData(target, offset, data.size_bytes(), data.data());
+	}
+
+	// 映射当前绑定到 target 的缓冲区中从 offset 字节开始的 count 个 T，
+	// 顶点可直接写入返回的 span，写完后调用 glUnmapBuffer(target)。映射失败时返回空 span
+	template <typename T>
+	span<T> MapBufferRange(GLenum target, GLintptr offset, size_t count, GLbitfield access)
+	{
+		static_assert(std::is_trivially_copyable<T>::value,
+			"mapped buffer elements must be trivially copyable");
+		T* ptr = static_cast<T*>(glMapBufferRange(target, offset, count * sizeof(T), access));
+		return ptr ? span<T>(ptr, count) : span<T>();
+	}
+}
+
+// 顶点属性压缩格式、顶点布局和索引网格(用到上面的 span 和 BufferData)
+#include "pack.h"
+#include "vertex.h"
+#include "program.h"
+#include "mesh.h"
+#include "terrain.h"
+
+// 打印输出宏，其中#x表示将x转为字符数组
+#define Print(x)  do { std::cerr << #x " = " << (x) << std::endl; } while(0)
+
+//  使用Angel命名空间
+using namespace Angel;
+
+#endif // __ANGEL_H__
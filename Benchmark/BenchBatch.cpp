@@ -0,0 +1,77 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	批量变换测试：逐个 mat4 * vec4 与 TransformPoints(AoS / SoA / 多线程) 对比
+//------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+
+namespace
+{
+	const size_t NumPoints = 1 << 20;
+
+	std::vector<vec3> In(NumPoints);
+	std::vector<vec3> Out(NumPoints);
+	std::vector<GLfloat> Xs(NumPoints), Ys(NumPoints), Zs(NumPoints);
+	std::vector<GLfloat> OutX(NumPoints), OutY(NumPoints), OutZ(NumPoints);
+}
+
+void BenchBatch()
+{
+	for (size_t i = 0; i < NumPoints; i++)
+	{
+		In[i] = vec3(BenchRandom(), BenchRandom(), BenchRandom());
+		Xs[i] = In[i].x;
+		Ys[i] = In[i].y;
+		Zs[i] = In[i].z;
+	}
+
+	mat4 m = Translate(1.0, 2.0, 3.0) * Rotate(30.0, 1.0, 1.0, 0.0) * Scale(2.0, 2.0, 2.0);
+
+	/*正确性检查*/
+	TransformPoints(m, In.data(), Out.data(), NumPoints);
+	TransformPoints(m, Xs.data(), Ys.data(), Zs.data(), OutX.data(), OutY.data(), OutZ.data(), NumPoints);
+	GLfloat diff = 0.0f;
+	for (size_t i = 0; i < NumPoints; i++)
+	{
+		vec4 ref = m * vec4(In[i], 1.0);
+		diff = std::fmax(diff, std::fabs(ref.x - Out[i].x) + std::fabs(ref.y - Out[i].y) + std::fabs(ref.z - Out[i].z));
+		diff = std::fmax(diff, std::fabs(ref.x - OutX[i]) + std::fabs(ref.y - OutY[i]) + std::fabs(ref.z - OutZ[i]));
+	}
+
+	BenchTitle("Transform 1M points");
+	printf("  %-40s %12g\n", "max |mat4 * vec4 - batch|", diff);
+	printf("  %-40s %12u\n", "hardware threads", std::thread::hardware_concurrency());
+
+	double single = BenchRun("mat4 * vec4 per point", 10, [&m] {
+		for (size_t i = 0; i < NumPoints; i++)
+		{
+			vec4 p = m * vec4(In[i], 1.0);
+			Out[i] = vec3(p.x, p.y, p.z);
+		}
+		BenchSink = BenchSink + Out[NumPoints - 1].x;
+	});
+
+	double aos = BenchRun("TransformPoints AoS, 1 thread", 10, [&m] {
+		TransformPoints(m, In.data(), Out.data(), NumPoints, NumPoints + 1);
+		BenchSink = BenchSink + Out[NumPoints - 1].x;
+	});
+	BenchSpeedup(single, aos);
+
+	double soa = BenchRun("TransformPoints SoA, 1 thread", 10, [&m] {
+		TransformPoints(m, Xs.data(), Ys.data(), Zs.data(),
+			OutX.data(), OutY.data(), OutZ.data(), NumPoints, NumPoints + 1);
+		BenchSink = BenchSink + OutX[NumPoints - 1];
+	});
+	BenchSpeedup(single, soa);
+
+	double parallel = BenchRun("TransformPoints AoS, threaded", 10, [&m] {
+		TransformPoints(m, In.data(), Out.data(), NumPoints);
+		BenchSink = BenchSink + Out[NumPoints - 1].x;
+	});
+	BenchSpeedup(single, parallel);
+}
@@ -0,0 +1,224 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	变换链测试：Solar 一帧的全部模视投影矩阵(7 个物体)，
+//	mat4 运算符链(mv *= ...; proj * mv * Scale(...)) 与 TransformChain 对比；
+//	仿射矩阵的乘法/求逆：mat4 与 affine3x4 对比
+//------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+
+namespace
+{
+	const int NumObjects = 7;
+
+	constexpr mat4 matRotateX90 = RotateX(90.0);
+	constexpr quat quatRotateX90 = QuatRotateX(90.0);
+
+	mat4 Out[NumObjects];
+
+	const int NumMatrices = 1024;
+
+	mat4 A[NumMatrices], B[NumMatrices], C[NumMatrices];
+	affine3x4 AffA[NumMatrices], AffB[NumMatrices], AffC[NumMatrices];
+
+	// 随机的仿射矩阵(旋转 * 缩放 + 平移)
+	mat4 RandomAffine()
+	{
+		return Translate(BenchRandom(), BenchRandom(), BenchRandom())
+			* Rotate(BenchRandom() * 180.0f, BenchRandom(), BenchRandom(), BenchRandom())
+			* Scale(1.5f + BenchRandom(), 1.5f + BenchRandom(), 1.5f + BenchRandom());
+	}
+
+	GLfloat MaxDiff(const mat4& a, const mat4& b)
+	{
+		GLfloat diff = 0.0f;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				diff = std::fmax(diff, std::fabs(a[i][j] - b[i][j]));
+			}
+		}
+		return diff;
+	}
+
+	// 与原来 Solar.cpp 的 Animate 相同：矩阵栈 + mat4 运算符
+	void SolarFrameMat(const mat4& proj, float day, float hour)
+	{
+		static MatrixStack mvStack;
+		mat4 mv;
+		mv *= Translate(0.0, 0.0, -15.0);
+		mv *= Rotate(15.0, 1.0, 0.0, 0.0);
+
+		mvStack.push(mv);
+		mv *= matRotateX90;
+		Out[0] = proj * mv * Scale(0.8, 0.8, 0.8);
+		mv = mvStack.pop();
+
+		mvStack.push(mv);
+		mv *= matRotateX90;
+		Out[1] = proj * mv * Scale(4, 4, 4);
+		mv = mvStack.pop();
+
+		float yearAngle = 360.0 * day / 365.0;
+		mv *= Rotate(yearAngle, 0.0, 1.0, 0.0);
+		mv *= Translate(4.0, 0.0, 0.0);
+		quat qAxis = QuatRotateY(-yearAngle) * QuatRotateZ(-23.44);
+		quat qSpin = QuatRotateY(360.0 * hour / 24.0);
+
+		mvStack.push(mv);
+		mv *= Rotate(qAxis * qSpin * quatRotateX90);
+		Out[2] = proj * mv * Scale(0.4, 0.4, 0.4);
+		mv = mvStack.pop();
+
+		mvStack.push(mv);
+		mv *= Rotate(qAxis * quatRotateX90);
+		Out[3] = proj * mv * Scale(0.5, 0.5, 0.5);
+		mv = mvStack.pop();
+
+		mvStack.push(mv);
+		mv *= Transform(dualquat(qAxis * qSpin) * dualquat(quatRotateX90, vec3(0.5, 0.0, 0.0)));
+		Out[4] = proj * mv * Scale(0.05, 0.05, 0.05);
+		mv = mvStack.pop();
+
+		mvStack.push(mv);
+		mv *= matRotateX90;
+		Out[5] = proj * mv * Scale(0.7, 0.7, 0.7);
+		mv = mvStack.pop();
+
+		mv *= Rotate(360.0 * 12.0 * day / 365.0, 0.0, 1.0, 0.0);
+		mv *= Translate(0.7, 0.0, 0.0);
+		mv *= Scale(0.1, 0.1, 0.1);
+		mv *= matRotateX90;
+		Out[6] = proj * mv;
+	}
+
+	// 与现在 Solar.cpp 的 Animate 相同：TransformChain，复制保存状态
+	void SolarFrameChain(const mat4& proj, float day, float hour)
+	{
+		TransformChain mv;
+		mv.translate(0.0, 0.0, -15.0);
+		mv.rotateX(15.0);
+
+		TransformChain m;
+		m = mv;
+		Out[0] = proj * m.rotateX90().scale(0.8);
+
+		m = mv;
+		Out[1] = proj * m.rotateX90().scale(4.0);
+
+		float yearAngle = 360.0 * day / 365.0;
+		mv.rotateY(yearAngle).translate(4.0, 0.0, 0.0);
+		quat qAxis = QuatRotateY(-yearAngle) * QuatRotateZ(-23.44);
+		quat qSpin = QuatRotateY(360.0 * hour / 24.0);
+
+		m = mv;
+		m *= Rotate(qAxis * qSpin * quatRotateX90);
+		Out[2] = proj * m.scale(0.4);
+
+		m = mv;
+		m *= Rotate(qAxis * quatRotateX90);
+		Out[3] = proj * m.scale(0.5);
+
+		m = mv;
+		m *= Transform(dualquat(qAxis * qSpin) * dualquat(quatRotateX90, vec3(0.5, 0.0, 0.0)));
+		Out[4] = proj * m.scale(0.05);
+
+		m = mv;
+		Out[5] = proj * m.rotateX90().scale(0.7);
+
+		mv.rotateY(360.0 * 12.0 * day / 365.0);
+		mv.translate(0.7, 0.0, 0.0);
+		mv.scale(0.1);
+		mv.rotateX90();
+		Out[6] = proj * mv;
+	}
+}
+
+void BenchChain()
+{
+	mat4 proj = Perspective(45.0, 1.0, 1.0, 100.0);
+	mat4 reference[NumObjects];
+
+	/*正确性检查*/
+	SolarFrameMat(proj, 100.0f, 7.0f);
+	for (int i = 0; i < NumObjects; i++)
+	{
+		reference[i] = Out[i];
+	}
+	SolarFrameChain(proj, 100.0f, 7.0f);
+	GLfloat diff = 0.0f;
+	for (int k = 0; k < NumObjects; k++)
+	{
+		diff = std::fmax(diff, MaxDiff(Out[k], reference[k]));
+	}
+
+	BenchTitle("Solar hierarchy, one frame (7 MVP matrices)");
+	printf("  %-40s %12g\n", "max |mat4 chain - TransformChain|", diff);
+
+	double matChain = BenchRun("mat4 operators + MatrixStack", 100000, [proj] {
+		SolarFrameMat(proj, 100.0f, 7.0f);
+		BenchSink = BenchSink + Out[NumObjects - 1][0][0];
+	});
+	double lazyChain = BenchRun("TransformChain", 100000, [proj] {
+		SolarFrameChain(proj, 100.0f, 7.0f);
+		BenchSink = BenchSink + Out[NumObjects - 1][0][0];
+	});
+	BenchSpeedup(matChain, lazyChain);
+
+	for (int i = 0; i < NumMatrices; i++)
+	{
+		A[i] = RandomAffine();
+		B[i] = RandomAffine();
+		AffA[i] = affine3x4(A[i]);
+		AffB[i] = affine3x4(B[i]);
+	}
+
+	BenchTitle("affine matrix multiply / inverse");
+	diff = 0.0f;
+	GLfloat invDiff = 0.0f;
+	for (int i = 0; i < NumMatrices; i++)
+	{
+		diff = std::fmax(diff, MaxDiff(A[i] * B[i], AffA[i] * AffB[i]));
+		invDiff = std::fmax(invDiff, MaxDiff(inverse(A[i]), inverse(AffA[i])));
+	}
+	printf("  %-40s %12g\n", "max |mat4 - affine3x4| multiply", diff);
+	printf("  %-40s %12g\n", "max |mat4 - affine3x4| inverse", invDiff);
+
+	double mat = BenchRun("mat4 * mat4 (1024 multiplies)", 1000, [] {
+		for (int i = 0; i < NumMatrices; i++)
+		{
+			C[i] = A[i] * B[i];
+		}
+		BenchSink = BenchSink + C[NumMatrices - 1][0][0];
+	});
+	double affine = BenchRun("affine3x4 * affine3x4 (1024 multiplies)", 1000, [] {
+		for (int i = 0; i < NumMatrices; i++)
+		{
+			AffC[i] = AffA[i] * AffB[i];
+		}
+		BenchSink = BenchSink + AffC[NumMatrices - 1][0][0];
+	});
+	BenchSpeedup(mat, affine);
+
+	mat = BenchRun("inverse(mat4) (1024 matrices)", 1000, [] {
+		for (int i = 0; i < NumMatrices; i++)
+		{
+			C[i] = inverse(A[i]);
+		}
+		BenchSink = BenchSink + C[NumMatrices - 1][0][0];
+	});
+	affine = BenchRun("inverse(affine3x4) (1024 matrices)", 1000, [] {
+		for (int i = 0; i < NumMatrices; i++)
+		{
+			AffC[i] = inverse(AffA[i]);
+		}
+		BenchSink = BenchSink + AffC[NumMatrices - 1][0][0];
+	});
+	BenchSpeedup(mat, affine);
+}
@@ -0,0 +1,218 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	mat4 乘法测试：原来的三重循环(baseline)、展开的标量实现、SIMD 实现(mat.h 中按编译目标选择) 对比
+//------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+
+namespace
+{
+	const int NumMatrices = 1024;
+
+	constexpr mat4 matRotateX90 = RotateX(90.0);
+	constexpr quat quatRotateX90 = QuatRotateX(90.0);
+
+	mat4 A[NumMatrices];
+	mat4 B[NumMatrices];
+	mat4 C[NumMatrices];
+	vec4 V[NumMatrices];
+	vec4 R[NumMatrices];
+
+	mat4 RandomMatrix()
+	{
+		mat4 m;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				m[i][j] = BenchRandom();
+			}
+		}
+		return m;
+	}
+
+	// 原来 mat4::operator * 的实现：清零后三重循环累加
+	mat4 MulBaseline(const mat4& a, const mat4& b)
+	{
+		mat4 c(0.0);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				for (int k = 0; k < 4; ++k)
+				{
+					c[i][j] += a[i][k] * b[k][j];
+				}
+			}
+		}
+
+		return c;
+	}
+
+	// 用展开的标量内核计算 a * b(没有 SIMD 时 operator * 使用的实现)
+	mat4 MulScalar(const mat4& a, const mat4& b)
+	{
+		mat4 c;
+		detail::mat4MulScalar(a, b, c);
+		return c;
+	}
+
+	// Solar.cpp 中绘制地球同步卫星时的变换链，矩阵乘法为 Mul
+	template <mat4 (*Mul)(const mat4&, const mat4&)>
+	mat4 SolarChainWith(const mat4& proj, float day, float hour)
+	{
+		mat4 mv = Translate(0.0, 0.0, -15.0);
+		mv = Mul(mv, Rotate(15.0, 1.0, 0.0, 0.0));
+		mv = Mul(mv, Rotate(360.0 * day / 365.0, 0.0, 1.0, 0.0));
+		mv = Mul(mv, Translate(4.0, 0.0, 0.0));
+		mv = Mul(mv, Rotate(-360.0 * day / 365.0, 0.0, 1.0, 0.0));
+		mv = Mul(mv, Rotate(-23.44, 0.0, 0.0, 1.0));
+		mv = Mul(mv, Rotate(360.0 * hour / 24.0, 0.0, 1.0, 0.0));
+		mv = Mul(mv, Translate(0.5, 0.0, 0.0));
+		mv = Mul(mv, matRotateX90);
+		return Mul(Mul(proj, mv), Scale(0.05, 0.05, 0.05));
+	}
+
+	// 同一变换链，使用 mat4 的运算符(SIMD)
+	mat4 SolarChain(const mat4& proj, float day, float hour)
+	{
+		mat4 mv = Translate(0.0, 0.0, -15.0);
+		mv *= Rotate(15.0, 1.0, 0.0, 0.0);
+		mv *= Rotate(360.0 * day / 365.0, 0.0, 1.0, 0.0);
+		mv *= Translate(4.0, 0.0, 0.0);
+		mv *= Rotate(-360.0 * day / 365.0, 0.0, 1.0, 0.0);
+		mv *= Rotate(-23.44, 0.0, 0.0, 1.0);
+		mv *= Rotate(360.0 * hour / 24.0, 0.0, 1.0, 0.0);
+		mv *= Translate(0.5, 0.0, 0.0);
+		mv *= matRotateX90;
+		return proj * mv * Scale(0.05, 0.05, 0.05);
+	}
+
+	// 同一变换链，地球系统中的旋转用四元数/对偶四元数组合(与 Solar.cpp 一致)
+	mat4 SolarChainQuat(const mat4& proj, float day, float hour)
+	{
+		mat4 mv = Translate(0.0, 0.0, -15.0);
+		mv *= Rotate(15.0, 1.0, 0.0, 0.0);
+		mv *= Rotate(360.0 * day / 365.0, 0.0, 1.0, 0.0);
+		mv *= Translate(4.0, 0.0, 0.0);
+		quat qAxis = QuatRotateY(-360.0 * day / 365.0) * QuatRotateZ(-23.44);
+		quat qSpin = QuatRotateY(360.0 * hour / 24.0);
+		mv *= Transform(dualquat(qAxis * qSpin) * dualquat(quatRotateX90, vec3(0.5, 0.0, 0.0)));
+		return proj * mv * Scale(0.05, 0.05, 0.05);
+	}
+
+	GLfloat MaxDiff(const mat4& a, const mat4& b)
+	{
+		GLfloat diff = 0.0f;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				diff = std::fmax(diff, std::fabs(a[i][j] - b[i][j]));
+			}
+		}
+		return diff;
+	}
+}
+
+void BenchMat()
+{
+	for (int i = 0; i < NumMatrices; i++)
+	{
+		A[i] = RandomMatrix();
+		B[i] = RandomMatrix();
+		V[i] = vec4(BenchRandom(), BenchRandom(), BenchRandom(), 1.0f);
+	}
+
+	/*正确性检查*/
+	GLfloat diff = 0.0f;
+	for (int i = 0; i < NumMatrices; i++)
+	{
+		diff = std::fmax(diff, MaxDiff(MulBaseline(A[i], B[i]), A[i] * B[i]));
+	}
+	BenchTitle("mat4 * mat4");
+	printf("  %-40s %12g\n", "max |baseline - simd|", diff);
+
+	double baseline = BenchRun("baseline triple loop (1024 multiplies)", 1000, [] {
+		for (int i = 0; i < NumMatrices; i++)
+		{
+			C[i] = MulBaseline(A[i], B[i]);
+		}
+		BenchSink = BenchSink + C[NumMatrices - 1][0][0];
+	});
+
+	double scalar = BenchRun("unrolled scalar (1024 multiplies)", 1000, [] {
+		for (int i = 0; i < NumMatrices; i++)
+		{
+			detail::mat4MulScalar(A[i], B[i], C[i]);
+		}
+		BenchSink = BenchSink + C[NumMatrices - 1][0][0];
+	});
+	BenchSpeedup(baseline, scalar);
+
+	double simd = BenchRun("operator * (1024 multiplies)", 1000, [] {
+		for (int i = 0; i < NumMatrices; i++)
+		{
+			C[i] = A[i] * B[i];
+		}
+		BenchSink = BenchSink + C[NumMatrices - 1][0][0];
+	});
+	BenchSpeedup(baseline, simd);
+
+	BenchRun("operator *= (1024 multiplies)", 1000, [] {
+		for (int i = 0; i < NumMatrices; i++)
+		{
+			C[i] = A[i];
+			C[i] *= B[i];
+		}
+		BenchSink = BenchSink + C[NumMatrices - 1][0][0];
+	});
+
+	BenchTitle("mat4 * vec4");
+	scalar = BenchRun("scalar (1024 vectors)", 1000, [] {
+		for (int i = 0; i < NumMatrices; i++)
+		{
+			detail::mat4MulVec4Scalar(A[i], V[i], R[i]);
+		}
+		BenchSink = BenchSink + R[NumMatrices - 1].x;
+	});
+
+	simd = BenchRun("operator * (1024 vectors)", 1000, [] {
+		for (int i = 0; i < NumMatrices; i++)
+		{
+			R[i] = A[i] * V[i];
+		}
+		BenchSink = BenchSink + R[NumMatrices - 1].x;
+	});
+	BenchSpeedup(scalar, simd);
+
+	BenchTitle("Solar satellite transform chain");
+	mat4 proj = Perspective(30.0, 900.0 / 540.0, 1.0, 30.0);
+	printf("  %-40s %12g\n", "max |baseline - simd|",
+		MaxDiff(SolarChainWith<MulBaseline>(proj, 100.0f, 7.0f), SolarChain(proj, 100.0f, 7.0f)));
+
+	baseline = BenchRun("baseline triple loop chain", 100000, [proj] {
+		BenchSink = BenchSink + SolarChainWith<MulBaseline>(proj, 100.0f, 7.0f)[0][0];
+	});
+	scalar = BenchRun("unrolled scalar chain", 100000, [proj] {
+		BenchSink = BenchSink + SolarChainWith<MulScalar>(proj, 100.0f, 7.0f)[0][0];
+	});
+	BenchSpeedup(baseline, scalar);
+	simd = BenchRun("operator chain", 100000, [proj] {
+		BenchSink = BenchSink + SolarChain(proj, 100.0f, 7.0f)[0][0];
+	});
+	BenchSpeedup(baseline, simd);
+
+	printf("  %-40s %12g\n", "max |matrix - quat|",
+		MaxDiff(SolarChain(proj, 100.0f, 7.0f), SolarChainQuat(proj, 100.0f, 7.0f)));
+	double quatChain = BenchRun("quat / dualquat chain", 100000, [proj] {
+		BenchSink = BenchSink + SolarChainQuat(proj, 100.0f, 7.0f)[0][0];
+	});
+	BenchSpeedup(simd, quatChain);
+}
@@ -0,0 +1,66 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	索引网格测试：展开的三角形(glDrawArrays) 与 索引网格(glDrawElements) 对比
+//	顶点数、上传的字节数(位置按 snorm16x4 计)，以及每帧需要变换的顶点数对应的变换耗时
+//------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+
+namespace
+{
+	// 按索引展开成原来 BuildSphere 生成的三角形数组
+	std::vector<vec3> ExpandMesh(const IndexedMesh& mesh)
+	{
+		std::vector<vec3> soup(mesh.indices.size());
+		for (size_t i = 0; i < soup.size(); i++)
+		{
+			soup[i] = mesh.vertices[mesh.indices[i]];
+		}
+		return soup;
+	}
+
+	void BenchSphere(GLsizei size, int iterations)
+	{
+		char title[64];
+		snprintf(title, sizeof(title), "sphere %d x %d", size, size);
+		BenchTitle(title);
+
+		IndexedMesh mesh = BuildSphereMesh(1.0f, size, size);
+		std::vector<vec3> soup = ExpandMesh(mesh);
+		size_t indexSize = mesh.vertices.size() <= 65536 ? sizeof(GLushort) : sizeof(GLuint);
+		size_t soupBytes = soup.size() * sizeof(snorm16x4);
+		size_t meshBytes = mesh.vertices.size() * sizeof(snorm16x4) + mesh.indices.size() * indexSize;
+
+		printf("  %-40s %12zu\n", "vertices (triangle soup)", soup.size());
+		printf("  %-40s %12zu\n", "vertices (indexed)", mesh.vertices.size());
+		printf("  %-40s %12zu\n", "indices", mesh.indices.size());
+		printf("  %-40s %12zu\n", "bytes (triangle soup)", soupBytes);
+		printf("  %-40s %12zu\n", "bytes (indexed)", meshBytes);
+
+		// 每个顶点只变换一次(相当于顶点着色器的执行次数上限)
+		mat4 m = Perspective(45.0f, 1.0f, 1.0f, 100.0f) * Translate(0.0f, 0.0f, -5.0f) * RotateX(30.0f);
+		std::vector<vec3> out(soup.size());
+
+		double before = BenchRun("transform soup vertices", iterations, [&] {
+			TransformPoints(m, soup.data(), out.data(), soup.size());
+			BenchSink = BenchSink + out.back().x;
+		});
+		double after = BenchRun("transform indexed vertices", iterations, [&] {
+			TransformPoints(m, mesh.vertices.data(), out.data(), mesh.vertices.size());
+			BenchSink = BenchSink + out.back().x;
+		});
+		BenchSpeedup(before, after);
+	}
+}
+
+void BenchMesh()
+{
+	BenchSphere(15, 10000);
+	BenchSphere(256, 100);
+	BenchSphere(1024, 10);
+}
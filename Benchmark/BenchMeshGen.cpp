@@ -0,0 +1,140 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	高精度球和圆环的生成：串行与按行并行对比(256 x 256 到 8192 x 8192)
+//	并行结果按字节与串行结果比较(散列值)，必须完全相同
+//	8192 x 8192 的网格约占 3.2 GB 内存，每次只保留一个网格
+//	最后对比 UploadMesh 的 CPU 路径(IndexedMesh + 压缩拷贝)与 EmitMesh 的直接写入：
+//	用普通数组代替映射的缓冲区，只测 CPU 时间和内存峰值
+//------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+
+namespace
+{
+	// FNV-1a 散列
+	template <typename T>
+	unsigned long long Hash(const std::vector<T>& data, unsigned long long h)
+	{
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data());
+		for (size_t i = 0; i < data.size() * sizeof(T); i++)
+		{
+			h = (h ^ p[i]) * 1099511628211ull;
+		}
+		return h;
+	}
+
+	unsigned long long Hash(const IndexedMesh& mesh)
+	{
+		unsigned long long h = 14695981039346656037ull;
+		h = Hash(mesh.vertices, h);
+		h = Hash(mesh.normals, h);
+		return Hash(mesh.indices, h);
+	}
+
+	template <typename Build>
+	void BenchMeshGen(const char* shape, GLsizei size, Build build)
+	{
+		char title[64];
+		snprintf(title, sizeof(title), "%s %d x %d", shape, size, size);
+		BenchTitle(title);
+
+		const size_t serial = ~size_t(0);
+		int iterations = size >= 4096 ? 1 : (size >= 1024 ? 3 : 20);
+
+		unsigned long long serialHash = Hash(build(size, serial));
+		unsigned long long parallelHash = Hash(build(size, BatchParallelThreshold));
+		printf("  %-40s %12s\n", "parallel == serial", serialHash == parallelHash ? "yes" : "NO");
+
+		double before = BenchRun("serial", iterations, [&] {
+			BenchSink = BenchSink + build(size, serial).vertices.back().x;
+		});
+		double after = BenchRun("parallel rows", iterations, [&] {
+			BenchSink = BenchSink + build(size, BatchParallelThreshold).vertices.back().x;
+		});
+		BenchSpeedup(before, after);
+	}
+
+	// 压缩后的 GPU 数据，代替映射的缓冲区
+	struct PackedMesh
+	{
+		std::vector<snorm16x4> positions;
+		std::vector<snorm16x2> normals;
+		std::vector<GLuint> indices;
+	};
+
+	// UploadMesh 的路径：先生成 vec3 数组，再压缩拷贝
+	PackedMesh BuildAndPack(const SphereGenerator& generator)
+	{
+		IndexedMesh mesh = BuildMesh(generator);
+		PackedMesh packed;
+		packed.positions = PackArray<snorm16x4>(make_span(mesh.vertices));
+		packed.normals = PackNormals(make_span(mesh.normals));
+		packed.indices = std::move(mesh.indices);
+		return packed;
+	}
+
+	// EmitMesh 的路径：生成器直接写压缩格式
+	PackedMesh Emit(const SphereGenerator& generator)
+	{
+		MeshLayout layout = generator.layout();
+		PackedMesh packed;
+		packed.positions.resize(layout.vertexCount);
+		packed.normals.resize(layout.vertexCount);
+		packed.indices.resize(layout.indexCount);
+
+		MeshEmitter<snorm16x4, snorm16x2, GLuint> out;
+		out.positions = make_span(packed.positions);
+		out.normals = make_span(packed.normals);
+		out.indices = make_span(packed.indices);
+		out.mapped = true;
+		generator.emit(out, BatchParallelThreshold);
+		return packed;
+	}
+
+	bool Equal(const PackedMesh& a, const PackedMesh& b)
+	{
+		return a.positions.size() == b.positions.size() && a.indices == b.indices &&
+			memcmp(a.positions.data(), b.positions.data(), a.positions.size() * sizeof(snorm16x4)) == 0 &&
+			memcmp(a.normals.data(), b.normals.data(), a.normals.size() * sizeof(snorm16x2)) == 0;
+	}
+}
+
+void BenchMeshGen()
+{
+	printf("\nthreads: %u\n", std::thread::hardware_concurrency());
+
+	for (GLsizei size = 256; size <= 8192; size *= 2)
+	{
+		BenchMeshGen("sphere", size, [](GLsizei n, size_t threshold) {
+			return BuildSphereMesh(1.0f, n, n, threshold);
+		});
+		BenchMeshGen("torus", size, [](GLsizei n, size_t threshold) {
+			return BuildTorusMesh(0.35f, 0.15f, n, n, threshold);
+		});
+	}
+
+	const GLsizei size = 2048;
+	SphereGenerator generator = { 1.0f, size, size };
+	MeshLayout layout = generator.layout();
+	size_t packedBytes = layout.vertexCount * (sizeof(snorm16x4) + sizeof(snorm16x2)) + layout.indexCount * sizeof(GLuint);
+	size_t meshBytes = layout.vertexCount * 2 * sizeof(vec3) + layout.indexCount * sizeof(GLuint);
+
+	BenchTitle("sphere 2048 x 2048: build + pack vs emit packed");
+	printf("  %-40s %12s\n", "emit == build + pack", Equal(BuildAndPack(generator), Emit(generator)) ? "yes" : "NO");
+	// build + pack 时 IndexedMesh 与压缩数组同时存在(索引数组移交，不计两次)
+	printf("  %-40s %12.1f\n", "peak MB build + pack", (meshBytes + packedBytes - layout.indexCount * sizeof(GLuint)) / 1048576.0);
+	printf("  %-40s %12.1f\n", "peak MB emit", packedBytes / 1048576.0);
+
+	double before = BenchRun("build + pack", 3, [&] {
+		BenchSink = BenchSink + BuildAndPack(generator).positions.back().x;
+	});
+	double after = BenchRun("emit packed", 3, [&] {
+		BenchSink = BenchSink + Emit(generator).positions.back().x;
+	});
+	BenchSpeedup(before, after);
+}
@@ -0,0 +1,108 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	索引重排测试：生成器的原始顺序、Tipsify 后、再按簇排序(过度绘制优化)后的
+//	ACMR / ATVR(模拟 16 项 FIFO 顶点缓存)，以及 OptimizeMesh 的耗时
+//------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <assert.h>
+
+namespace
+{
+	void PrintStats(const char* name, const IndexedMesh& mesh)
+	{
+		VertexCacheStats stats = AnalyzeVertexCache(make_span(mesh.indices), mesh.vertices.size());
+		printf("  %-40s %12.3f %8.3f\n", name, stats.acmr, stats.atvr);
+	}
+
+	// 按 x、y、z 比较顶点位置
+	bool PositionLess(const vec3& a, const vec3& b)
+	{
+		return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+	}
+
+	bool TriangleLess(const std::array<vec3, 3>& a, const std::array<vec3, 3>& b)
+	{
+		return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), PositionLess);
+	}
+
+	// 按顶点位置排序的三角形列表：每个三角形旋转到最小的顶点在前(不改变绕向)，再整体排序，
+	// 重排三角形和顶点前后的列表应当相同
+	std::vector<std::array<vec3, 3>> Triangles(const IndexedMesh& mesh)
+	{
+		std::vector<std::array<vec3, 3>> triangles(mesh.indices.size() / 3);
+		for (size_t t = 0; t < triangles.size(); t++)
+		{
+			const GLuint* tri = &mesh.indices[t * 3];
+			int first = 0;
+			for (int k = 1; k < 3; k++)
+			{
+				if (PositionLess(mesh.vertices[tri[k]], mesh.vertices[tri[first]]))
+				{
+					first = k;
+				}
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				triangles[t][k] = mesh.vertices[tri[(first + k) % 3]];
+			}
+		}
+		std::sort(triangles.begin(), triangles.end(), TriangleLess);
+		return triangles;
+	}
+
+	bool SameTriangles(const std::vector<std::array<vec3, 3>>& triangles, const IndexedMesh& mesh)
+	{
+		std::vector<std::array<vec3, 3>> other = Triangles(mesh);
+		return triangles.size() == other.size() && std::equal(triangles.begin(), triangles.end(), other.begin(),
+			[](const std::array<vec3, 3>& a, const std::array<vec3, 3>& b) { return !TriangleLess(a, b) && !TriangleLess(b, a); });
+	}
+
+	template <typename Build>
+	void BenchMeshOpt(const char* title, int iterations, Build build)
+	{
+		BenchTitle(title);
+		IndexedMesh original = build();
+		printf("  %-40s %12zu %8zu\n", "vertices / triangles", original.vertices.size(), original.indices.size() / 3);
+		printf("  %-40s %12s %8s\n", "", "ACMR", "ATVR");
+		PrintStats("generator order", original);
+
+		IndexedMesh tipsify = original;
+		tipsify.indices = OptimizeVertexCache(make_span(original.indices), original.vertices.size());
+		PrintStats("vertex cache (Tipsify)", tipsify);
+
+		IndexedMesh optimized = original;
+		OptimizeMesh(optimized);
+		PrintStats("vertex cache + overdraw + fetch", optimized);
+
+		// 重排只能改变三角形和顶点的顺序，不能丢失、重复或改变三角形
+		std::vector<std::array<vec3, 3>> triangles = Triangles(original);
+		bool same = SameTriangles(triangles, tipsify) && SameTriangles(triangles, optimized);
+		printf("  %-40s %12s\n", "same triangles as generator order", same ? "yes" : "NO");
+		assert(same);
+
+		BenchRun("OptimizeMesh", iterations, [&] {
+			IndexedMesh mesh = original;
+			OptimizeMesh(mesh);
+			BenchSink = BenchSink + (GLfloat)mesh.indices.back();
+		});
+	}
+}
+
+void BenchMeshOpt()
+{
+	BenchMeshOpt("sphere 15 x 15", 1000, [] { return BuildSphereMesh(1.0f, 15, 15); });
+	BenchMeshOpt("sphere 256 x 256", 10, [] { return BuildSphereMesh(1.0f, 256, 256); });
+	BenchMeshOpt("torus 40 x 20", 1000, [] { return BuildTorusMesh(0.35f, 0.15f, 40, 20); });
+	BenchMeshOpt("torus 1024 x 512", 5, [] { return BuildTorusMesh(0.35f, 0.15f, 1024, 512); });
+	BenchMeshOpt("ground 40 x 40", 1000, [] { return BuildGroundMesh(20.0f, 1.0f); });
+	BenchMeshOpt("ground 512 x 512", 10, [] { return BuildGroundMesh(256.0f, 1.0f); });
+}
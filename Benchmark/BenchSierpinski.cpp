@@ -0,0 +1,157 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	Sierpinski 四面体：每个细分次数的生成时间和内存占用
+//	GPU 为上传后的大小(snorm16x4 位置，顶点数不超过 65536 时用 16 位索引，否则 32 位)，
+//	soup 为原来展开为三角形的大小(每个顶点 vec3 位置 + vec3 颜色，共 24 字节)，
+//	instanced 为实例化绘制时的大小(每个小四面体的格点原点 8 字节)
+//	据此可以选出一台机器能放下的最大细分次数
+//	并行伸缩性：细分 8 - 11 次，1 到 N 个线程，结果必须与逐个细分的串行实现完全相同
+//------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+
+namespace
+{
+	const vec3 Corners[4] =
+	{
+		vec3(0.0, 0.0, -1.0),
+		vec3(0.0, 0.942809, 0.333333),
+		vec3(-0.816497, -0.471405, 0.333333),
+		vec3(0.816497, -0.471405, 0.333333)
+	};
+
+	const int MaxDepth = 11;
+
+	// 逐个小四面体细分的串行实现(并行子树之前的 BuildSierpinskiMesh)，作为正确性检查的参照：
+	// 按 DivideTetra 的顺序访问小四面体，顶点按第一次出现的顺序编号
+	IndexedMesh BuildSierpinskiSerial(const vec3 corners[4], int depth)
+	{
+		IndexedMesh mesh;
+		size_t tetrahedra = (size_t)1 << (2 * depth);
+		size_t faceLength = tetrahedra * 3;
+		GLuint size = 1u << depth;
+		mesh.vertices.reserve(2 * tetrahedra + 2);
+		mesh.indices.resize(faceLength * 4);
+
+		vec3 origin = corners[0];
+		vec3 du = (corners[1] - corners[0]) / (GLfloat)size;
+		vec3 dv = (corners[2] - corners[0]) / (GLfloat)size;
+		vec3 dw = (corners[3] - corners[0]) / (GLfloat)size;
+
+		detail::LatticeVertexMap map(2 * tetrahedra + 2);
+		GLuint* out = mesh.indices.data();
+
+		auto vertex = [&](GLuint i, GLuint j, GLuint k) -> GLuint {
+			GLuint next = (GLuint)mesh.vertices.size();
+			GLuint index = map.insert(detail::LatticeVertexMap::Key(i, j, k), next);
+			if (index == next)
+			{
+				mesh.vertices.push_back(origin + du * (GLfloat)i + dv * (GLfloat)j + dw * (GLfloat)k);
+			}
+			return index;
+		};
+
+		auto emit = [&](GLuint i, GLuint j, GLuint k) {
+			GLuint a = vertex(i, j, k);
+			GLuint b = vertex(i + 1, j, k);
+			GLuint c = vertex(i, j + 1, k);
+			GLuint d = vertex(i, j, k + 1);
+
+			out[0] = a; out[1] = b; out[2] = c;
+			out[faceLength] = a; out[faceLength + 1] = c; out[faceLength + 2] = d;
+			out[faceLength * 2] = a; out[faceLength * 2 + 1] = d; out[faceLength * 2 + 2] = b;
+			out[faceLength * 3] = b; out[faceLength * 3 + 1] = d; out[faceLength * 3 + 2] = c;
+			out += 3;
+		};
+		detail::DivideTetra(0, 0, 0, size, emit);
+
+		return mesh;
+	}
+
+	bool Identical(const IndexedMesh& a, const IndexedMesh& b)
+	{
+		return a.indices == b.indices && a.vertices.size() == b.vertices.size()
+			&& std::equal(a.vertices.begin(), a.vertices.end(), b.vertices.begin(),
+				[](const vec3& u, const vec3& v) { return u.x == v.x && u.y == v.y && u.z == v.z; });
+	}
+
+	double BuildMs(int depth, int iterations, IndexedMesh& mesh)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			mesh = BuildSierpinskiMesh(Corners, depth, 0);
+		}
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+	}
+}
+
+void BenchSierpinski()
+{
+	BenchTitle("Sierpinski tetrahedron, depth 0 - 11");
+	printf("  %5s %10s %10s %9s %9s %9s %9s %10s %10s\n",
+		"depth", "vertices", "indices", "CPU MB", "GPU MB", "soup MB", "inst MB", "build ms", "inst ms");
+
+	for (int depth = 0; depth <= MaxDepth; depth++)
+	{
+		size_t tetrahedra = (size_t)1 << (2 * depth);
+		int iterations = depth >= 9 ? 1 : (depth >= 6 ? 5 : 100);
+
+		IndexedMesh mesh;
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			mesh = BuildSierpinskiMesh(Corners, depth);
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+		std::vector<GLushort> offsets;
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			offsets = BuildSierpinskiOffsets(depth);
+		}
+		double instancedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+		size_t cpuBytes = mesh.vertices.size() * sizeof(vec3) + mesh.indices.size() * sizeof(GLuint);
+		size_t gpuBytes = mesh.vertices.size() * sizeof(snorm16x4) + mesh.indices.size() *
+			(mesh.vertices.size() <= 65536 ? sizeof(GLushort) : sizeof(GLuint));
+		size_t soupBytes = tetrahedra * 12 * (sizeof(vec3) + sizeof(vec3));
+		size_t instancedBytes = offsets.size() * sizeof(GLushort);
+		printf("  %5d %10zu %10zu %9.2f %9.2f %9.2f %9.2f %10.3f %10.3f\n", depth, mesh.vertices.size(), mesh.indices.size(),
+			cpuBytes / 1048576.0, gpuBytes / 1048576.0, soupBytes / 1048576.0, instancedBytes / 1048576.0, ms, instancedMs);
+		BenchSink = BenchSink + mesh.vertices.back().x + offsets.back();
+	}
+
+	BenchTitle("Sierpinski subdivision scaling, depth 8 - 11");
+	unsigned maxThreads = std::thread::hardware_concurrency();
+	printf("  %5s %8s %12s %10s %10s\n", "depth", "threads", "build ms", "speedup", "identical");
+
+	for (int depth = 8; depth <= MaxDepth; depth++)
+	{
+		int iterations = depth >= 10 ? 1 : 5;
+
+		// 每一行(包括 1 个线程)都与串行实现比较，单核机器上也能检查子树算法本身
+		IndexedMesh reference = BuildSierpinskiSerial(Corners, depth);
+
+		SetParallelThreads(1);
+		IndexedMesh mesh;
+		double serial = BuildMs(depth, iterations, mesh);
+		printf("  %5d %8u %12.3f %9.2fx %10s\n", depth, 1u, serial, 1.0, Identical(mesh, reference) ? "yes" : "NO");
+
+		// 2, 4, 8 ... 个线程，最后一项为 CPU 核数
+		for (unsigned threads = 2; threads < maxThreads * 2; threads *= 2)
+		{
+			threads = std::min(threads, maxThreads);
+			SetParallelThreads(threads);
+			double ms = BuildMs(depth, iterations, mesh);
+			printf("  %5d %8u %12.3f %9.2fx %10s\n", depth, threads, ms, serial / ms, Identical(mesh, reference) ? "yes" : "NO");
+		}
+	}
+	SetParallelThreads(0);
+}
@@ -0,0 +1,157 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	4097 x 4097 地形：高度场生成、每帧的块选择、绘制的顶点数与全分辨率对比
+//	接缝检查：相邻块的 LOD 最多差一级，且较细的块在该边上设置了接缝标志；
+//	          相邻块共享边上的顶点解码为世界坐标后完全相同
+//------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+
+namespace
+{
+	const GLfloat ViewDistance = 600.0f;
+	const GLfloat LodDistance = 64.0f;
+	const size_t VertexBudget = 300000;
+
+	// 返回不满足接缝条件的边数
+	int SeamErrors(const std::vector<Terrain::Chunk>& chunks, int chunksPerSide)
+	{
+		std::vector<int> lods(chunksPerSide * chunksPerSide, -1);
+		for (const Terrain::Chunk& chunk : chunks)
+		{
+			lods[chunk.z * chunksPerSide + chunk.x] = chunk.lod;
+		}
+
+		static const int offsets[4][2] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+		static const int flags[4] = { TerrainEdgeNorth, TerrainEdgeEast, TerrainEdgeSouth, TerrainEdgeWest };
+		int errors = 0;
+		for (const Terrain::Chunk& chunk : chunks)
+		{
+			for (int e = 0; e < 4; e++)
+			{
+				int nx = chunk.x + offsets[e][0];
+				int nz = chunk.z + offsets[e][1];
+				if (nx < 0 || nz < 0 || nx >= chunksPerSide || nz >= chunksPerSide || lods[nz * chunksPerSide + nx] < 0)
+				{
+					continue;
+				}
+				int neighbor = lods[nz * chunksPerSide + nx];
+				if (std::abs(neighbor - chunk.lod) > 1 || (neighbor > chunk.lod) != ((chunk.edges & flags[e]) != 0))
+				{
+					errors++;
+				}
+			}
+		}
+		return errors;
+	}
+
+	// 生成所有块，解码共享边上的顶点(块原点 + 块内坐标)，返回两侧世界坐标不同的顶点数
+	size_t SeamGaps(const Terrain& terrain, GLfloat& maxGap)
+	{
+		const int n = terrain.chunksPerSide();
+		const int last = TerrainChunkQuads;
+		// 每块的东边(x = 64)和南边(z = 64)，与右边块的西边、下边块的北边比较
+		std::vector<vec3> east(n * n * TerrainChunkVerts), south(n * n * TerrainChunkVerts);
+		std::vector<vec3> positions(TerrainChunkVerts * TerrainChunkVerts);
+		std::vector<snorm16x2> normals(TerrainChunkVerts * TerrainChunkVerts);
+
+		size_t gaps = 0;
+		maxGap = 0.0f;
+		auto compare = [&](const vec3& a, const vec3& b) {
+			vec3 d = a - b;
+			GLfloat gap = std::fmax(std::fabs(d.x), std::fmax(std::fabs(d.y), std::fabs(d.z)));
+			if (gap != 0.0f)
+			{
+				gaps++;
+				maxGap = std::fmax(maxGap, gap);
+			}
+		};
+
+		for (int cz = 0; cz < n; cz++)
+		{
+			for (int cx = 0; cx < n; cx++)
+			{
+				terrain.buildChunk(cx, cz, positions.data(), normals.data());
+				vec3 origin = terrain.chunkOrigin(cx, cz);
+				size_t chunk = (size_t)(cz * n + cx) * TerrainChunkVerts;
+				for (int i = 0; i < TerrainChunkVerts; i++)
+				{
+					vec3 west = origin + positions[i * TerrainChunkVerts];
+					vec3 north = origin + positions[i];
+					east[chunk + i] = origin + positions[i * TerrainChunkVerts + last];
+					south[chunk + i] = origin + positions[last * TerrainChunkVerts + i];
+					if (cx > 0)
+					{
+						compare(west, east[chunk - TerrainChunkVerts + i]);
+					}
+					if (cz > 0)
+					{
+						compare(north, south[chunk - (size_t)n * TerrainChunkVerts + i]);
+					}
+				}
+			}
+		}
+		return gaps;
+	}
+}
+
+void BenchTerrain()
+{
+	BenchTitle("terrain 4097 x 4097");
+
+	HeightMap map;
+	BenchRun("HeightMap::Fractal", 1, [&] {
+		map = HeightMap::Fractal(12, 1.0f, 200.0f);
+	});
+	Terrain terrain(map, ViewDistance, LodDistance, VertexBudget);
+
+	std::vector<vec3> positions(TerrainChunkVerts * TerrainChunkVerts);
+	std::vector<snorm16x2> normals(TerrainChunkVerts * TerrainChunkVerts);
+	BenchRun("build one chunk (65 x 65)", 100, [&] {
+		terrain.buildChunk(31, 31, positions.data(), normals.data());
+		BenchSink = BenchSink + normals.back().x;
+	});
+
+	// 沿对角线走过地形，统计每个位置选出的块
+	std::vector<Terrain::Chunk> chunks;
+	size_t maxVertices = 0, maxTriangles = 0, maxChunks = 0;
+	int seamErrors = 0;
+	for (GLfloat t = -2000.0f; t <= 2000.0f; t += 250.0f)
+	{
+		terrain.select(vec3(t, 0.0f, t * 0.5f), chunks);
+		size_t vertices = 0, triangles = 0;
+		for (const Terrain::Chunk& chunk : chunks)
+		{
+			size_t n = (TerrainChunkQuads >> chunk.lod) + 1;
+			vertices += n * n;
+			triangles += TerrainLodIndices(chunk.lod, chunk.edges).size() / 3;
+		}
+		maxVertices = std::max(maxVertices, vertices);
+		maxTriangles = std::max(maxTriangles, triangles);
+		maxChunks = std::max(maxChunks, chunks.size());
+		seamErrors += SeamErrors(chunks, terrain.chunksPerSide());
+	}
+
+	size_t fullVertices = map.size() * map.size();
+	printf("  %-40s %12zu\n", "max chunks per frame", maxChunks);
+	printf("  %-40s %12zu\n", "max vertices per frame", maxVertices);
+	printf("  %-40s %12zu\n", "max triangles per frame", maxTriangles);
+	printf("  %-40s %12zu\n", "full resolution vertices", fullVertices);
+	printf("  %-40s %12zu\n", "vertex budget", VertexBudget);
+	printf("  %-40s %12d\n", "seam errors", seamErrors);
+
+	GLfloat maxGap;
+	size_t gaps = SeamGaps(terrain, maxGap);
+	printf("  %-40s %12zu\n", "seam vertices with gaps", gaps);
+	printf("  %-40s %12g\n", "max seam gap (m)", maxGap);
+
+	BenchRun("Terrain::select", 100, [&] {
+		terrain.select(vec3(123.0f, 0.0f, -456.0f), chunks);
+		BenchSink = BenchSink + (GLfloat)chunks.size();
+	});
+}
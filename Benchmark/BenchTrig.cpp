@@ -0,0 +1,127 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	正弦/余弦测试：libm 与 trig.h 中的 SinCos(单个 / 批量 / 查表) 对比
+//------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+
+namespace
+{
+	const size_t NumAngles = 1 << 20;
+	const int SphereSize = 1024;	// 球的经线数和纬线数
+
+	std::vector<GLfloat> Angles(NumAngles);
+	std::vector<GLfloat> Sin(NumAngles), Cos(NumAngles);
+	std::vector<vec3> Vertices((SphereSize + 1) * (SphereSize + 1));
+
+	// 与原来 BuildSphere 的顶点计算相同：每个顶点调用 libm
+	void SphereLibm(GLfloat radius, int columns, int rows)
+	{
+		int index = 0;
+		for (int r = 0; r <= rows; r++)
+		{
+			float theta1 = (float)r / (float)rows * (float)M_PI;
+			vec3 n(std::sin(theta1), 0.0f, std::cos(theta1));
+			for (int c = 0; c <= columns; c++)
+			{
+				float theta2 = (float)c / (float)columns * (float)(M_PI * 2);
+				Vertices[index++] = vec3(n.x * std::cos(theta2), n.x * std::sin(theta2), n.z) * radius;
+			}
+		}
+	}
+
+	// 与现在 BuildSphere 的顶点计算相同：行、列的角度查表
+	void SphereTable(GLfloat radius, int columns, int rows)
+	{
+		SinCosTable lat(0.0f, (float)M_PI / rows, rows + 1);
+		SinCosTable lon(0.0f, (float)(M_PI * 2) / columns, columns + 1);
+
+		int index = 0;
+		for (int r = 0; r <= rows; r++)
+		{
+			vec3 n(lat.sin(r), 0.0f, lat.cos(r));
+			for (int c = 0; c <= columns; c++)
+			{
+				Vertices[index++] = vec3(n.x * lon.cos(c), n.x * lon.sin(c), n.z) * radius;
+			}
+		}
+	}
+}
+
+void BenchTrig()
+{
+	for (size_t i = 0; i < NumAngles; i++)
+	{
+		Angles[i] = BenchRandom() * 8192.0f;
+	}
+
+	/*正确性检查：与双精度结果比较*/
+	SinCos(Angles.data(), Sin.data(), Cos.data(), NumAngles);
+	double errLibm = 0.0, errScalar = 0.0, errBatch = 0.0;
+	for (size_t i = 0; i < NumAngles; i++)
+	{
+		double x = Angles[i];
+		double s = std::sin(x), c = std::cos(x);
+		GLfloat ss, cc;
+		SinCos(Angles[i], ss, cc);
+		errLibm = std::fmax(errLibm, std::fmax(std::fabs(std::sin(Angles[i]) - s), std::fabs(std::cos(Angles[i]) - c)));
+		errScalar = std::fmax(errScalar, std::fmax(std::fabs(ss - s), std::fabs(cc - c)));
+		errBatch = std::fmax(errBatch, std::fmax(std::fabs(Sin[i] - s), std::fabs(Cos[i] - c)));
+	}
+
+	BenchTitle("sin + cos, 1M angles in [-8192, 8192]");
+	printf("  %-40s %12g\n", "max error libm (float)", errLibm);
+	printf("  %-40s %12g\n", "max error SinCos", errScalar);
+	printf("  %-40s %12g\n", "max error SinCos batch", errBatch);
+
+	double libm = BenchRun("libm sin + cos", 10, [] {
+		for (size_t i = 0; i < NumAngles; i++)
+		{
+			Sin[i] = std::sin(Angles[i]);
+			Cos[i] = std::cos(Angles[i]);
+		}
+		BenchSink = BenchSink + Sin[NumAngles - 1];
+	});
+
+	double scalar = BenchRun("SinCos", 10, [] {
+		for (size_t i = 0; i < NumAngles; i++)
+		{
+			SinCos(Angles[i], Sin[i], Cos[i]);
+		}
+		BenchSink = BenchSink + Sin[NumAngles - 1];
+	});
+	BenchSpeedup(libm, scalar);
+
+	double batch = BenchRun("SinCos batch", 10, [] {
+		SinCos(Angles.data(), Sin.data(), Cos.data(), NumAngles);
+		BenchSink = BenchSink + Sin[NumAngles - 1];
+	});
+	BenchSpeedup(libm, batch);
+
+	BenchTitle("sphere vertices 1024 x 1024");
+	SphereLibm(1.0f, SphereSize, SphereSize);
+	std::vector<vec3> reference = Vertices;
+	SphereTable(1.0f, SphereSize, SphereSize);
+	GLfloat diff = 0.0f;
+	for (size_t i = 0; i < Vertices.size(); i++)
+	{
+		vec3 d = Vertices[i] - reference[i];
+		diff = std::fmax(diff, std::fabs(d.x) + std::fabs(d.y) + std::fabs(d.z));
+	}
+	printf("  %-40s %12g\n", "max |libm - table|", diff);
+
+	libm = BenchRun("libm per vertex", 10, [] {
+		SphereLibm(1.0f, SphereSize, SphereSize);
+		BenchSink = BenchSink + Vertices.back().x;
+	});
+	double table = BenchRun("SinCosTable per row / column", 10, [] {
+		SphereTable(1.0f, SphereSize, SphereSize);
+		BenchSink = BenchSink + Vertices.back().x;
+	});
+	BenchSpeedup(libm, table);
+}
@@ -0,0 +1,114 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	顶点布局测试：同一个球(snorm16x4 位置 + snorm16x2 法向)分别按 Planar 和 Interleaved 打包，
+//	比较打包耗时，并在 CPU 上按索引顺序模拟顶点读取：
+//	位置 + 法向(着色)时交错排列一次读取一个顶点，位置(深度预绘制、阴影)时分离排列只读位置
+//------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+
+namespace
+{
+	const GLsizei SphereSize = 1024;
+
+	struct Packed
+	{
+		VertexLayout layout;
+		std::vector<GLubyte> data;
+	};
+
+	Packed Pack(VertexLayout::Packing packing, const std::vector<snorm16x4>& positions, const std::vector<snorm16x2>& normals)
+	{
+		Packed packed = { VertexLayout(packing), {} };
+		packed.layout.attribute("position", make_span(positions))
+			.attribute("normal", make_span(normals));
+		packed.data.resize(packed.layout.bytes());
+		packed.layout.pack(packed.data.data());
+		return packed;
+	}
+
+	// 按索引读取前 count 个属性的第一个分量(与 GPU 的顶点读取一样按 offset + i * stride 寻址)
+	int Fetch(const Packed& packed, size_t count, const std::vector<GLuint>& indices)
+	{
+		const GLubyte* base[2];
+		size_t stride[2];
+		for (size_t a = 0; a < count; a++)
+		{
+			const VertexAttrib& attrib = packed.layout.attribs()[a];
+			base[a] = packed.data.data() + attrib.offset;
+			stride[a] = attrib.stride ? attrib.stride : attrib.elementSize;
+		}
+
+		int sum = 0;
+		for (GLuint i : indices)
+		{
+			for (size_t a = 0; a < count; a++)
+			{
+				GLshort x;
+				memcpy(&x, base[a] + i * stride[a], sizeof(x));
+				sum += x;
+			}
+		}
+		return sum;
+	}
+}
+
+void BenchVertex()
+{
+	IndexedMesh mesh = BuildSphereMesh(1.0f, SphereSize, SphereSize);
+	std::vector<snorm16x4> positions = PackArray<snorm16x4>(make_span(mesh.vertices));
+	std::vector<snorm16x2> normals = PackNormals(make_span(mesh.normals));
+
+	char title[64];
+	snprintf(title, sizeof(title), "vertex layout, sphere %d x %d", SphereSize, SphereSize);
+	BenchTitle(title);
+
+	Packed planar = Pack(VertexLayout::Planar, positions, normals);
+	Packed interleaved = Pack(VertexLayout::Interleaved, positions, normals);
+
+	// 两种布局读出的属性必须相同
+	bool same = planar.data.size() == interleaved.data.size();
+	for (size_t a = 0; same && a < 2; a++)
+	{
+		const VertexAttrib& p = planar.layout.attribs()[a];
+		const VertexAttrib& q = interleaved.layout.attribs()[a];
+		for (size_t i = 0; same && i < planar.layout.vertexCount(); i++)
+		{
+			same = memcmp(planar.data.data() + p.offset + i * p.elementSize,
+				interleaved.data.data() + q.offset + i * q.stride, p.elementSize) == 0;
+		}
+	}
+	printf("  %-40s %12s\n", "planar == interleaved", same ? "yes" : "NO");
+	printf("  %-40s %12.1f\n", "MB", planar.data.size() / 1048576.0);
+
+	double before = BenchRun("pack planar", 10, [&] {
+		planar.layout.pack(planar.data.data());
+		BenchSink = BenchSink + planar.data.back();
+	});
+	double after = BenchRun("pack interleaved", 10, [&] {
+		interleaved.layout.pack(interleaved.data.data());
+		BenchSink = BenchSink + interleaved.data.back();
+	});
+	BenchSpeedup(before, after);
+
+	before = BenchRun("fetch position + normal, planar", 10, [&] {
+		BenchSink = BenchSink + (float)Fetch(planar, 2, mesh.indices);
+	});
+	after = BenchRun("fetch position + normal, interleaved", 10, [&] {
+		BenchSink = BenchSink + (float)Fetch(interleaved, 2, mesh.indices);
+	});
+	BenchSpeedup(before, after);
+
+	before = BenchRun("fetch position only, interleaved", 10, [&] {
+		BenchSink = BenchSink + (float)Fetch(interleaved, 1, mesh.indices);
+	});
+	after = BenchRun("fetch position only, planar", 10, [&] {
+		BenchSink = BenchSink + (float)Fetch(planar, 1, mesh.indices);
+	});
+	BenchSpeedup(before, after);
+}
@@ -0,0 +1,41 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	数学库与几何生成的性能测试(控制台程序，不创建窗口)
+//	使用说明：
+//	建议以 Release 配置运行，Debug 配置下的数据没有参考意义
+//------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+
+volatile float BenchSink = 0.0f;
+
+int main(int argc, char** argv)
+{
+#if defined(ANGEL_SIMD_AVX)
+	printf("Angel SIMD: AVX\n");
+#elif defined(ANGEL_SIMD_SSE)
+	printf("Angel SIMD: SSE\n");
+#elif defined(ANGEL_SIMD_NEON)
+	printf("Angel SIMD: NEON\n");
+#else
+	printf("Angel SIMD: scalar\n");
+#endif
+
+	BenchMat();
+	BenchBatch();
+	BenchTrig();
+	BenchChain();
+	BenchMesh();
+	BenchMeshOpt();
+	BenchMeshGen();
+	BenchTerrain();
+	BenchSierpinski();
+	BenchVertex();
+
+	return 0;
+}
@@ -0,0 +1,73 @@
+﻿//------------------------------------------------------------------------------
+//		Copyright(c) 2020 WarZhan zhanweilong1992@gmail.com
+//		All rights reserved.
+//		Use, modificationand distribution are subject to the "MIT License"
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	性能测试公共工具
+//	每组测试实现为一个 BenchXxx() 函数，在 Benchmark.cpp 的 main 中依次调用
+//------------------------------------------------------------------------------
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include "Angel.h"
+
+#include <chrono>
+#include <cstdio>
+
+// 防止被测代码被编译器优化掉：结果累加到此变量
+extern volatile float BenchSink;
+
+// 重复执行 func iterations 次，输出并返回单次耗时(纳秒)
+template <typename Func>
+double BenchRun(const char* name, int iterations, Func func)
+{
+	func(); // 预热
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		func();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+	printf("  %-40s %12.2f ns/op\n", name, ns);
+	return ns;
+}
+
+// 输出一组测试的标题
+inline void BenchTitle(const char* title)
+{
+	printf("\n== %s ==\n", title);
+}
+
+// 输出加速比
+inline void BenchSpeedup(double baseline, double optimized)
+{
+	printf("  %-40s %12.2fx\n", "speedup", baseline / optimized);
+}
+
+// 固定种子的伪随机数，保证每次运行的输入一致
+inline GLfloat BenchRandom()
+{
+	static unsigned int seed = 12345u;
+	seed = seed * 1664525u + 1013904223u;
+	return (GLfloat)(seed >> 8) / (GLfloat)(1 << 24) * 2.0f - 1.0f;
+}
+
+/*各组测试*/
+void BenchMat();
+void BenchBatch();
+void BenchTrig();
+void BenchChain();
+void BenchMesh();
+void BenchMeshOpt();
+void BenchMeshGen();
+void BenchTerrain();
+void BenchSierpinski();
+void BenchVertex();
+
+#endif // __BENCHMARK_H__
@@ -0,0 +1,590 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+//
+//  --- terrain.h ---
+//  分块高度场地形(geomipmapping)
+//
+//   HeightMap          (size x size) 个高度采样，间距为 spacing，中心在原点；
+//                      Fractal() 用菱形-正方形算法生成，LoadRaw16() 读取 16 位 RAW 高度图
+//   TerrainLodIndices  一个块在某一 LOD、某种接缝组合下的三角形索引(所有块共用)
+//   Terrain            把高度场分成 64 x 64 格的块：
+//                      - 按到相机的距离为每块选 LOD(步长 1, 2, 4, ... 32)，相邻块最多差一级；
+//                        细块在与粗块相邻的边上跳过奇数顶点，接缝处没有裂缝
+//                      - 每个 LOD 一个索引缓冲区，存放 16 种接缝组合，所有块共用
+//                      - 只有视距内的块占用显存(固定大小的块缓冲池，离开视距的块被替换)
+//                      - 每帧的顶点数超过 vertexBudget 时缩小 LOD 距离
+//
+//   块的顶点 x、z 相对于块的原点(块的角)，y 为绝对高度；位置用 float(相邻块共享边上的顶点
+//   坐标完全相同，不会因为各块量化不同而出现裂缝)，法向用八面体编码，每个顶点 16 字节；
+//   绘制时由调用者把块的原点平移加到模视矩阵上
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ANGEL_TERRAIN_H__
+#define __ANGEL_TERRAIN_H__
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <vector>
+#include "vec.h"
+
+namespace Angel
+{
+
+	const int TerrainChunkQuads = 64;						// 每块的格数(每边)
+	const int TerrainChunkVerts = TerrainChunkQuads + 1;	// 每块的顶点数(每边)
+	const int TerrainLodCount = 6;							// LOD 0..5，步长 1..32
+
+	// 接缝标志：该边与较粗的块相邻
+	// 北边为块内 z = 0 的边(-z 方向)，南边为 z = 64，西边为 x = 0，东边为 x = 64
+	enum
+	{
+		TerrainEdgeNorth = 1,
+		TerrainEdgeEast = 2,
+		TerrainEdgeSouth = 4,
+		TerrainEdgeWest = 8,
+		TerrainEdgeCombinations = 16
+	};
+
+	//----------------------------------------------------------------------------
+	//
+	//  HeightMap - 高度场
+	//
+
+	class HeightMap
+	{
+		size_t _size;
+		GLfloat _spacing;
+		std::vector<GLfloat> _heights;
+
+		// 位置 (x, z) 和种子决定的 [-1, 1] 内的伪随机数，与生成顺序无关
+		static GLfloat random(size_t x, size_t z, unsigned seed)
+		{
+			unsigned h = (unsigned)x * 73856093u ^ (unsigned)z * 19349663u ^ seed * 83492791u;
+			h ^= h >> 13;
+			h *= 0x5bd1e995u;
+			h ^= h >> 15;
+			return (GLfloat)(h & 0xffffff) / (GLfloat)0x800000 - 1.0f;
+		}
+
+	public:
+		HeightMap() : _size(0), _spacing(1.0f) {}
+
+		HeightMap(size_t size, GLfloat spacing) :
+			_size(size), _spacing(spacing), _heights(size * size, 0.0f) {}
+
+		size_t size() const { return _size; }
+		GLfloat spacing() const { return _spacing; }
+		GLfloat extent() const { return (_size - 1) * _spacing; }	// 边长
+
+		GLfloat& at(size_t x, size_t z) { return _heights[z * _size + x]; }
+		GLfloat at(size_t x, size_t z) const { return _heights[z * _size + x]; }
+
+		// 越界时取边上的值
+		GLfloat clamped(long x, long z) const
+		{
+			long last = (long)_size - 1;
+			x = x < 0 ? 0 : (x > last ? last : x);
+			z = z < 0 ? 0 : (z > last ? last : z);
+			return at((size_t)x, (size_t)z);
+		}
+
+		// 采样点 (x, z) 处的法向(中心差分)
+		vec3 normal(long x, long z) const
+		{
+			return normalize(vec3(clamped(x - 1, z) - clamped(x + 1, z),
+				2.0f * _spacing,
+				clamped(x, z - 1) - clamped(x, z + 1)));
+		}
+
+		// 世界坐标 (x, z) 处的高度(双线性插值)
+		GLfloat height(GLfloat x, GLfloat z) const
+		{
+			GLfloat fx = (x + 0.5f * extent()) / _spacing;
+			GLfloat fz = (z + 0.5f * extent()) / _spacing;
+			long ix = (long)std::floor(fx);
+			long iz = (long)std::floor(fz);
+			GLfloat tx = fx - ix;
+			GLfloat tz = fz - iz;
+
+			GLfloat h0 = clamped(ix, iz) + (clamped(ix + 1, iz) - clamped(ix, iz)) * tx;
+			GLfloat h1 = clamped(ix, iz + 1) + (clamped(ix + 1, iz + 1) - clamped(ix, iz + 1)) * tx;
+			return h0 + (h1 - h0) * tz;
+		}
+
+		// 菱形-正方形算法生成 (2^levels + 1) x (2^levels + 1) 的高度场
+		// amplitude 为最大一级的起伏，每细分一级起伏乘以 roughness
+		static HeightMap Fractal(int levels, GLfloat spacing, GLfloat amplitude,
+			GLfloat roughness = 0.5f, unsigned seed = 1)
+		{
+			size_t size = ((size_t)1 << levels) + 1;
+			HeightMap map(size, spacing);
+
+			GLfloat scale = amplitude;
+			for (size_t step = size - 1; step > 1; step /= 2, scale *= roughness)
+			{
+				size_t half = step / 2;
+
+				// 菱形步：每个正方形的中心取四个角的平均值
+				for (size_t z = half; z < size; z += step)
+				{
+					for (size_t x = half; x < size; x += step)
+					{
+						GLfloat sum = map.at(x - half, z - half) + map.at(x + half, z - half)
+							+ map.at(x - half, z + half) + map.at(x + half, z + half);
+						map.at(x, z) = sum * 0.25f + random(x, z, seed) * scale;
+					}
+				}
+
+				// 正方形步：每条边的中点取上下左右(在范围内的)的平均值
+				for (size_t z = 0; z < size; z += half)
+				{
+					for (size_t x = (z / half) % 2 ? 0 : half; x < size; x += step)
+					{
+						GLfloat sum = 0.0f;
+						int count = 0;
+						if (x >= half) { sum += map.at(x - half, z); count++; }
+						if (x + half < size) { sum += map.at(x + half, z); count++; }
+						if (z >= half) { sum += map.at(x, z - half); count++; }
+						if (z + half < size) { sum += map.at(x, z + half); count++; }
+						map.at(x, z) = sum / count + random(x, z, seed) * scale;
+					}
+				}
+			}
+
+			return map;
+		}
+
+		// 读取 size x size 个 16 位无符号整数(小端)的 RAW 高度图，高度 = 值 * scale
+		static bool LoadRaw16(const char* fileName, size_t size, GLfloat spacing, GLfloat scale, HeightMap& map)
+		{
+			std::ifstream file(fileName, std::ios::binary);
+			if (!file)
+			{
+				return false;
+			}
+
+			std::vector<unsigned char> data(size * size * 2);
+			file.read(reinterpret_cast<char*>(data.data()), data.size());
+			if ((size_t)file.gcount() != data.size())
+			{
+				return false;
+			}
+
+			map = HeightMap(size, spacing);
+			for (size_t i = 0; i < size * size; i++)
+			{
+				map._heights[i] = (GLfloat)(data[i * 2] | (data[i * 2 + 1] << 8)) * scale;
+			}
+			return true;
+		}
+	};
+
+	//----------------------------------------------------------------------------
+	//
+	//  TerrainLodIndices - 块的索引
+	//
+	//    LOD lod 的步长为 s = 2^lod，用块内每隔 s 个的顶点组成 (64/s) x (64/s) 个格子。
+	//    edges 标记的边与粗一级的块相邻：这条边上的奇数顶点并到前一个偶数顶点上，
+	//    相关的三角形退化(被丢弃)或变成扇形，这条边只剩下粗块也有的顶点
+	//
+
+	inline std::vector<GLushort> TerrainLodIndices(int lod, int edges)
+	{
+		int s = 1 << lod;
+		int n = TerrainChunkQuads / s;
+
+		auto vertex = [=](int c, int r) -> GLuint {
+			if (r == 0 && (edges & TerrainEdgeNorth) && (c & 1))
+			{
+				c--;
+			}
+			else if (r == n && (edges & TerrainEdgeSouth) && (c & 1))
+			{
+				c--;
+			}
+			else if (c == 0 && (edges & TerrainEdgeWest) && (r & 1))
+			{
+				r--;
+			}
+			else if (c == n && (edges & TerrainEdgeEast) && (r & 1))
+			{
+				r--;
+			}
+			return (GLuint)(r * s * TerrainChunkVerts + c * s);
+		};
+
+		std::vector<GLuint> indices;
+		indices.reserve(n * n * 6);
+		auto triangle = [&](GLuint a, GLuint b, GLuint c) {
+			if (a != b && b != c && c != a)
+			{
+				indices.push_back(a);
+				indices.push_back(b);
+				indices.push_back(c);
+			}
+		};
+
+		for (int r = 0; r < n; r++)
+		{
+			for (int c = 0; c < n; c++)
+			{
+				GLuint ul = vertex(c, r);			// 左上
+				GLuint ur = vertex(c + 1, r);		// 右上
+				GLuint bl = vertex(c, r + 1);		// 左下
+				GLuint br = vertex(c + 1, r + 1);	// 右下
+
+				triangle(ul, bl, br);
+				triangle(ul, br, ur);
+			}
+		}
+
+		// 所有块都用这组索引，做一次顶点缓存优化(见 meshopt.h)
+		indices = OptimizeVertexCache(make_span(indices), TerrainChunkVerts * TerrainChunkVerts);
+		return std::vector<GLushort>(indices.begin(), indices.end());
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  Terrain - 分块、按距离选择 LOD 的地形
+	//
+
+	class Terrain
+	{
+	public:
+		// 每帧选出的一个块
+		struct Chunk
+		{
+			int      x, z;		// 块的行列号
+			int      lod;
+			int      edges;		// 接缝标志
+			GLfloat  distance;	// 到相机的水平距离
+		};
+
+		// 上一帧的统计
+		struct Stats
+		{
+			size_t  chunks;		// 绘制的块数
+			size_t  vertices;	// 绘制的块的顶点数之和
+			size_t  triangles;
+			size_t  uploads;	// 新上传的块数
+		};
+
+	private:
+		const HeightMap& _map;
+		int _chunksPerSide;
+		GLfloat _viewDistance;		// 视距，之外的块不画
+		GLfloat _lodDistance;		// 距离小于它的块用 LOD 0，每远一倍粗一级
+		size_t _vertexBudget;		// 每帧的顶点数上限
+
+		// 索引：每个 LOD 一个缓冲区，16 种接缝组合依次存放
+		GLuint _indexBuffers[TerrainLodCount];
+		GLsizei _indexOffset[TerrainLodCount][TerrainEdgeCombinations];
+		GLsizei _indexCount[TerrainLodCount][TerrainEdgeCombinations];
+
+		// 块缓冲池：每个槽存放一个块的 65 x 65 个顶点(先位置后法向)
+		GLuint _vao;
+		GLuint _vertexBuffer;
+		GLuint _position;
+		GLint _normal;
+		std::vector<int> _slotOfChunk;		// 块 -> 槽，-1 表示不在显存中
+		std::vector<int> _chunkOfSlot;		// 槽 -> 块，-1 表示空闲
+		std::vector<unsigned> _slotFrame;	// 槽最后一次被绘制的帧号
+		unsigned _frame;
+
+		std::vector<Chunk> _visible;
+		std::vector<int> _lodGrid;			// 每块本帧的 LOD，-1 表示不画
+		Stats _stats;
+
+		static size_t SlotVertices() { return TerrainChunkVerts * TerrainChunkVerts; }
+		static size_t SlotBytes() { return SlotVertices() * (sizeof(vec3) + sizeof(snorm16x2)); }
+
+		static size_t LodVertices(int lod)
+		{
+			size_t n = (TerrainChunkQuads >> lod) + 1;
+			return n * n;
+		}
+
+		// 块到点 (x, z) 的水平距离(点在块内时为 0)
+		GLfloat chunkDistance(int cx, int cz, GLfloat x, GLfloat z) const
+		{
+			GLfloat size = TerrainChunkQuads * _map.spacing();
+			GLfloat x0 = -0.5f * _map.extent() + cx * size;
+			GLfloat z0 = -0.5f * _map.extent() + cz * size;
+			GLfloat dx = std::fmax(std::fmax(x0 - x, x - (x0 + size)), 0.0f);
+			GLfloat dz = std::fmax(std::fmax(z0 - z, z - (z0 + size)), 0.0f);
+			return std::sqrt(dx * dx + dz * dz);
+		}
+
+		int lodForDistance(GLfloat distance, GLfloat lodDistance) const
+		{
+			if (distance < lodDistance)
+			{
+				return 0;
+			}
+			int lod = (int)std::log2(distance / lodDistance) + 1;
+			return lod < TerrainLodCount - 1 ? lod : TerrainLodCount - 1;
+		}
+
+		// 把块 index 放进缓冲池，返回槽号
+		int makeResident(int index)
+		{
+			int slot = _slotOfChunk[index];
+			if (slot < 0)
+			{
+				// 取最久没有画过的槽(本帧画过的不会被选中，缓冲池足够放下视距内的所有块)
+				slot = 0;
+				for (int i = 1; i < (int)_chunkOfSlot.size(); i++)
+				{
+					if (_slotFrame[i] < _slotFrame[slot])
+					{
+						slot = i;
+					}
+				}
+				if (_chunkOfSlot[slot] >= 0)
+				{
+					_slotOfChunk[_chunkOfSlot[slot]] = -1;
+				}
+				_chunkOfSlot[slot] = index;
+				_slotOfChunk[index] = slot;
+
+				std::vector<vec3> positions(SlotVertices());
+				std::vector<snorm16x2> normals(SlotVertices());
+				buildChunk(index % _chunksPerSide, index / _chunksPerSide, positions.data(), normals.data());
+				BufferSubData(GL_ARRAY_BUFFER, slot * SlotBytes(), make_span(positions));
+				BufferSubData(GL_ARRAY_BUFFER, slot * SlotBytes() + SlotVertices() * sizeof(vec3), make_span(normals));
+				_stats.uploads++;
+			}
+			_slotFrame[slot] = _frame;
+			return slot;
+		}
+
+	public:
+		// map 在 Terrain 的生存期内必须有效；高度场的格数应为 64 的倍数(多余的部分不画)
+		Terrain(const HeightMap& map, GLfloat viewDistance, GLfloat lodDistance, size_t vertexBudget) :
+			_map(map), _viewDistance(viewDistance), _lodDistance(lodDistance), _vertexBudget(vertexBudget),
+			_vao(0), _vertexBuffer(0), _position(0), _normal(-1), _frame(0)
+		{
+			_chunksPerSide = (int)((map.size() - 1) / TerrainChunkQuads);
+			_lodGrid.assign(_chunksPerSide * _chunksPerSide, -1);
+			_slotOfChunk.assign(_lodGrid.size(), -1);
+			_stats = Stats();
+		}
+
+		int chunksPerSide() const { return _chunksPerSide; }
+		const Stats& stats() const { return _stats; }
+		const HeightMap& heightMap() const { return _map; }
+
+		// 块的原点(世界坐标，y 为 0)，块内顶点坐标相对于它
+		vec3 chunkOrigin(int cx, int cz) const
+		{
+			GLfloat size = TerrainChunkQuads * _map.spacing();
+			return vec3(-0.5f * _map.extent() + cx * size, 0.0f, -0.5f * _map.extent() + cz * size);
+		}
+
+		// 生成块 (cx, cz) 的 65 x 65 个顶点(相对于块原点)
+		// 高度直接取高度场的值，共享边上的顶点在两个块中完全相同
+		void buildChunk(int cx, int cz, vec3* positions, snorm16x2* normals) const
+		{
+			size_t index = 0;
+			for (int r = 0; r < TerrainChunkVerts; r++)
+			{
+				for (int c = 0; c < TerrainChunkVerts; c++, index++)
+				{
+					long x = cx * TerrainChunkQuads + c;
+					long z = cz * TerrainChunkQuads + r;
+					positions[index] = vec3(c * _map.spacing(), _map.at(x, z), r * _map.spacing());
+					normals[index] = PackOctahedral(_map.normal(x, z));
+				}
+			}
+		}
+
+		// 选出视距内的块，确定 LOD 和接缝，按由近到远排序
+		// 顶点数超过预算时缩小 LOD 距离重选
+		void select(const vec3& eye, std::vector<Chunk>& chunks)
+		{
+			chunks.clear();
+			GLfloat size = TerrainChunkQuads * _map.spacing();
+			int cx0 = (int)std::floor((eye.x - _viewDistance + 0.5f * _map.extent()) / size);
+			int cx1 = (int)std::floor((eye.x + _viewDistance + 0.5f * _map.extent()) / size);
+			int cz0 = (int)std::floor((eye.z - _viewDistance + 0.5f * _map.extent()) / size);
+			int cz1 = (int)std::floor((eye.z + _viewDistance + 0.5f * _map.extent()) / size);
+			cx0 = std::max(cx0, 0);
+			cz0 = std::max(cz0, 0);
+			cx1 = std::min(cx1, _chunksPerSide - 1);
+			cz1 = std::min(cz1, _chunksPerSide - 1);
+
+			for (int cz = cz0; cz <= cz1; cz++)
+			{
+				for (int cx = cx0; cx <= cx1; cx++)
+				{
+					GLfloat d = chunkDistance(cx, cz, eye.x, eye.z);
+					if (d <= _viewDistance)
+					{
+						Chunk chunk = { cx, cz, 0, 0, d };
+						chunks.push_back(chunk);
+					}
+				}
+			}
+			std::sort(chunks.begin(), chunks.end(), [](const Chunk& a, const Chunk& b) { return a.distance < b.distance; });
+
+			GLfloat lodDistance = _lodDistance;
+			for (int attempt = 0; attempt < 16; attempt++)
+			{
+				for (Chunk& chunk : chunks)
+				{
+					chunk.lod = lodForDistance(chunk.distance, lodDistance);
+					_lodGrid[chunk.z * _chunksPerSide + chunk.x] = chunk.lod;
+				}
+
+				// 相邻块最多差一级：由近到远，每块不超过相邻块的 LOD + 1(近处的块先定下来)
+				bool changed = true;
+				while (changed)
+				{
+					changed = false;
+					for (Chunk& chunk : chunks)
+					{
+						static const int offsets[4][2] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+						for (int e = 0; e < 4; e++)
+						{
+							int nx = chunk.x + offsets[e][0];
+							int nz = chunk.z + offsets[e][1];
+							if (nx < 0 || nz < 0 || nx >= _chunksPerSide || nz >= _chunksPerSide)
+							{
+								continue;
+							}
+							int neighbor = _lodGrid[nz * _chunksPerSide + nx];
+							if (neighbor >= 0 && chunk.lod > neighbor + 1)
+							{
+								chunk.lod = neighbor + 1;
+								_lodGrid[chunk.z * _chunksPerSide + chunk.x] = chunk.lod;
+								changed = true;
+							}
+						}
+					}
+				}
+
+				size_t vertices = 0;
+				for (const Chunk& chunk : chunks)
+				{
+					vertices += LodVertices(chunk.lod);
+				}
+				if (vertices <= _vertexBudget || lodDistance < _map.spacing())
+				{
+					break;
+				}
+				lodDistance *= 0.75f;
+			}
+
+			// 接缝：相邻块更粗的边
+			for (Chunk& chunk : chunks)
+			{
+				static const int offsets[4][2] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+				static const int flags[4] = { TerrainEdgeNorth, TerrainEdgeEast, TerrainEdgeSouth, TerrainEdgeWest };
+				chunk.edges = 0;
+				for (int e = 0; e < 4; e++)
+				{
+					int nx = chunk.x + offsets[e][0];
+					int nz = chunk.z + offsets[e][1];
+					if (nx < 0 || nz < 0 || nx >= _chunksPerSide || nz >= _chunksPerSide)
+					{
+						continue;
+					}
+					if (_lodGrid[nz * _chunksPerSide + nx] > chunk.lod)
+					{
+						chunk.edges |= flags[e];
+					}
+				}
+			}
+
+			// 清除本帧的标记，下一帧重新选择
+			for (const Chunk& chunk : chunks)
+			{
+				_lodGrid[chunk.z * _chunksPerSide + chunk.x] = -1;
+			}
+		}
+
+		// 创建 VAO、索引缓冲区和块缓冲池；position/normal 为 shader 中的属性索引，normal < 0 表示不用法向
+		void init(GLuint position, GLint normal = -1)
+		{
+			_position = position;
+			_normal = normal;
+
+			glGenVertexArrays(1, &_vao);
+			glBindVertexArray(_vao);
+
+			// 每个 LOD 一个索引缓冲区，存放 16 种接缝组合
+			glGenBuffers(TerrainLodCount, _indexBuffers);
+			for (int lod = 0; lod < TerrainLodCount; lod++)
+			{
+				std::vector<GLushort> indices;
+				for (int edges = 0; edges < TerrainEdgeCombinations; edges++)
+				{
+					std::vector<GLushort> variant = TerrainLodIndices(lod, edges);
+					_indexOffset[lod][edges] = (GLsizei)indices.size();
+					_indexCount[lod][edges] = (GLsizei)variant.size();
+					indices.insert(indices.end(), variant.begin(), variant.end());
+				}
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffers[lod]);
+				BufferData(GL_ELEMENT_ARRAY_BUFFER, make_span(indices), GL_STATIC_DRAW);
+			}
+
+			// 缓冲池的槽数：视距内最多可能出现的块数
+			int side = 2 * (int)std::ceil(_viewDistance / (TerrainChunkQuads * _map.spacing())) + 2;
+			size_t slots = std::min((size_t)side * side, _lodGrid.size());
+			_chunkOfSlot.assign(slots, -1);
+			_slotFrame.assign(slots, 0);
+
+			glGenBuffers(1, &_vertexBuffer);
+			glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+			glBufferData(GL_ARRAY_BUFFER, slots * SlotBytes(), NULL, GL_DYNAMIC_DRAW);
+
+			glEnableVertexAttribArray(_position);
+			if (_normal >= 0)
+			{
+				glEnableVertexAttribArray(_normal);
+			}
+		}
+
+		// 以 eye 为相机位置绘制地形；每块绘制前调用 setOrigin(块原点)，由调用者设置模视矩阵
+		template <typename SetOrigin>
+		void draw(const vec3& eye, SetOrigin setOrigin)
+		{
+			_frame++;
+			_stats = Stats();
+			select(eye, _visible);
+
+			glBindVertexArray(_vao);
+			glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+
+			int boundLod = -1;
+			for (const Chunk& chunk : _visible)
+			{
+				int slot = makeResident(chunk.z * _chunksPerSide + chunk.x);
+				size_t offset = slot * SlotBytes();
+				VertexAttribPointer<vec3>(_position, 0, offset);
+				if (_normal >= 0)
+				{
+					VertexAttribPointer<snorm16x2>(_normal, 0, offset + SlotVertices() * sizeof(vec3));
+				}
+
+				if (chunk.lod != boundLod)
+				{
+					glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffers[chunk.lod]);
+					boundLod = chunk.lod;
+				}
+
+				setOrigin(chunkOrigin(chunk.x, chunk.z));
+				GLsizei count = _indexCount[chunk.lod][chunk.edges];
+				glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT,
+					BUFFER_OFFSET(_indexOffset[chunk.lod][chunk.edges] * sizeof(GLushort)));
+
+				_stats.chunks++;
+				_stats.vertices += LodVertices(chunk.lod);
+				_stats.triangles += count / 3;
+			}
+		}
+	};
+
+}  // namespace Angel
+
+#endif // __ANGEL_TERRAIN_H__
@@ -0,0 +1,592 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+//
+//  --- vec.h ---
+//  定义向量类(vec2,vec3和vec4)
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ANGEL_VEC_H__
+#define __ANGEL_VEC_H__
+
+#include "Angel.h"
+
+#include <type_traits>
+
+namespace Angel
+{
+
+	//////////////////////////////////////////////////////////////////////////////
+	//
+	//  vec2.h - 2D vector
+	//
+
+	struct vec2
+	{
+
+		GLfloat  x;
+		GLfloat  y;
+
+		//
+		//  --- Constructors and Destructors ---
+		//
+
+		constexpr vec2(GLfloat s = GLfloat(0.0)) :
+			x(s), y(s) {}
+
+		constexpr vec2(GLfloat x, GLfloat y) :
+			x(x), y(y) {}
+
+		//
+		//  --- Indexing Operator ---
+		//
+
+		GLfloat& operator [] (int i) { return *(&x + i); }
+		const GLfloat operator [] (int i) const { return *(&x + i); }
+
+		//
+		//  --- (non-modifying) Arithematic Operators ---
+		//
+
+		constexpr vec2 operator - () const // unary minus operator
+		{
+			return vec2(-x, -y);
+		}
+
+		constexpr vec2 operator + (const vec2& v) const
+		{
+			return vec2(x + v.x, y + v.y);
+		}
+
+		constexpr vec2 operator - (const vec2& v) const
+		{
+			return vec2(x - v.x, y - v.y);
+		}
+
+		constexpr vec2 operator * (const GLfloat s) const
+		{
+			return vec2(s * x, s * y);
+		}
+
+		constexpr vec2 operator * (const vec2& v) const
+		{
+			return vec2(x * v.x, y * v.y);
+		}
+
+		friend constexpr vec2 operator * (const GLfloat s, const vec2& v)
+		{
+			return v * s;
+		}
+
+		constexpr vec2 operator / (const GLfloat s) const {
+#ifdef DEBUG
+			if (std::fabs(s) < DivideByZeroTolerance) {
+				std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
+					<< "Division by zero" << std::endl;
+				return vec2();
+			}
+#endif // DEBUG
+
+			GLfloat r = GLfloat(1.0) / s;
+			return *this * r;
+		}
+
+		//
+		//  --- (modifying) Arithematic Operators ---
+		//
+
+		constexpr vec2& operator += (const vec2& v)
+		{
+			x += v.x;  y += v.y;   return *this;
+		}
+
+		constexpr vec2& operator -= (const vec2& v)
+		{
+			x -= v.x;  y -= v.y;  return *this;
+		}
+
+		constexpr vec2& operator *= (const GLfloat s)
+		{
+			x *= s;  y *= s;   return *this;
+		}
+
+		constexpr vec2& operator *= (const vec2& v)
+		{
+			x *= v.x;  y *= v.y; return *this;
+		}
+
+		constexpr vec2& operator /= (const GLfloat s)
+		{
+#ifdef DEBUG
+			if (std::fabs(s) < DivideByZeroTolerance)
+			{
+				std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
+					<< "Division by zero" << std::endl;
+			}
+#endif // DEBUG
+
+			GLfloat r = GLfloat(1.0) / s;
+			*this *= r;
+
+			return *this;
+		}
+
+		//
+		//  --- Insertion and Extraction Operators ---
+		//
+
+		friend std::ostream& operator << (std::ostream& os, const vec2& v)
+		{
+			return os << "( " << v.x << ", " << v.y << " )";
+		}
+
+		friend std::istream& operator >> (std::istream& is, vec2& v)
+		{
+			return is >> v.x >> v.y;
+		}
+
+		//
+		//  --- Conversion Operators ---
+		//
+
+		operator const GLfloat* () const
+		{
+			return static_cast<const GLfloat*>(&x);
+		}
+
+		operator GLfloat* ()
+		{
+			return static_cast<GLfloat*>(&x);
+		}
+	};
+
+	//----------------------------------------------------------------------------
+	//
+	//  Non-class vec2 Methods
+	//
+
+	inline constexpr GLfloat dot(const vec2& u, const vec2& v)
+	{
+		return u.x * v.x + u.y * v.y;
+	}
+
+	inline GLfloat length(const vec2& v)
+	{
+		return std::sqrt(dot(v, v));
+	}
+
+	inline vec2 normalize(const vec2& v)
+	{
+		return v / length(v);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//
+	//  vec3.h - 3D vector
+	//
+	//////////////////////////////////////////////////////////////////////////////
+
+	struct vec3
+	{
+
+		GLfloat  x;
+		GLfloat  y;
+		GLfloat  z;
+
+		//
+		//  --- Constructors and Destructors ---
+		//
+
+		constexpr vec3(GLfloat s = GLfloat(0.0)) :
+			x(s), y(s), z(s) {}
+
+		constexpr vec3(GLfloat x, GLfloat y, GLfloat z) :
+			x(x), y(y), z(z) {}
+
+		constexpr vec3(const vec2& v, const float f) :
+			x(v.x), y(v.y), z(f) {}
+
+		//
+		//  --- Indexing Operator ---
+		//
+
+		GLfloat& operator [] (int i) { return *(&x + i); }
+		const GLfloat operator [] (int i) const { return *(&x + i); }
+
+		//
+		//  --- (non-modifying) Arithematic Operators ---
+		//
+
+		constexpr vec3 operator - () const  // unary minus operator
+		{
+			return vec3(-x, -y, -z);
+		}
+
+		constexpr vec3 operator + (const vec3& v) const
+		{
+			return vec3(x + v.x, y + v.y, z + v.z);
+		}
+
+		constexpr vec3 operator - (const vec3& v) const
+		{
+			return vec3(x - v.x, y - v.y, z - v.z);
+		}
+
+		constexpr vec3 operator * (const GLfloat s) const
+		{
+			return vec3(s * x, s * y, s * z);
+		}
+
+		constexpr vec3 operator * (const vec3& v) const
+		{
+			return vec3(x * v.x, y * v.y, z * v.z);
+		}
+
+		friend constexpr vec3 operator * (const GLfloat s, const vec3& v)
+		{
+			return v * s;
+		}
+
+		constexpr vec3 operator / (const GLfloat s) const
+		{
+#ifdef DEBUG
+			if (std::fabs(s) < DivideByZeroTolerance)
+			{
+				std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
+					<< "Division by zero" << std::endl;
+				return vec3();
+			}
+#endif // DEBUG
+
+			GLfloat r = GLfloat(1.0) / s;
+			return *this * r;
+		}
+
+		//
+		//  --- (modifying) Arithematic Operators ---
+		//
+
+		constexpr vec3& operator += (const vec3& v)
+		{
+			x += v.x;  y += v.y;  z += v.z;  return *this;
+		}
+
+		constexpr vec3& operator -= (const vec3& v)
+		{
+			x -= v.x;  y -= v.y;  z -= v.z;  return *this;
+		}
+
+		constexpr vec3& operator *= (const GLfloat s)
+		{
+			x *= s;  y *= s;  z *= s;  return *this;
+		}
+
+		constexpr vec3& operator *= (const vec3& v)
+		{
+			x *= v.x;  y *= v.y;  z *= v.z;  return *this;
+		}
+
+		constexpr vec3& operator /= (const GLfloat s)
+		{
+#ifdef DEBUG
+			if (std::fabs(s) < DivideByZeroTolerance)
+			{
+				std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
+					<< "Division by zero" << std::endl;
+			}
+#endif // DEBUG
+
+			GLfloat r = GLfloat(1.0) / s;
+			*this *= r;
+
+			return *this;
+		}
+
+		//
+		//  --- Insertion and Extraction Operators ---
+		//
+
+		friend std::ostream& operator << (std::ostream& os, const vec3& v)
+		{
+			return os << "( " << v.x << ", " << v.y << ", " << v.z << " )";
+		}
+
+		friend std::istream& operator >> (std::istream& is, vec3& v)
+		{
+			return is >> v.x >> v.y >> v.z;
+		}
+
+		//
+		//  --- Conversion Operators ---
+		//
+
+		operator const GLfloat* () const
+		{
+			return static_cast<const GLfloat*>(&x);
+		}
+
+		operator GLfloat* ()
+		{
+			return static_cast<GLfloat*>(&x);
+		}
+	};
+
+	//----------------------------------------------------------------------------
+	//
+	//  Non-class vec3 Methods
+	//
+
+	inline constexpr GLfloat dot(const vec3& u, const vec3& v)
+	{
+		return u.x * v.x + u.y * v.y + u.z * v.z;
+	}
+
+	inline GLfloat length(const vec3& v)
+	{
+		return std::sqrt(dot(v, v));
+	}
+
+	inline vec3 normalize(const vec3& v)
+	{
+		return v / length(v);
+	}
+
+	inline constexpr vec3 cross(const vec3& a, const vec3& b)
+	{
+		return vec3(a.y * b.z - a.z * b.y,
+			a.z * b.x - a.x * b.z,
+			a.x * b.y - a.y * b.x);
+	}
+
+
+	//////////////////////////////////////////////////////////////////////////////
+	//
+	//  vec4 - 4D vector
+	//
+	//////////////////////////////////////////////////////////////////////////////
+
+	struct vec4
+	{
+
+		GLfloat  x;
+		GLfloat  y;
+		GLfloat  z;
+		GLfloat  w;
+
+		//
+		//  --- Constructors and Destructors ---
+		//
+
+		constexpr vec4(GLfloat s = GLfloat(0.0)) :
+			x(s), y(s), z(s), w(s) {}
+
+		constexpr vec4(GLfloat x, GLfloat y, GLfloat z, GLfloat w) :
+			x(x), y(y), z(z), w(w) {}
+
+		constexpr vec4(const vec3& v, const float w = 1.0) :
+			x(v.x), y(v.y), z(v.z), w(w) {}
+
+		constexpr vec4(const vec2& v, const float z, const float w) :
+			x(v.x), y(v.y), z(z), w(w) {}
+
+		//
+		//  --- Indexing Operator ---
+		//
+
+		GLfloat& operator [] (int i) { return *(&x + i); }
+		const GLfloat operator [] (int i) const { return *(&x + i); }
+
+		//
+		//  --- (non-modifying) Arithematic Operators ---
+		//
+
+		constexpr vec4 operator - () const  // unary minus operator
+		{
+			return vec4(-x, -y, -z, -w);
+		}
+
+		constexpr vec4 operator + (const vec4& v) const
+		{
+			return vec4(x + v.x, y + v.y, z + v.z, w + v.w);
+		}
+
+		constexpr vec4 operator - (const vec4& v) const
+		{
+			return vec4(x - v.x, y - v.y, z - v.z, w - v.w);
+		}
+
+		constexpr vec4 operator * (const GLfloat s) const
+		{
+			return vec4(s * x, s * y, s * z, s * w);
+		}
+
+		constexpr vec4 operator * (const vec4& v) const
+		{
+			return vec4(x * v.x, y * v.y, z * v.z, w * v.w);
+		}
+
+		friend constexpr vec4 operator * (const GLfloat s, const vec4& v)
+		{
+			return v * s;
+		}
+
+		constexpr vec4 operator / (const GLfloat s) const
+		{
+#ifdef DEBUG
+			if (std::fabs(s) < DivideByZeroTolerance)
+			{
+				std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
+					<< "Division by zero" << std::endl;
+				return vec4();
+			}
+#endif // DEBUG
+
+			GLfloat r = GLfloat(1.0) / s;
+			return *this * r;
+		}
+
+		//
+		//  --- (modifying) Arithematic Operators ---
+		//
+
+		constexpr vec4& operator += (const vec4& v)
+		{
+			x += v.x;  y += v.y;  z += v.z;  w += v.w;  return *this;
+		}
+
+		constexpr vec4& operator -= (const vec4& v)
+		{
+			x -= v.x;  y -= v.y;  z -= v.z;  w -= v.w;  return *this;
+		}
+
+		constexpr vec4& operator *= (const GLfloat s)
+		{
+			x *= s;  y *= s;  z *= s;  w *= s;  return *this;
+		}
+
+		constexpr vec4& operator *= (const vec4& v)
+		{
+			x *= v.x, y *= v.y, z *= v.z, w *= v.w;  return *this;
+		}
+
+		constexpr vec4& operator /= (const GLfloat s)
+		{
+#ifdef DEBUG
+			if (std::fabs(s) < DivideByZeroTolerance)
+			{
+				std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
+					<< "Division by zero" << std::endl;
+			}
+#endif // DEBUG
+
+			GLfloat r = GLfloat(1.0) / s;
+			*this *= r;
+
+			return *this;
+		}
+
+		//
+		//  --- Insertion and Extraction Operators ---
+		//
+
+		friend std::ostream& operator << (std::ostream& os, const vec4& v)
+		{
+			return os << "( " << v.x << ", " << v.y
+				<< ", " << v.z << ", " << v.w << " )";
+		}
+
+		friend std::istream& operator >> (std::istream& is, vec4& v)
+		{
+			return is >> v.x >> v.y >> v.z >> v.w;
+		}
+
+		//
+		//  --- Conversion Operators ---
+		//
+
+		operator const GLfloat* () const
+		{
+			return static_cast<const GLfloat*>(&x);
+		}
+
+		operator GLfloat* ()
+		{
+			return static_cast<GLfloat*>(&x);
+		}
+	};
+
+	//----------------------------------------------------------------------------
+	//
+	//  Non-class vec4 Methods
+	//
+
+	inline constexpr GLfloat dot(const vec4& u, const vec4& v)
+	{
+		return u.x * v.x + u.y * v.y + u.z * v.z + u.w + v.w;
+	}
+
+	inline GLfloat length(const vec4& v)
+	{
+		return std::sqrt(dot(v, v));
+	}
+
+	inline vec4 normalize(const vec4& v)
+	{
+		return v / length(v);
+	}
+
+	inline constexpr vec3 cross(const vec4& a, const vec4& b)
+	{
+		return vec3(a.y * b.z - a.z * b.y,
+			a.z * b.x - a.x * b.z,
+			a.x * b.y - a.y * b.x);
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  --- Layout guarantees ---
+	//
+	//   向量与 GLfloat 数组的内存布局一致且可平凡复制(使用编译器生成的拷贝构造)，
+	//   因此 vec3 数组可以直接交给 glBufferData，std::vector 扩容时也可以按字节拷贝
+	//
+
+	static_assert(sizeof(vec2) == 2 * sizeof(GLfloat), "vec2 must be two packed GLfloats");
+	static_assert(sizeof(vec3) == 3 * sizeof(GLfloat), "vec3 must be three packed GLfloats");
+	static_assert(sizeof(vec4) == 4 * sizeof(GLfloat), "vec4 must be four packed GLfloats");
+	static_assert(std::is_trivially_copyable<vec2>::value, "vec2 must be trivially copyable");
+	static_assert(std::is_trivially_copyable<vec3>::value, "vec3 must be trivially copyable");
+	static_assert(std::is_trivially_copyable<vec4>::value, "vec4 must be trivially copyable");
+	static_assert(std::is_standard_layout<vec4>::value, "vec4 must be standard layout");
+
+	//----------------------------------------------------------------------------
+	//
+	//  --- 16-byte aligned variants ---
+	//
+	//   vec3a / vec4a 按 16 字节对齐(vec3a 末尾补 4 字节，步长为 16)，
+	//   用于 SIMD 对齐加载和 std140 布局的 uniform 块；运算结果为普通的 vec3 / vec4
+	//
+
+	struct alignas(16) vec3a : public vec3
+	{
+		using vec3::vec3;
+
+		constexpr vec3a() : vec3() {}
+		constexpr vec3a(const vec3& v) : vec3(v) {}
+	};
+
+	struct alignas(16) vec4a : public vec4
+	{
+		using vec4::vec4;
+
+		constexpr vec4a() : vec4() {}
+		constexpr vec4a(const vec4& v) : vec4(v) {}
+	};
+
+	static_assert(sizeof(vec3a) == 16 && alignof(vec3a) == 16, "vec3a must be 16 bytes, 16-byte aligned");
+	static_assert(sizeof(vec4a) == 16 && alignof(vec4a) == 16, "vec4a must be 16 bytes, 16-byte aligned");
+	static_assert(std::is_trivially_copyable<vec3a>::value, "vec3a must be trivially copyable");
+	static_assert(std::is_trivially_copyable<vec4a>::value, "vec4a must be trivially copyable");
+
+	//----------------------------------------------------------------------------
+
+}  // namespace Angel
+
+#endif // __ANGEL_VEC_H__
@@ -0,0 +1,29 @@
+﻿# 把工程目录下的所有 .glsl 生成为 EmbeddedShaders.h(原始字符串常量)，
+# 供 InitShader.cpp 在 ANGEL_EMBED_SHADERS 模式下使用，运行时不再读取 shader 文件
+# 用法：powershell -NoProfile -ExecutionPolicy Bypass -File EmbedShaders.ps1 <工程目录>
+# 工程以 msbuild /p:EmbedShaders=true 生成时由生成前事件自动调用
+param([string]$ProjectDir = ".")
+
+$lines = @(
+    "// 由 EmbedShaders.ps1 根据工程目录下的 .glsl 文件生成，不要手工修改",
+    "static const EmbeddedShader EmbeddedShaders[] =",
+    "{"
+)
+foreach ($file in Get-ChildItem -Path $ProjectDir -Filter *.glsl | Sort-Object Name)
+{
+    $text = [IO.File]::ReadAllText($file.FullName)   # 按 UTF-8 读取，去掉 BOM
+    if ($text.Contains(')glsl"'))
+    {
+        throw "$($file.Name) contains the raw string delimiter )glsl`""
+    }
+    $lines += "`t{ `"$($file.Name)`", R`"glsl($text)glsl`" },"
+}
+$lines += "};"
+
+$output = Join-Path $ProjectDir "EmbeddedShaders.h"
+$content = ($lines -join "`r`n") + "`r`n"
+# 内容不变时不改写，避免每次生成都重新编译 InitShader.cpp
+if (!(Test-Path $output) -or [IO.File]::ReadAllText($output) -ne $content)
+{
+    [IO.File]::WriteAllText($output, $content, (New-Object Text.UTF8Encoding $true))
+}
@@ -19,8 +19,7 @@
 typedef vec3 point3;
 typedef vec4 color4;
 
-point3* sphere;			// 存放一个球的顶点坐标数据的指针
-GLsizei NumVertices;	// 球的顶点数
+const MeshBuffers* sphere;	// 球的顶点和索引缓冲区
 
 float RotateAngle = 0.0f;		// 绕y轴旋转的角度
 float AngleStepSize = 10.0f;
@@ -47,6 +46,9 @@ GLuint MVMatrixLight;	// Light Shader 中 uniform 变量 MVMatrix 的索引
 
 mat4 proj;	// 投影矩阵
 
+// 球的南北极在z轴方向，绕x轴旋转90度使其沿y轴；常量矩阵在编译期求值
+constexpr mat4 matRotateX90 = RotateX(90.0);
+
 bool useBlinnPhong = false; // Blinn-Phong
 bool useLine = false; // 线框模式
 bool useAmbieni = true; // 使用环境光
@@ -58,177 +60,73 @@ vec3 lightPos = vec3(2.0f, 2.0f, 2.0);
 
 MatrixStack matStack;
 
-// 用于生成一个中心在原点的球的顶点坐标数据(南北极在z轴方向)
-// 返回值为球的顶点数，参数为球的半径及经线和纬线数
-GLsizei BuildSphere(GLfloat radius, GLsizei columns, GLsizei rows)
+// 参数为球的半径及经线和纬线数
+// 球的顶点和索引只上传一次(MeshCache)，不需要 shader，可以在 shader 编译期间进行
+void InitSphere(GLfloat radius, GLsizei columns, GLsizei rows)
 {
-	int index = 0;	// 数组索引
-	point3* vertices = new point3[(rows + 1) * (columns + 1)]; // 存放不同顶点的数组
-
-	for (int r = 0; r <= rows; r++)
-	{
-		float v = (float)r / (float)rows;  // [0,1]
-		float theta1 = v * (float)M_PI;	   // [0,PI]
-
-		point3 temp(0, 0, 1);
-		point3 n = temp;
-		GLfloat cosTheta1 = cos(theta1);
-		GLfloat sinTheta1 = sin(theta1);
-		n.x = temp.x * cosTheta1 + temp.z * sinTheta1;
-		n.z = -temp.x * sinTheta1 + temp.z * cosTheta1;
-
-		for (int c = 0; c <= columns; c++)
-		{
-			float u = (float)c / (float)columns; // [0,1]
-			float theta2 = u * (float)(M_PI * 2); // [0,2PI]
-			point3 pos = n;
-			temp = n;
-			GLfloat cosTheta2 = cos(theta2);
-			GLfloat sinTheta2 = sin(theta2);
-
-			pos.x = temp.x * cosTheta2 - temp.y * sinTheta2;
-			pos.y = temp.x * sinTheta2 + temp.y * cosTheta2;
-
-			point3 posFull = pos;
-			posFull *= radius;
-
-			vertices[index++] = posFull;
-		}
-	}
-
-	/*生成最终顶点数组数据*/
-	if (sphere)
-	{
-		delete[] sphere;	// 如果sphere已经有数据，先回收
-	}
-	int numVertices = rows * columns * 6; // 顶点数
-	sphere = new point3[numVertices];
-
-	int colLength = columns + 1;
-	index = 0;
-	for (int r = 0; r < rows; r++)
-	{
-		int offset = r * colLength;
-
-		for (int c = 0; c < columns; c++)
-		{
-			int ul = offset + c;						// 左上
-			int ur = offset + c + 1;					// 右上
-			int br = offset + (c + 1 + colLength);	// 右下
-			int bl = offset + (c + 0 + colLength);	// 左下
-
-			// 由两条经线和纬线围成的矩形
-			sphere[index++] = vertices[ul];
-			sphere[index++] = vertices[bl];
-			sphere[index++] = vertices[br];
-			sphere[index++] = vertices[ul];
-			sphere[index++] = vertices[br];
-			sphere[index++] = vertices[ur];
-		}
-	}
-
-	delete[] vertices;
-
-	return numVertices;
+	sphere = &MeshCache::Sphere(radius, columns, rows);
 }
 
-void InitSphere(GLuint numVertices)
+// 两个程序的 VAO 共用球的缓冲区，需要 shader 中属性变量的位置
+void InitSphereArrays()
 {
 	glUseProgram(programPhong);
 
-	glGenVertexArrays(1, &vaoSphere);
-	glBindVertexArray(vaoSphere);
-	GLuint buffSphere;
-	glGenBuffers(1, &buffSphere);
-	glBindBuffer(GL_ARRAY_BUFFER, buffSphere);
-	glBufferData(GL_ARRAY_BUFFER,
-		sizeof(point3) * numVertices,
-		sphere,
-		GL_STATIC_DRAW);
-
-
-	glEnableVertexAttribArray(vPosition);
-	glVertexAttribPointer(vPosition,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		0,
-		BUFFER_OFFSET(0));
-
-	glEnableVertexAttribArray(vNormal);
-	glVertexAttribPointer(vNormal,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		0,
-		BUFFER_OFFSET(0));
+	// 球心在原点，法向即位置(shader 中只取 xyz)
+	vaoSphere = sphere->vertexArray({ { vPosition, "position" }, { vNormal, "position" } });
 
 
 	glUseProgram(programLight);
 
-	glGenVertexArrays(1, &vaoSphereLight);
-	glBindVertexArray(vaoSphereLight);
-	GLuint buffSphereLight;
-	glGenBuffers(1, &buffSphereLight);
-	glBindBuffer(GL_ARRAY_BUFFER, buffSphereLight);
-	glBufferData(GL_ARRAY_BUFFER,
-		sizeof(point3) * numVertices,
-		sphere,
-		GL_STATIC_DRAW);
-
-	glEnableVertexAttribArray(vPositionLight);
-	glVertexAttribPointer(vPositionLight,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		0,
-		BUFFER_OFFSET(0));
-
-
-	delete[] sphere;
-
+	vaoSphereLight = sphere->vertexArray(vPositionLight);
 }
 
 // 初始化OpenGL的状态
 void Init(void)
 {
-	// 生成中心在原点半径为1,15条经线和纬线的球的顶点
-	NumVertices = BuildSphere(1.0, 15, 15);
-
 	/*加载shader并使用所得到的shader程序*/
-	// InitShader为InitShader.cpp中定义的函数，参数分别为顶点和片元shader的文件名
-	// 返回值为shader程序对象的ID
-	programPhong = InitShader("vPhong.glsl", "fPhong.glsl");
+	// InitShaderAsync为InitShader.cpp中定义的函数，参数分别为顶点和片元shader的文件名
+	// 两个程序先一起提交并行编译，第一次使用时再用 get() 取得shader程序对象的ID
+	ShaderFuture phong = InitShaderAsync("vPhong.glsl", "fPhong.glsl");
+	ShaderFuture light = InitShaderAsync("vLight.glsl", "fLight.glsl");
+
+	// 编译期间生成球：中心在原点半径为1,15条经线和纬线的球
+	InitSphere(1.0, 15, 15);
+
+	programPhong = phong.get();
 	glUseProgram(programPhong); // 使用该shader程序
+	// 修改 .glsl 后自动重新编译，uniform 变量的索引也随之更新
+	WatchShader(programPhong, "vPhong.glsl", "fPhong.glsl");
 
 
 	vPosition = glGetAttribLocation(programPhong, "vPosition");
 	vNormal = glGetAttribLocation(programPhong, "vNormal");
 
 	// 获取shader中uniform变量的索引
-	PMatrix = glGetUniformLocation(programPhong, "PMatrix");
-	MVMatrix = glGetUniformLocation(programPhong, "MVMatrix");
-	LightPos = glGetUniformLocation(programPhong, "LightPos");
-	ViewPos = glGetUniformLocation(programPhong, "ViewPos");
+	WatchUniform(programPhong, "PMatrix", PMatrix);
+	WatchUniform(programPhong, "MVMatrix", MVMatrix);
+	WatchUniform(programPhong, "LightPos", LightPos);
+	WatchUniform(programPhong, "ViewPos", ViewPos);
 	// 默认使用 Phong 模型
-	blinn = glGetUniformLocation(programPhong, "blinn");
-	bAmbieni = glGetUniformLocation(programPhong, "bAmbieni");
-	bDiffuse = glGetUniformLocation(programPhong, "bDiffuse");
-	bSpecular = glGetUniformLocation(programPhong, "bSpecular");
+	WatchUniform(programPhong, "blinn", blinn);
+	WatchUniform(programPhong, "bAmbieni", bAmbieni);
+	WatchUniform(programPhong, "bDiffuse", bDiffuse);
+	WatchUniform(programPhong, "bSpecular", bSpecular);
 
 	glUniform1i(bAmbieni, useAmbieni ? 1 : 0);
 	glUniform1i(bDiffuse, useDiffuse ? 1 : 0);
 	glUniform1i(bSpecular, useSpecular ? 1 : 0);
 
-	programLight = InitShader("vLight.glsl", "fLight.glsl");
+	programLight = light.get();
 	glUseProgram(programLight); // 使用该shader程序
+	WatchShader(programLight, "vLight.glsl", "fLight.glsl");
 
 	vPositionLight = glGetAttribLocation(programLight, "vPosition");
-	PMatrixLight = glGetUniformLocation(programLight, "PMatrix");
-	MVMatrixLight = glGetUniformLocation(programLight, "MVMatrix");
+	WatchUniform(programLight, "PMatrix", PMatrixLight);
+	WatchUniform(programLight, "MVMatrix", MVMatrixLight);
 
 
-	InitSphere(NumVertices);
+	InitSphereArrays();
 
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);	// 线框模式
 
@@ -260,12 +158,12 @@ void Display(void)
 
 	matStack.push(mv);
 	//mv *= Translate(viewPos) * RotateY(RotateAngle); // 构建 View Matrix
-	mv *= Rotate(90, 1.0f, 0.0f, 0.0f);
+	mv *= matRotateX90;
 	glUseProgram(programPhong);
 	glBindVertexArray(vaoSphere);
 	glUniformMatrix4fv(MVMatrix, 1, GL_TRUE, mv);
 	glUniformMatrix4fv(PMatrix, 1, GL_TRUE, proj); // 传模视投影矩阵
-	glDrawArrays(GL_TRIANGLES, 0, NumVertices);
+	sphere->draw();
 	mv = matStack.pop();
 
 	mv *= Rotate(RotateAngle, 0.0, 1.0, 0.0);
@@ -282,7 +180,7 @@ void Display(void)
 	//glUniformMatrix4fv(PMatrix, 1, GL_TRUE, proj); // 传模视投影矩阵
 	glUniformMatrix4fv(MVMatrixLight, 1, GL_TRUE, mv * Scale(0.1, 0.1, 0.1));
 	glUniformMatrix4fv(PMatrixLight, 1, GL_TRUE, proj); // 传模视投影矩阵
-	glDrawArrays(GL_TRIANGLES, 0, NumVertices);
+	sphere->draw();
 
 	// 观察者位于原点
 	glUniform3f(ViewPos, 0, 0, 0);
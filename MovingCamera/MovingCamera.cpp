@@ -15,8 +15,8 @@
 #include "Angel.h"
 
 const int NUM_SPHERES = 50;
-const float MIN_POS = -20.f;
-const float MAX_POS = 20.f;
+const float EYE_HEIGHT = 0.4f;		// 相机(以及球心)离地面的高度
+const float VIEW_DISTANCE = 600.f;	// 视距，也是透视投影的远平面
 
 typedef vec3 point3;
 
@@ -24,11 +24,8 @@ MatrixStack MVPStack;		// 模视投影矩阵栈
 mat4 matProj;	// 投影矩阵
 mat4 matCamera; // 相机变换矩阵
 
-// 在每次 matCamera 左乘一个最新变换的时候
-// matReverse都右乘一个最新变换的逆变换
-// 这样可保证matReverse始终都是matCamera的逆矩阵
-// 当前照相机在世界坐标系下的位置就是(matReverse[0][3], matReverse[1][3], matReverse[2][3])
-mat4 matReverse; // 相机变换逆矩阵 用于计算相机位置
+// 球和环的南北极在z轴方向，绕x轴旋转90度使其沿y轴；常量矩阵在编译期求值
+constexpr mat4 matRotateX90 = RotateX(90.0);
 
 /*shader中变量索引*/
 GLuint vPosition;  // shader中in变量vPosition的索引
@@ -36,238 +33,55 @@ GLuint MVPMatrix;  // shader中uniform变量MVPMatrix的索引
 
 bool bUseLine = false; // 使用线框模式
 
-// 地面
-point3* ptGround;
-GLuint numVerticesGround;
-GLuint vaoGround;
+// 地形：4097 x 4097 个采样点，间距 1 米，按到相机的距离分块选择 LOD
+// 每帧最多画 30 万个顶点(全分辨率为 1680 万个)
+// 高度场约 67 MB，在 InitGround 中生成，不放在全局对象的构造里拖慢启动
+HeightMap heightMap;
+Terrain* terrain;
 
 // 球
-point3* ptSphere;
-GLuint numVerticesSphere;
+const MeshBuffers* sphere;
 GLuint vaoSphere;
 point3 spheres[NUM_SPHERES];
 
 GLfloat yRot = 0.0f;
 
 // 圆环
-point3* ptTorus;
-GLuint numVerticesTorus;
+const MeshBuffers* torus;
 GLuint vaoTorus;
 
 enum { UP, DOWN, LEFT, RIGHT, NUM_KEY };
 bool KeyDown[NUM_KEY];
 
-// 构建 y = 0 且中心为原点平面
-// fExtent 地面范围
-// fStep 间隔
-void BuildGround(GLfloat fExtent, GLfloat fStep)
-{
-	numVerticesGround = (2 * fExtent / fStep + 1) * 4;
-	ptGround = new point3[numVerticesGround];
-	int index = 0;
-	for (GLint iLine = -fExtent; iLine <= fExtent; iLine += fStep)
-	{
-		ptGround[index++] = point3(iLine, 0, fExtent);
-		ptGround[index++] = point3(iLine, 0, -fExtent);
-		ptGround[index++] = point3(fExtent, 0, iLine);
-		ptGround[index++] = point3(-fExtent, 0, iLine);
-	}
-}
-
+// 几何体由 MeshCache 生成并上传，这里只创建本程序的 VAO
+// 地形的 VAO 和缓冲区由 Terrain 自己管理，块在走近时才上传
 void InitGround()
 {
-	BuildGround(MAX_POS, 1.0);
-
-	glGenVertexArrays(1, &vaoGround);
-	glBindVertexArray(vaoGround);
-
-	GLuint buffGround;
-	glGenBuffers(1, &buffGround);
-	glBindBuffer(GL_ARRAY_BUFFER, buffGround);
-	glBufferData(GL_ARRAY_BUFFER,
-		sizeof(point3) * numVerticesGround,
-		ptGround,
-		GL_STATIC_DRAW);
-
-	delete[] ptGround;
-
-	glEnableVertexAttribArray(vPosition);
-	glVertexAttribPointer(vPosition, 3, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(0));
-}
-
-// 创建球体函数：
-// 用于生成一个中心在原点的球的顶点坐标数据(南北极在z轴方向)
-// 参数为球的半径及经线和纬线数
-void BuildSphere(GLfloat radius, GLsizei columns, GLsizei rows)
-{
-	int index = 0;	// 数组索引
-	point3* vertices = new point3[(rows + 1) * (columns + 1)]; // 存放不同顶点的数组
-
-	for (int r = 0; r <= rows; r++)
-	{
-		float v = (float)r / (float)rows;  // [0,1]
-		float theta1 = v * (float)M_PI;	   // [0,PI]
-
-		point3 temp(0, 0, 1);
-		point3 n = temp;
-		GLfloat cosTheta1 = cos(theta1);
-		GLfloat sinTheta1 = sin(theta1);
-		n.x = temp.x * cosTheta1 + temp.z * sinTheta1;
-		n.z = -temp.x * sinTheta1 + temp.z * cosTheta1;
-
-		for (int c = 0; c <= columns; c++)
-		{
-			float u = (float)c / (float)columns; // [0,1]
-			float theta2 = u * (float)(M_PI * 2); // [0,2PI]
-			point3 pos = n;
-			temp = n;
-			GLfloat cosTheta2 = cos(theta2);
-			GLfloat sinTheta2 = sin(theta2);
-
-			pos.x = temp.x * cosTheta2 - temp.y * sinTheta2;
-			pos.y = temp.x * sinTheta2 + temp.y * cosTheta2;
-
-			point3 posFull = pos;
-			posFull *= radius;
-
-			vertices[index++] = posFull;
-		}
-	}
-
-	/*生成最终顶点数组数据*/
-	if (ptSphere)
-	{
-		delete[] ptSphere;	// 如果sphere已经有数据，先回收
-
-	}
-
-	numVerticesSphere = rows * columns * 6; // 顶点数
-	ptSphere = new point3[numVerticesSphere];
-
-	int colLength = columns + 1;
-	index = 0;
-	for (int r = 0; r < rows; r++)
-	{
-		int offset = r * colLength;
-
-		for (int c = 0; c < columns; c++)
-		{
-			int ul = offset + c;						// 左上
-			int ur = offset + c + 1;					// 右上
-			int br = offset + (c + 1 + colLength);	// 右下
-			int bl = offset + (c + 0 + colLength);	// 左下
-
-			// 由两条经线和纬线围成的矩形
-			ptSphere[index++] = vertices[ul];
-			ptSphere[index++] = vertices[bl];
-			ptSphere[index++] = vertices[br];
-			ptSphere[index++] = vertices[ul];
-			ptSphere[index++] = vertices[br];
-			ptSphere[index++] = vertices[ur];
-		}
-	}
-
-	delete[]vertices;
+	heightMap = HeightMap::Fractal(12, 1.0f, 200.0f);
+	terrain = new Terrain(heightMap, VIEW_DISTANCE, 64.0f, 300000);
+	terrain->init(vPosition);
 }
 
 void InitSphere()
 {
 	for (int iSphere = 0; iSphere < NUM_SPHERES; iSphere++)
 	{
-		// 在 -20 到 20 以一米 为步长随机生成一个位置
+		// 在 -20 到 20 以一米 为步长随机生成一个位置，放在地面上方
 		float x = (float)((rand() % 400) - 200) * 0.1f;
 		float z = (float)((rand() % 400) - 200) * 0.1f;
-		spheres[iSphere].x = x;
-		spheres[iSphere].z = z;
+		spheres[iSphere] = point3(x, heightMap.height(x, z) + EYE_HEIGHT, z);
 	}
 
-	BuildSphere(0.2, 15, 15);
+	sphere = &MeshCache::Sphere(0.2, 15, 15);
 
-	glGenVertexArrays(1, &vaoSphere);
-	glBindVertexArray(vaoSphere);
-	GLuint buffSphere;
-	glGenBuffers(1, &buffSphere);
-	glBindBuffer(GL_ARRAY_BUFFER, buffSphere);
-	glBufferData(GL_ARRAY_BUFFER,
-		sizeof(point3) * numVerticesSphere,
-		ptSphere,
-		GL_STATIC_DRAW);
-
-	delete[] ptSphere;
-
-	glEnableVertexAttribArray(vPosition);
-	glVertexAttribPointer(vPosition,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		0,
-		BUFFER_OFFSET(0));
-}
-
-// 构建中心在原点的圆环(由三角形构建)
-// 参数分别为圆环的主半径(决定环的大小)，圆环截面圆的半径(决定环的粗细)，
-// numMajor和numMinor决定模型精细程度
-void BuildTorus(GLfloat majorRadius, GLfloat minorRadius, GLint numMajor, GLint numMinor)
-{
-	if (ptTorus)
-		delete[] ptTorus;	// 如果ptTorus已经有数据，先回收
-	numVerticesTorus = numMajor * numMinor * 6; // 顶点数
-	ptTorus = new point3[numVerticesTorus];
-
-	double majorStep = 2.0f * M_PI / numMajor;
-	double minorStep = 2.0f * M_PI / numMinor;
-
-	int index = 0;
-	for (int i = 0; i < numMajor; ++i)
-	{
-		double a0 = i * majorStep;
-		double a1 = a0 + majorStep;
-		GLfloat x0 = (GLfloat)cos(a0);
-		GLfloat y0 = (GLfloat)sin(a0);
-		GLfloat x1 = (GLfloat)cos(a1);
-		GLfloat y1 = (GLfloat)sin(a1);
-
-		for (int j = 0; j < numMinor; ++j)
-		{
-			double b0 = j * minorStep;
-			double b1 = b0 + minorStep;
-			GLfloat c0 = (GLfloat)cos(b0);
-			GLfloat r0 = minorRadius * c0 + majorRadius;
-			GLfloat z0 = minorRadius * (GLfloat)sin(b0);
-			GLfloat c1 = (GLfloat)cos(b1);
-			GLfloat r1 = minorRadius * c1 + majorRadius;
-			GLfloat z1 = minorRadius * (GLfloat)sin(b1);
-
-			point3 left0 = point3(x0 * r0, y0 * r0, z0);
-			point3 right0 = point3(x1 * r0, y1 * r0, z0);
-			point3 left1 = point3(x0 * r1, y0 * r1, z1);
-			point3 right1 = point3(x1 * r1, y1 * r1, z1);
-			ptTorus[index++] = left0;
-			ptTorus[index++] = right0;
-			ptTorus[index++] = left1;
-			ptTorus[index++] = left1;
-			ptTorus[index++] = right0;
-			ptTorus[index++] = right1;
-		}
-	}
+	vaoSphere = sphere->vertexArray(vPosition);
 }
 
 void InitTorus()
 {
-	BuildTorus(0.35, 0.15, 40, 20);
-
-	glGenVertexArrays(1, &vaoTorus);
-	glBindVertexArray(vaoTorus);
-
-	GLuint buffTorus;
-	glGenBuffers(1, &buffTorus);
-	glBindBuffer(GL_ARRAY_BUFFER, buffTorus);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(point3) * numVerticesTorus, ptTorus, GL_STATIC_DRAW);
-
-	delete[] ptTorus;
+	torus = &MeshCache::Torus(0.35, 0.15, 40, 20);
 
-	glEnableVertexAttribArray(vPosition);
-	glVertexAttribPointer(vPosition, 3, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(0));
+	vaoTorus = torus->vertexArray(vPosition);
 }
 
 
@@ -304,63 +118,66 @@ void Init()
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA); // 设置为混合模式
 }
 
+// 当前照相机在世界坐标系下的位置，即相机变换逆矩阵的平移部分
+// 需要时再由 matCamera 求得，不再额外维护一个逆矩阵
+vec3 CameraPosition()
+{
+	mat4 matInverse = affineInverse(matCamera);
+	return vec3(matInverse[0][3], matInverse[1][3], matInverse[2][3]);
+}
+
 void SetLegalPos()
 {
-	// 相机移动范围 [-20, 20]
-	if (matReverse[0][3] < MIN_POS)
+	// 相机移动范围为整个地形，高度保持在地面上方 EYE_HEIGHT 处
+	vec3 pos = CameraPosition();
+	float maxPos = 0.5f * heightMap.extent();
+	float deltaX = 0.0f;
+	float deltaZ = 0.0f;
+
+	if (pos.x < -maxPos)
 	{
-		float deltaX = MIN_POS - matReverse[0][3];
-		matCamera = Translate(-deltaX, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(deltaX, 0.0, 0.0);
+		deltaX = -maxPos - pos.x;
 	}
-
-	if (matReverse[0][3] > MAX_POS)
+	else if (pos.x > maxPos)
 	{
-		float deltaX = MAX_POS - matReverse[0][3];
-		matCamera = Translate(-deltaX, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(deltaX, 0.0, 0.0);
+		deltaX = maxPos - pos.x;
 	}
 
-	if (matReverse[2][3] < MIN_POS)
+	if (pos.z < -maxPos)
 	{
-		float deltaX = MIN_POS - matReverse[2][3];
-		matCamera = Translate(0.0, 0.0, -deltaX) * matCamera;
-		matReverse *= Translate(0.0, 0.0, deltaX);
+		deltaZ = -maxPos - pos.z;
 	}
+	else if (pos.z > maxPos)
+	{
+		deltaZ = maxPos - pos.z;
+	}
+
+	float deltaY = heightMap.height(pos.x + deltaX, pos.z + deltaZ) + EYE_HEIGHT - pos.y;
 
-	if (matReverse[2][3] > MAX_POS)
+	if (deltaX != 0.0f || deltaY != 0.0f || deltaZ != 0.0f)
 	{
-		float deltaX = MAX_POS - matReverse[2][3];
-		matCamera = Translate(0.0, 0.0, -deltaX) * matCamera;
-		matReverse *= Translate(0.0, 0.0, deltaX);
+		matCamera = Translate(-deltaX, -deltaY, -deltaZ) * matCamera;
 	}
 }
 
 void UpdateCamera()
 {
-	// 在每次 matCamera 左乘一个最新变换的时候
-	// matReverse 都右乘一个最新变换的逆变换
-	// 这样可保证matReverse始终都是 matCamera 的逆矩阵
-	// 当前照相机在世界坐标系下的位置就是(matReverse[0][3], matReverse[1][3], matReverse[2][3])
+	// 每次移动都左乘到 matCamera 上，相机位置由 CameraPosition() 按需求得
 	if (KeyDown[UP])
 	{
 		matCamera = Translate(0.0, 0.0, 0.1) * matCamera;
-		matReverse *= Translate(0.0, 0.0, -0.1);
 	}
 	if (KeyDown[DOWN])
 	{
 		matCamera = Translate(0.0, 0.0, -0.1) * matCamera;
-		matReverse *= Translate(0.0, 0.0, 0.1);
 	}
 	if (KeyDown[LEFT])
 	{
 		matCamera = Translate(0.1, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(-0.1, 0.0, 0.0);
 	}
 	if (KeyDown[RIGHT])
 	{
 		matCamera = Translate(-0.1, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(0.1, 0.0, 0.0);
 	}
 
 	SetLegalPos();
@@ -377,41 +194,38 @@ void RenderScene()
 
 	mat4 matMVP = matProj * matCamera;
 
-	// 绘制地面
-	MVPStack.push(matMVP);
-	matMVP *= Translate(0.0, -0.4, 0.0);
-	glBindVertexArray(vaoGround);
-	glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, matMVP);
-	glDrawArrays(GL_LINES, 0, numVerticesGround);
-	matMVP = MVPStack.pop();
+	// 绘制地形，每块的顶点坐标相对于块的原点
+	terrain->draw(CameraPosition(), [&](const vec3& origin) {
+		glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, matMVP * Translate(origin));
+	});
 
 	// 绘制球
 	glBindVertexArray(vaoSphere);
 	for (int iSphere = 0; iSphere < NUM_SPHERES; iSphere++)
 	{
 		MVPStack.push(matMVP);
-		matMVP *= Translate(spheres[iSphere].x, 0.0, spheres[iSphere].z);
-		matMVP *= Rotate(90, 1.0, 0.0, 0.0);
+		matMVP *= Translate(spheres[iSphere]);
+		matMVP *= matRotateX90;
 		glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, matMVP);
-		glDrawArrays(GL_TRIANGLES, 0, numVerticesSphere);
+		sphere->draw();
 		matMVP = MVPStack.pop();
 	}
 
-	matMVP *= Translate(0.0, 0.0, -2.5f);
+	matMVP *= Translate(0.0, heightMap.height(0.0f, -2.5f) + EYE_HEIGHT, -2.5f);
 	// 旋转的球
 	MVPStack.push(matMVP);
 	matMVP *= Rotate(yRot, 0.0f, 1.0f, 0.0f);
 	matMVP *= Translate(1.0, 0.0f, 0.0f);
-	matMVP *= Rotate(90, 1.0f, 0.0f, 0.0f);
+	matMVP *= matRotateX90;
 	glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, matMVP);
-	glDrawArrays(GL_TRIANGLES, 0, numVerticesSphere);
+	sphere->draw();
 	matMVP = MVPStack.pop();
 
 	// 圆环
 	matMVP *= Rotate(-yRot, 0.0f, 1.0f, 0.0f);
 	glBindVertexArray(vaoTorus);
 	glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, matMVP);
-	glDrawArrays(GL_TRIANGLES, 0, numVerticesTorus);
+	torus->draw();
 
 	// 交换缓存
 	glutSwapBuffers();
@@ -429,7 +243,7 @@ void ChangeSize(int w, int h)
 	GLfloat fAspect = (GLfloat)w / (GLfloat)h;	// 计算窗口宽高比
 
 	// 设置透视投影视域体
-	matProj = Perspective(35.0f, fAspect, 1.0f, 50.0f);
+	matProj = Perspective(35.0f, fAspect, 1.0f, VIEW_DISTANCE);
 }
 
 void MyKeyDown(unsigned char key, int x, int y)
@@ -493,27 +307,19 @@ void MyKeyUp(unsigned char key, int x, int y)
 
 void SpecialKeys(int key, int x, int y)
 {
-	// 在每次 matCamera 左乘一个最新变换的时候
-	// matReverse都右乘一个最新变换的逆变换
-	// 这样可保证 matReverse 始终都是 matCamera 的逆矩阵
-	// 当前照相机在世界坐标系下的位置就是(matReverse[0][3], matReverse[1][3], matReverse[2][3])
 	switch (key)
 	{
 	case GLUT_KEY_UP:
 		matCamera = Translate(0.0, 0.0, 0.1) * matCamera;
-		matReverse *= Translate(0.0, 0.0, -0.1);
 		break;
 	case GLUT_KEY_DOWN:
 		matCamera = Translate(0.0, 0.0, -0.1) * matCamera;
-		matReverse *= Translate(0.0, 0.0, 0.1);
 		break;
 	case GLUT_KEY_LEFT:
 		matCamera = Translate(0.1, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(-0.1, 0.0, 0.0);
 		break;
 	case GLUT_KEY_RIGHT:
 		matCamera = Translate(-0.1, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(0.1, 0.0, 0.0);
 		break;
 	}
 	glutPostRedisplay();
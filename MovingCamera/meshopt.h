@@ -0,0 +1,289 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+//
+//  --- meshopt.h ---
+//  三角形索引的重排，在生成索引之后、上传之前进行，不改变网格的形状
+//
+//   AnalyzeVertexCache    模拟 FIFO 顶点缓存，统计 ACMR(每个三角形的缓存缺失数)
+//                         和 ATVR(每个顶点被变换的次数)，理想值分别约为 0.5 和 1.0
+//   OptimizeVertexCache   Tipsify 算法(Sander 等, 2007)重排三角形，提高顶点缓存命中率，
+//                         同时输出簇的边界(算法找不到相邻三角形、需要跳转的位置)
+//   OptimizeOverdraw      以簇为单位重排：朝外的簇先画，被遮挡的片元尽早被深度测试剔除
+//   OptimizeVertexFetch   按首次使用的顺序重排顶点，使顶点读取尽量连续，并丢弃未使用的顶点
+//
+//   IndexedMesh 的整套优化见 mesh.h 中的 OptimizeMesh
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ANGEL_MESHOPT_H__
+#define __ANGEL_MESHOPT_H__
+
+#include <algorithm>
+#include <vector>
+#include "vec.h"
+
+namespace Angel
+{
+
+	// 默认模拟的顶点缓存大小(后变换缓存的条目数)
+	const unsigned VertexCacheSize = 16;
+
+	struct VertexCacheStats
+	{
+		size_t  transformed;	// 缓存缺失的次数，即顶点着色器的执行次数
+		GLfloat acmr;			// transformed / 三角形数
+		GLfloat atvr;			// transformed / 用到的顶点数
+	};
+
+	// 模拟大小为 cacheSize 的 FIFO 顶点缓存
+	inline VertexCacheStats AnalyzeVertexCache(span<const GLuint> indices, size_t vertexCount,
+		unsigned cacheSize = VertexCacheSize)
+	{
+		// 记录每个顶点进入缓存的时间，时间差不超过 cacheSize 即仍在缓存中
+		std::vector<size_t> cacheTime(vertexCount, 0);
+		std::vector<bool> used(vertexCount, false);
+		size_t time = cacheSize + 1;
+		size_t unique = 0;
+
+		VertexCacheStats stats = { 0, 0.0f, 0.0f };
+		for (GLuint v : indices)
+		{
+			if (time - cacheTime[v] > cacheSize)
+			{
+				cacheTime[v] = time++;
+				stats.transformed++;
+			}
+			if (!used[v])
+			{
+				used[v] = true;
+				unique++;
+			}
+		}
+
+		size_t triangles = indices.size() / 3;
+		stats.acmr = triangles ? (GLfloat)stats.transformed / triangles : 0.0f;
+		stats.atvr = unique ? (GLfloat)stats.transformed / unique : 0.0f;
+		return stats;
+	}
+
+	// Tipsify：从一个顶点出发画完它周围所有未画的三角形(扇形)，再从刚用过、仍在缓存中的顶点里
+	// 选下一个扇形的中心；都不合适时退回最近用过且还有三角形的顶点，再不行就顺序找下一个
+	// 返回重排后的索引；clusters 不为 NULL 时存放每个簇第一个三角形的序号
+	inline std::vector<GLuint> OptimizeVertexCache(span<const GLuint> indices, size_t vertexCount,
+		std::vector<size_t>* clusters = NULL, unsigned cacheSize = VertexCacheSize)
+	{
+		size_t triangleCount = indices.size() / 3;
+
+		// 顶点 -> 三角形的邻接表(按顶点计数后压缩存放)
+		std::vector<GLuint> live(vertexCount, 0);	// 每个顶点还未画的三角形数
+		for (GLuint v : indices)
+		{
+			live[v]++;
+		}
+		std::vector<size_t> adjOffset(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			adjOffset[v + 1] = adjOffset[v] + live[v];
+		}
+		std::vector<GLuint> adj(indices.size());
+		std::vector<size_t> fill(adjOffset.begin(), adjOffset.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			adj[fill[indices[i]]++] = (GLuint)(i / 3);
+		}
+
+		std::vector<size_t> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<GLuint> deadEnd;		// 最近用过的顶点(栈)
+		std::vector<GLuint> candidates;
+		std::vector<GLuint> result;
+		result.reserve(indices.size());
+
+		size_t time = cacheSize + 1;
+		size_t cursor = 0;					// 顺序查找的位置
+		long fan = vertexCount ? 0 : -1;	// 当前扇形的中心
+		bool jumped = true;					// 中心不是从缓存中选出的，开始一个新簇
+
+		while (fan >= 0)
+		{
+			if (jumped && clusters && live[fan] > 0)
+			{
+				clusters->push_back(result.size() / 3);
+			}
+
+			candidates.clear();
+			for (size_t a = adjOffset[fan]; a < adjOffset[fan + 1]; a++)
+			{
+				GLuint t = adj[a];
+				if (emitted[t])
+				{
+					continue;
+				}
+				emitted[t] = true;
+
+				for (int k = 0; k < 3; k++)
+				{
+					GLuint v = indices[t * 3 + k];
+					result.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					live[v]--;
+					if (time - cacheTime[v] > cacheSize)
+					{
+						cacheTime[v] = time++;
+					}
+				}
+			}
+
+			// 在候选顶点中选下一个中心：画完它的三角形后仍留在缓存中的，取在缓存中最久的；
+			// 优先级为 0 的顶点会被挤出缓存，不选，没有合适的顶点时走下面的死路处理
+			long next = -1;
+			long best = 0;
+			for (GLuint v : candidates)
+			{
+				if (live[v] == 0)
+				{
+					continue;
+				}
+				long priority = 0;
+				if (time - cacheTime[v] + 2 * live[v] <= cacheSize)
+				{
+					priority = (long)(time - cacheTime[v]);
+				}
+				if (priority > best)
+				{
+					best = priority;
+					next = v;
+				}
+			}
+
+			jumped = (next < 0);
+			if (next < 0)
+			{
+				// 死路：先从最近用过的顶点中找，再顺序找
+				while (!deadEnd.empty() && next < 0)
+				{
+					GLuint v = deadEnd.back();
+					deadEnd.pop_back();
+					if (live[v] > 0)
+					{
+						next = v;
+					}
+				}
+				while (next < 0 && cursor < vertexCount)
+				{
+					if (live[cursor] > 0)
+					{
+						next = (long)cursor;
+					}
+					cursor++;
+				}
+			}
+			fan = next;
+		}
+
+		return result;
+	}
+
+	// 按簇重排三角形以减少过度绘制(簇内顺序不变，缓存命中率基本不受影响)
+	// 簇的得分为 dot(簇中心 - 网格中心, 簇的平均法向)，得分高(朝外)的簇先画
+	inline std::vector<GLuint> OptimizeOverdraw(span<const GLuint> indices, span<const vec3> positions,
+		const std::vector<size_t>& clusters)
+	{
+		size_t triangleCount = indices.size() / 3;
+		size_t clusterCount = clusters.size();
+		if (clusterCount < 2)
+		{
+			return std::vector<GLuint>(indices.begin(), indices.end());
+		}
+
+		// 以面积为权的网格中心
+		std::vector<vec3> centroid(clusterCount, vec3(0.0));
+		std::vector<vec3> normal(clusterCount, vec3(0.0));
+		std::vector<GLfloat> area(clusterCount, 0.0f);
+		vec3 meshCentroid(0.0);
+		GLfloat meshArea = 0.0f;
+
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			size_t end = c + 1 < clusterCount ? clusters[c + 1] : triangleCount;
+			for (size_t t = clusters[c]; t < end; t++)
+			{
+				const vec3& a = positions[indices[t * 3 + 0]];
+				const vec3& b = positions[indices[t * 3 + 1]];
+				const vec3& d = positions[indices[t * 3 + 2]];
+				vec3 n = cross(b - a, d - a);		// 长度为面积的两倍
+				GLfloat w = length(n);
+				vec3 center = (a + b + d) / 3.0;
+
+				centroid[c] += center * w;
+				normal[c] += n;
+				area[c] += w;
+			}
+			meshCentroid += centroid[c];
+			meshArea += area[c];
+		}
+		if (meshArea > 0.0f)
+		{
+			meshCentroid /= meshArea;
+		}
+
+		std::vector<GLfloat> score(clusterCount);
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			vec3 center = area[c] > 0.0f ? centroid[c] / area[c] : meshCentroid;
+			GLfloat len = length(normal[c]);
+			score[c] = len > 0.0f ? dot(center - meshCentroid, normal[c] / len) : 0.0f;
+		}
+
+		std::vector<size_t> order(clusterCount);
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			order[c] = c;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return score[a] > score[b]; });
+
+		std::vector<GLuint> result;
+		result.reserve(indices.size());
+		for (size_t c : order)
+		{
+			size_t end = c + 1 < clusterCount ? clusters[c + 1] : triangleCount;
+			result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+		}
+		return result;
+	}
+
+	// 按首次使用的顺序给顶点重新编号，直接改写 indices
+	// 返回旧编号 -> 新编号的映射(未使用的顶点为 ~0u)，newCount 为使用到的顶点数
+	inline std::vector<GLuint> OptimizeVertexFetch(span<GLuint> indices, size_t vertexCount, size_t& newCount)
+	{
+		std::vector<GLuint> remap(vertexCount, ~0u);
+		GLuint next = 0;
+		for (GLuint& v : indices)
+		{
+			if (remap[v] == ~0u)
+			{
+				remap[v] = next++;
+			}
+			v = remap[v];
+		}
+		newCount = next;
+		return remap;
+	}
+
+	// 按 OptimizeVertexFetch 返回的映射重排一个顶点属性数组
+	template <typename T>
+	std::vector<T> RemapVertices(const std::vector<T>& vertices, const std::vector<GLuint>& remap, size_t newCount)
+	{
+		std::vector<T> result(newCount);
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			if (remap[i] != ~0u)
+			{
+				result[remap[i]] = vertices[i];
+			}
+		}
+		return result;
+	}
+
+}  // namespace Angel
+
+#endif // __ANGEL_MESHOPT_H__
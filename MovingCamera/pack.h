@@ -0,0 +1,355 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+//
+//  --- pack.h ---
+//  顶点属性的压缩格式，以及对应的 glVertexAttribPointer 设置
+//
+//   half4          4 个半精度浮点数(8 字节)，用于位置等范围较大的数据，
+//                  绝对值不超过 2048 的整数可精确表示
+//   snorm16x2/x4   [-1, 1] 映射为 16 位有符号整数(4/8 字节)
+//   unorm8x4       [0, 1] 映射为 8 位无符号整数(4 字节)，用于颜色
+//   int2_10_10_10  x/y/z 各 10 位、w 2 位的有符号归一化数(4 字节)，用于法向，
+//                  需要 OpenGL 3.3 或 ARB_vertex_type_2_10_10_10_rev
+//   PackOctahedral 法向的八面体编码，存为 snorm16x2(4 字节)，OpenGL 3.1 即可使用，
+//                  shader 中用下面的函数解码：
+//
+//     vec3 DecodeOctahedral(vec2 e)
+//     {
+//         vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+//         if (n.z < 0.0)
+//             n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+//         return normalize(n);
+//     }
+//
+//   VertexAttribPointer<T>(index, stride, offset) 按 T 的格式设置顶点属性，
+//   分量个数、类型和是否归一化由 VertexFormat<T> 给出。
+//   有符号归一化数按 OpenGL 4.2 的规则 c / (2^(b-1) - 1) 编码，
+//   更早的版本按 (2c + 1) / (2^b - 1) 解码，两者相差不超过半个最低位
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ANGEL_PACK_H__
+#define __ANGEL_PACK_H__
+
+#include <string.h>
+#include <vector>
+#include "vec.h"
+
+namespace Angel
+{
+
+	//----------------------------------------------------------------------------
+	//
+	//  --- Scalar packing ---
+	//
+
+	// 单精度转半精度，就近舍入(偶数优先)，溢出为无穷大
+	inline GLushort PackHalf(GLfloat f)
+	{
+		GLuint u;
+		memcpy(&u, &f, sizeof(u));
+
+		GLuint sign = u & 0x80000000u;
+		u ^= sign;
+
+		GLushort h;
+		if (u >= 0x47800000u)		// 超出半精度范围、无穷大或 NaN
+		{
+			h = (u > 0x7F800000u) ? 0x7E00 : 0x7C00;
+		}
+		else if (u < 0x38800000u)	// 结果为非规格化数或 0：加上一个常数，由浮点加法完成移位和舍入
+		{
+			const GLuint magic = 0x3F000000u; // 0.5f
+			GLfloat m, r;
+			memcpy(&m, &magic, sizeof(m));
+			memcpy(&r, &u, sizeof(r));
+			r += m;
+			memcpy(&u, &r, sizeof(u));
+			h = (GLushort)(u - magic);
+		}
+		else
+		{
+			GLuint mantOdd = (u >> 13) & 1u;
+			u += 0xC8000FFFu + mantOdd; // 指数减去 112，再加上舍入偏移
+			h = (GLushort)(u >> 13);
+		}
+
+		return (GLushort)(h | (sign >> 16));
+	}
+
+	// 半精度转单精度(精确)
+	inline GLfloat UnpackHalf(GLushort h)
+	{
+		const GLuint shiftedExp = 0x7C00u << 13;
+		GLuint u = (GLuint)(h & 0x7FFF) << 13;
+		GLuint exp = u & shiftedExp;
+		u += (127 - 15) << 23;
+
+		GLfloat f;
+		if (exp == shiftedExp)		// 无穷大或 NaN
+		{
+			u += (128 - 16) << 23;
+			memcpy(&f, &u, sizeof(f));
+		}
+		else if (exp == 0)			// 0 或非规格化数
+		{
+			u += 1 << 23;
+			memcpy(&f, &u, sizeof(f));
+			f -= 6.103515625e-05f; // 2^-14
+		}
+		else
+		{
+			memcpy(&f, &u, sizeof(f));
+		}
+
+		return (h & 0x8000) ? -f : f;
+	}
+
+	// [-1, 1] -> [-32767, 32767]
+	inline constexpr GLshort PackSnorm16(GLfloat f)
+	{
+		return f >= 1.0f ? 32767 : f <= -1.0f ? -32767
+			: (GLshort)(f * 32767.0f + (f >= 0.0f ? 0.5f : -0.5f));
+	}
+
+	inline constexpr GLfloat UnpackSnorm16(GLshort s)
+	{
+		return s <= -32767 ? -1.0f : (GLfloat)s / 32767.0f;
+	}
+
+	// [0, 1] -> [0, 255]
+	inline constexpr GLubyte PackUnorm8(GLfloat f)
+	{
+		return f >= 1.0f ? 255 : f <= 0.0f ? 0 : (GLubyte)(f * 255.0f + 0.5f);
+	}
+
+	inline constexpr GLfloat UnpackUnorm8(GLubyte u)
+	{
+		return (GLfloat)u / 255.0f;
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  --- Packed vertex types ---
+	//
+
+	struct half4
+	{
+		GLushort  x;
+		GLushort  y;
+		GLushort  z;
+		GLushort  w;
+
+		constexpr half4() : x(0), y(0), z(0), w(0) {}
+
+		half4(GLfloat x, GLfloat y, GLfloat z, GLfloat w = 1.0) :
+			x(PackHalf(x)), y(PackHalf(y)), z(PackHalf(z)), w(PackHalf(w)) {}
+
+		// 点(w = 1)
+		explicit half4(const vec3& v) : half4(v.x, v.y, v.z) {}
+
+		explicit half4(const vec4& v) : half4(v.x, v.y, v.z, v.w) {}
+
+		operator vec4 () const
+		{
+			return vec4(UnpackHalf(x), UnpackHalf(y), UnpackHalf(z), UnpackHalf(w));
+		}
+	};
+
+	struct snorm16x2
+	{
+		GLshort  x;
+		GLshort  y;
+
+		constexpr snorm16x2() : x(0), y(0) {}
+
+		constexpr snorm16x2(GLfloat x, GLfloat y) :
+			x(PackSnorm16(x)), y(PackSnorm16(y)) {}
+
+		explicit constexpr snorm16x2(const vec2& v) : snorm16x2(v.x, v.y) {}
+
+		constexpr operator vec2 () const
+		{
+			return vec2(UnpackSnorm16(x), UnpackSnorm16(y));
+		}
+	};
+
+	struct snorm16x4
+	{
+		GLshort  x;
+		GLshort  y;
+		GLshort  z;
+		GLshort  w;
+
+		constexpr snorm16x4() : x(0), y(0), z(0), w(0) {}
+
+		constexpr snorm16x4(GLfloat x, GLfloat y, GLfloat z, GLfloat w = 1.0) :
+			x(PackSnorm16(x)), y(PackSnorm16(y)), z(PackSnorm16(z)), w(PackSnorm16(w)) {}
+
+		// 点(w = 1)
+		explicit constexpr snorm16x4(const vec3& v) : snorm16x4(v.x, v.y, v.z) {}
+
+		explicit constexpr snorm16x4(const vec4& v) : snorm16x4(v.x, v.y, v.z, v.w) {}
+
+		constexpr operator vec4 () const
+		{
+			return vec4(UnpackSnorm16(x), UnpackSnorm16(y), UnpackSnorm16(z), UnpackSnorm16(w));
+		}
+	};
+
+	struct unorm8x4
+	{
+		GLubyte  r;
+		GLubyte  g;
+		GLubyte  b;
+		GLubyte  a;
+
+		constexpr unorm8x4() : r(0), g(0), b(0), a(0) {}
+
+		constexpr unorm8x4(GLfloat r, GLfloat g, GLfloat b, GLfloat a = 1.0) :
+			r(PackUnorm8(r)), g(PackUnorm8(g)), b(PackUnorm8(b)), a(PackUnorm8(a)) {}
+
+		// 不透明颜色(a = 1)
+		explicit constexpr unorm8x4(const vec3& c) : unorm8x4(c.x, c.y, c.z) {}
+
+		explicit constexpr unorm8x4(const vec4& c) : unorm8x4(c.x, c.y, c.z, c.w) {}
+
+		constexpr operator vec4 () const
+		{
+			return vec4(UnpackUnorm8(r), UnpackUnorm8(g), UnpackUnorm8(b), UnpackUnorm8(a));
+		}
+	};
+
+	// GL_INT_2_10_10_10_REV：x 在最低 10 位，w 在最高 2 位
+	struct int2_10_10_10
+	{
+		GLuint  v;
+
+		constexpr int2_10_10_10() : v(0) {}
+
+		constexpr int2_10_10_10(GLfloat x, GLfloat y, GLfloat z, GLfloat w = 0.0) :
+			v(pack(x, 511.0f, 0) | pack(y, 511.0f, 10) | pack(z, 511.0f, 20) | pack(w, 1.0f, 30)) {}
+
+		// 方向(w = 0)
+		explicit constexpr int2_10_10_10(const vec3& n) : int2_10_10_10(n.x, n.y, n.z) {}
+
+	private:
+		// [-1, 1] -> [-scale, scale]，取补码的低位放到 shift 处
+		static constexpr GLuint pack(GLfloat f, GLfloat scale, int shift)
+		{
+			return ((GLuint)(GLint)(f >= 1.0f ? scale : f <= -1.0f ? -scale
+				: f * scale + (f >= 0.0f ? 0.5f : -0.5f))
+				& (scale > 1.0f ? 0x3FFu : 0x3u)) << shift;
+		}
+	};
+
+	static_assert(sizeof(half4) == 8 && sizeof(snorm16x4) == 8, "half4 and snorm16x4 must be 8 bytes");
+	static_assert(sizeof(snorm16x2) == 4 && sizeof(unorm8x4) == 4 && sizeof(int2_10_10_10) == 4,
+		"snorm16x2, unorm8x4 and int2_10_10_10 must be 4 bytes");
+	static_assert(std::is_trivially_copyable<half4>::value && std::is_trivially_copyable<snorm16x4>::value
+		&& std::is_trivially_copyable<unorm8x4>::value, "packed vertex types must be trivially copyable");
+
+	//----------------------------------------------------------------------------
+	//
+	//  --- Octahedral normal encoding ---
+	//
+	//    单位向量投影到八面体 |x| + |y| + |z| = 1 上，下半部分(z < 0)翻折到上半部分外侧的四个角，
+	//    得到 [-1, 1]^2 中的一点，用两个 snorm16 存储，解码后的角度误差小于 1e-3 弧度
+	//
+
+	inline snorm16x2 PackOctahedral(const vec3& n)
+	{
+		GLfloat l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+		if (l1 < DivideByZeroTolerance)
+		{
+			return snorm16x2(0.0, 0.0);
+		}
+
+		GLfloat x = n.x / l1;
+		GLfloat y = n.y / l1;
+		if (n.z < 0.0f)
+		{
+			GLfloat ox = x;
+			x = (1.0f - std::fabs(y)) * (ox >= 0.0f ? 1.0f : -1.0f);
+			y = (1.0f - std::fabs(ox)) * (y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return snorm16x2(x, y);
+	}
+
+	inline vec3 UnpackOctahedral(const snorm16x2& e)
+	{
+		vec2 v = e;
+		vec3 n(v.x, v.y, 1.0f - std::fabs(v.x) - std::fabs(v.y));
+		if (n.z < 0.0f)
+		{
+			GLfloat ox = n.x;
+			n.x = (1.0f - std::fabs(n.y)) * (ox >= 0.0f ? 1.0f : -1.0f);
+			n.y = (1.0f - std::fabs(ox)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return normalize(n);
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  --- Vertex attribute formats ---
+	//
+	//    VertexFormat<T>：T 作为一个顶点属性时 glVertexAttribPointer 的 size/type/normalized
+	//
+
+	template <typename T>
+	struct VertexFormat;
+
+	template <GLint Size, GLenum Type, GLboolean Normalized>
+	struct VertexFormatBase
+	{
+		static const GLint size = Size;
+		static const GLenum type = Type;
+		static const GLboolean normalized = Normalized;
+	};
+
+	template <> struct VertexFormat<GLfloat> : VertexFormatBase<1, GL_FLOAT, GL_FALSE> {};
+	template <> struct VertexFormat<vec2> : VertexFormatBase<2, GL_FLOAT, GL_FALSE> {};
+	template <> struct VertexFormat<vec3> : VertexFormatBase<3, GL_FLOAT, GL_FALSE> {};
+	template <> struct VertexFormat<vec4> : VertexFormatBase<4, GL_FLOAT, GL_FALSE> {};
+	template <> struct VertexFormat<half4> : VertexFormatBase<4, GL_HALF_FLOAT, GL_FALSE> {};
+	template <> struct VertexFormat<snorm16x2> : VertexFormatBase<2, GL_SHORT, GL_TRUE> {};
+	template <> struct VertexFormat<snorm16x4> : VertexFormatBase<4, GL_SHORT, GL_TRUE> {};
+	template <> struct VertexFormat<unorm8x4> : VertexFormatBase<4, GL_UNSIGNED_BYTE, GL_TRUE> {};
+	template <> struct VertexFormat<int2_10_10_10> : VertexFormatBase<4, GL_INT_2_10_10_10_REV, GL_TRUE> {};
+
+	// 按 T 的格式设置当前 VAO 的第 index 个顶点属性，数据在当前 Array Buffer 的 offset 字节处
+	// stride 为 0 表示紧密排列
+	template <typename T>
+	void VertexAttribPointer(GLuint index, GLsizei stride = 0, size_t offset = 0)
+	{
+		glVertexAttribPointer(index, VertexFormat<T>::size, VertexFormat<T>::type,
+			VertexFormat<T>::normalized, stride, BUFFER_OFFSET(offset));
+	}
+
+	// 逐个元素转换为压缩格式，例如 PackArray<half4>(make_span(points, count))
+	template <typename To, typename From>
+	std::vector<To> PackArray(span<From> src)
+	{
+		std::vector<To> dst;
+		dst.reserve(src.size());
+		for (size_t i = 0; i < src.size(); i++)
+		{
+			dst.push_back(To(src[i]));
+		}
+		return dst;
+	}
+
+	// 法向数组的八面体编码
+	template <typename From>
+	std::vector<snorm16x2> PackNormals(span<From> src)
+	{
+		std::vector<snorm16x2> dst;
+		dst.reserve(src.size());
+		for (size_t i = 0; i < src.size(); i++)
+		{
+			dst.push_back(PackOctahedral(src[i]));
+		}
+		return dst;
+	}
+
+}  // namespace Angel
+
+#endif // __ANGEL_PACK_H__
@@ -0,0 +1,316 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+//
+//  --- vertex.h ---
+//  声明式的顶点布局：列出顶点属性(名字、格式、数据)，由布局计算缓冲区中的偏移和间隔，
+//  打包上传，并按名字设置 VAO，程序中不再手写 glBufferSubData 的偏移和 BUFFER_OFFSET
+//
+//   VertexLayout   顶点属性列表和排列方式：
+//     Planar       每个属性的数据连续存放(xxxx yyyy)，属性之间按 4 字节对齐
+//     Interleaved  同一顶点的各属性相邻存放(xy xy xy xy)，stride 为一个顶点的字节数
+//   VertexBuffer   上传后的缓冲区及各属性的偏移/间隔，可按名字绑定到任意 VAO，
+//                  同一个缓冲区可以建多个 VAO(例如同样的位置、不同的颜色)
+//
+//   例：
+//     VertexLayout layout(VertexLayout::Planar);
+//     layout.attribute("position", make_span(points))
+//           .attribute("color", make_span(colors));
+//     VertexBuffer buffer = layout.upload();
+//     GLuint vao = buffer.vertexArray({ { vPosition, "position" }, { vColor, "color" } });
+//
+//   属性的格式由 pack.h 中的 VertexFormat<T> 给出；所有属性的顶点数取最小的一个
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ANGEL_VERTEX_H__
+#define __ANGEL_VERTEX_H__
+
+#include <algorithm>
+#include <initializer_list>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "pack.h"
+
+namespace Angel
+{
+
+	namespace detail
+	{
+		// 把 count 个 Size 字节的元素从紧密排列的 in 拷贝到间隔为 stride 的 out，
+		// Size 为常量时 memcpy 编译为一次读写
+		template <size_t Size>
+		void copyStrided(GLubyte* out, size_t stride, const GLubyte* in, size_t count)
+		{
+			for (size_t i = 0; i < count; i++, out += stride, in += Size)
+			{
+				memcpy(out, in, Size);
+			}
+		}
+
+		inline void copyStrided(GLubyte* out, size_t stride, const GLubyte* in, size_t size, size_t count)
+		{
+			switch (size)
+			{
+			case 4:
+				copyStrided<4>(out, stride, in, count);
+				break;
+			case 8:
+				copyStrided<8>(out, stride, in, count);
+				break;
+			case 12:
+				copyStrided<12>(out, stride, in, count);
+				break;
+			case 16:
+				copyStrided<16>(out, stride, in, count);
+				break;
+			default:
+				for (size_t i = 0; i < count; i++, out += stride, in += size)
+				{
+					memcpy(out, in, size);
+				}
+			}
+		}
+	}
+
+	// 一个顶点属性在缓冲区中的位置和格式
+	struct VertexAttrib
+	{
+		std::string     name;
+		GLint           size;			// 分量个数
+		GLenum          type;
+		GLboolean       normalized;
+		GLsizei         elementSize;	// 一个顶点的该属性占用的字节数
+		size_t          offset = 0;		// 第一个顶点的该属性在缓冲区中的偏移
+		GLsizei         stride = 0;		// 相邻顶点的该属性之间的字节数
+		const GLubyte*  data = nullptr;	// 打包前的源数据(只在 VertexLayout 中有效)
+	};
+
+	// 按名字把 VertexBuffer 中的属性绑定到 shader 的属性索引
+	struct VertexBinding
+	{
+		GLuint       location;
+		const char*  attribute;
+	};
+
+	//----------------------------------------------------------------------------
+	//
+	//  VertexBuffer - 上传后的顶点缓冲区
+	//
+
+	struct VertexBuffer
+	{
+		GLuint                     buffer = 0;
+		GLsizei                    vertexCount = 0;
+		size_t                     bytes = 0;
+		std::vector<VertexAttrib>  attribs;		// data 已清空
+
+		// 查找名为 name 的属性，没有时返回 NULL
+		const VertexAttrib* find(const char* name) const
+		{
+			for (const VertexAttrib& attrib : attribs)
+			{
+				if (attrib.name == name)
+				{
+					return &attrib;
+				}
+			}
+			return nullptr;
+		}
+
+		// 在当前 VAO 上把属性 name 设置到 shader 的第 location 个属性，属性不存在时返回 false
+		bool bind(GLuint location, const char* name) const
+		{
+			const VertexAttrib* attrib = find(name);
+			if (!attrib)
+			{
+				return false;
+			}
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glEnableVertexAttribArray(location);
+			glVertexAttribPointer(location, attrib->size, attrib->type, attrib->normalized,
+				attrib->stride, BUFFER_OFFSET(attrib->offset));
+			return true;
+		}
+
+		// 新建一个 VAO 并按 bindings 设置属性，返回后该 VAO 为当前 VAO
+		GLuint vertexArray(std::initializer_list<VertexBinding> bindings) const
+		{
+			GLuint vao;
+			glGenVertexArrays(1, &vao);
+			glBindVertexArray(vao);
+			for (const VertexBinding& binding : bindings)
+			{
+				bind(binding.location, binding.attribute);
+			}
+			return vao;
+		}
+
+		// 新建一个 VAO，把与 program 中属性变量同名的属性都设置好(程序中没有用到的属性跳过)
+		GLuint vertexArray(GLuint program) const
+		{
+			GLuint vao;
+			glGenVertexArrays(1, &vao);
+			glBindVertexArray(vao);
+			for (const VertexAttrib& attrib : attribs)
+			{
+				GLint location = glGetAttribLocation(program, attrib.name.c_str());
+				if (location >= 0)
+				{
+					bind((GLuint)location, attrib.name.c_str());
+				}
+			}
+			return vao;
+		}
+
+		void release()
+		{
+			glDeleteBuffers(1, &buffer);
+			buffer = 0;
+		}
+	};
+
+	//----------------------------------------------------------------------------
+	//
+	//  VertexLayout - 顶点属性列表，负责计算偏移并打包
+	//
+	//    源数据只被引用，不拷贝，upload() / pack() 之前必须保持有效
+	//
+
+	class VertexLayout
+	{
+	public:
+		enum Packing { Planar, Interleaved };
+
+	private:
+		Packing _packing;
+		size_t _vertexCount = 0;
+		std::vector<VertexAttrib> _attribs;
+
+		static size_t align4(size_t n) { return (n + 3) & ~size_t(3); }
+
+	public:
+		explicit VertexLayout(Packing packing = Planar) : _packing(packing) {}
+
+		// 加入一个属性，格式由 VertexFormat<T> 决定
+		template <typename T>
+		VertexLayout& attribute(const char* name, span<const T> data)
+		{
+			VertexAttrib attrib;
+			attrib.name = name;
+			attrib.size = VertexFormat<T>::size;
+			attrib.type = VertexFormat<T>::type;
+			attrib.normalized = VertexFormat<T>::normalized;
+			attrib.elementSize = sizeof(T);
+			attrib.data = reinterpret_cast<const GLubyte*>(data.data());
+			_vertexCount = _attribs.empty() ? data.size() : std::min(_vertexCount, data.size());
+			_attribs.push_back(attrib);
+			layout();
+			return *this;
+		}
+
+		template <typename T>
+		VertexLayout& attribute(const char* name, span<T> data)
+		{
+			return attribute(name, span<const T>(data));
+		}
+
+		Packing packing() const { return _packing; }
+		size_t vertexCount() const { return _vertexCount; }
+		const std::vector<VertexAttrib>& attribs() const { return _attribs; }
+
+		// 打包后的总字节数
+		size_t bytes() const
+		{
+			if (_attribs.empty())
+			{
+				return 0;
+			}
+			if (_packing == Interleaved)
+			{
+				return _vertexCount * _attribs[0].stride;
+			}
+			const VertexAttrib& last = _attribs.back();
+			return last.offset + _vertexCount * last.elementSize;
+		}
+
+		// 按布局把所有属性写到 dst(至少 bytes() 字节，可以是映射的缓冲区)
+		void pack(GLubyte* dst) const
+		{
+			for (const VertexAttrib& attrib : _attribs)
+			{
+				if (_packing == Planar)
+				{
+					memcpy(dst + attrib.offset, attrib.data, _vertexCount * attrib.elementSize);
+					continue;
+				}
+				detail::copyStrided(dst + attrib.offset, attrib.stride, attrib.data, attrib.elementSize, _vertexCount);
+			}
+		}
+
+		// 新建缓冲区并上传打包后的数据，返回的 VertexBuffer 不再引用源数据
+		VertexBuffer upload(GLenum usage = GL_STATIC_DRAW) const
+		{
+			VertexBuffer result = describe();
+			std::vector<GLubyte> packed(result.bytes);
+			pack(packed.data());
+			glGenBuffers(1, &result.buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, result.buffer);
+			BufferData(GL_ARRAY_BUFFER, make_span(packed), usage);
+			return result;
+		}
+
+		// 只按布局分配缓冲区，不上传数据，之后映射缓冲区按各属性的偏移直接写入(见 EmitMesh)。
+		// 源数据不会被读取，attribute() 可以传入 data 为空、只有长度的 span
+		VertexBuffer allocate(GLenum usage = GL_STATIC_DRAW) const
+		{
+			VertexBuffer result = describe();
+			glGenBuffers(1, &result.buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, result.buffer);
+			glBufferData(GL_ARRAY_BUFFER, result.bytes, NULL, usage);
+			return result;
+		}
+
+	private:
+		// 上传后的缓冲区描述(还没有创建缓冲区)，不引用源数据
+		VertexBuffer describe() const
+		{
+			VertexBuffer result;
+			result.vertexCount = (GLsizei)_vertexCount;
+			result.bytes = bytes();
+			result.attribs = _attribs;
+			for (VertexAttrib& attrib : result.attribs)
+			{
+				attrib.data = nullptr;
+			}
+			return result;
+		}
+
+		// 重新计算各属性的偏移和间隔
+		void layout()
+		{
+			size_t offset = 0;
+			for (VertexAttrib& attrib : _attribs)
+			{
+				attrib.offset = offset;
+				if (_packing == Planar)
+				{
+					attrib.stride = 0;	// 紧密排列
+					offset = align4(offset + _vertexCount * attrib.elementSize);
+				}
+				else
+				{
+					offset = align4(offset + attrib.elementSize);
+				}
+			}
+			if (_packing == Interleaved)
+			{
+				for (VertexAttrib& attrib : _attribs)
+				{
+					attrib.stride = (GLsizei)offset;
+				}
+			}
+		}
+	};
+
+}  // namespace Angel
+
+#endif // __ANGEL_VERTEX_H__
@@ -11,14 +11,15 @@
 //	按 方向键 控制镜头逐步移动
 //	按 W、S、A、D 键 控制镜头移动
 //	按 L 键 切换 线框模式 和 非线框模式
-//	按 ESC 键 退出
+//	按 ESC 键 退出，退出时输出 glUniform* 调用和跳过的次数
+//	运行中修改 vPhong.glsl、fPhong.glsl 会自动重新编译，编译失败时继续使用原来的 shader
 //------------------------------------------------------------------------------
 
 #include "Angel.h"
 
 const int NUM_SPHERES = 50;
-const float MIN_POS = -20.f;
-const float MAX_POS = 20.f;
+const float EYE_HEIGHT = 0.4f;		// 相机(以及球心)离地面的高度
+const float VIEW_DISTANCE = 600.f;	// 视距，也是透视投影的远平面
 
 typedef vec3 point3;
 typedef vec4 color4;
@@ -69,36 +70,32 @@ lightingStruct Lights[] =
 
 bool arrLightOn[3]; // 3 个光源
 
-MatrixStack MVPStack;		// 模视投影矩阵栈
 mat4 matProj;	// 投影矩阵
 mat4 matCamera; // 相机变换矩阵
 
-// 在每次 matCamera 左乘一个最新变换的时候
-// matReverse都右乘一个最新变换的逆变换
-// 这样可保证matReverse始终都是matCamera的逆矩阵
-// 当前照相机在世界坐标系下的位置就是(matReverse[0][3], matReverse[1][3], matReverse[2][3])
-mat4 matReverse; // 相机变换逆矩阵 用于计算相机位置
+Program phong;	// Phong Shader，修改 .glsl 后自动重新编译并替换，替换后重新反射
 
 /*shader中变量索引*/
 GLuint vPosition;  // shader中in变量vPosition的索引
 GLuint vNormal;
-GLuint ModelView; // shader中uniform变量 ModelView 的索引
-GLuint Projection;  // shader中uniform变量 Projection 的索引
-GLuint AmbientProduct;
-GLuint DiffuseProduct;
-GLuint SpecularProduct;
-GLuint Shininess;
-GLuint Emission;
-GLuint LightPosition;
-GLuint LightOn;
+// shader中uniform变量的句柄，通过 phong.set() 设置，值没有变化时不调用 glUniform*
+Program::Uniform ModelView;
+Program::Uniform Projection;
+Program::Uniform AmbientProduct[3];
+Program::Uniform DiffuseProduct[3];
+Program::Uniform SpecularProduct[3];
+Program::Uniform Shininess;
+Program::Uniform Emission;
+Program::Uniform LightPosition[3];
+Program::Uniform LightOn[3];
 
 bool bUseLine = false; // 使用线框模式
 
-// 地面
-point3* ptGround;
-vec3* nGround;
-GLuint numVerticesGround;
-GLuint vaoGround;
+// 地形：4097 x 4097 个采样点，间距 1 米，按到相机的距离分块选择 LOD
+// 每帧最多画 30 万个顶点(全分辨率为 1680 万个)
+// 高度场约 67 MB，在 InitGround 中生成，不放在全局对象的构造里拖慢启动
+HeightMap heightMap;
+Terrain* terrain;
 
 materialStruct materialGround =
 {
@@ -119,318 +116,48 @@ materialStruct materialRedLight =
 };
 
 // 球
-point3* ptSphere;
-GLuint numVerticesSphere;
+const MeshBuffers* sphere;
 GLuint vaoSphere;
 point3 spheres[NUM_SPHERES];
 
 GLfloat yRot = 0.0f;
 
 // 圆环
-point3* ptTorus;
-vec3* nTorus;
-GLuint numVerticesTorus;
+const MeshBuffers* torus;
 GLuint vaoTorus;
 
 enum { UP, DOWN, LEFT, RIGHT, NUM_KEY };
 bool KeyDown[NUM_KEY];
 
-// 构建 y = 0 且中心为原点平面
-// fExtent 地面范围
-// fStep 间隔
-void BuildGround(GLfloat fExtent, GLfloat fStep)
-{
-	int iterations = 2 * fExtent / fStep;
-	numVerticesGround = iterations * iterations * 6;
-	if (NULL != ptGround)
-	{
-		delete[] ptGround;
-	}
-	ptGround = new point3[numVerticesGround];
-
-	if (NULL != nGround)
-	{
-		delete[] nGround;
-	}
-	nGround = new vec3[numVerticesGround];
-	vec3 defaultNormal = vec3(0.0, 1.0, 0.0); // 默认向上
-	int index = 0;
-	for (GLint x = -fExtent; x < fExtent; x += fStep)
-	{
-		for (GLint z = fExtent; z > -fExtent; z -= fStep)
-		{
-			point3 ptLowerLeft = point3(x, 0, z);
-			point3 ptLowerRight = point3(x + fStep, 0, z);
-			point3 ptUpperLeft = point3(x, 0, z - fStep);
-			point3 ptUpperRight = point3(x + fStep, 0, z - fStep);
-
-			nGround[index] = defaultNormal;
-			ptGround[index++] = ptUpperLeft;
-
-			nGround[index] = defaultNormal;
-			ptGround[index++] = ptLowerLeft;
-
-			nGround[index] = defaultNormal;
-			ptGround[index++] = ptLowerRight;
-
-			nGround[index] = defaultNormal;
-			ptGround[index++] = ptUpperLeft;
-
-			nGround[index] = defaultNormal;
-			ptGround[index++] = ptLowerRight;
-
-			nGround[index] = defaultNormal;
-			ptGround[index++] = ptUpperRight;
-		}
-	}
-}
-
+// 几何体由 MeshCache 生成并上传，这里只创建本程序的 VAO
+// 地形的 VAO 和缓冲区由 Terrain 自己管理，块在走近时才上传；位置按半精度、法向用八面体编码
 void InitGround()
 {
-	BuildGround(MAX_POS, 1.0);
-
-	glGenVertexArrays(1, &vaoGround);
-	glBindVertexArray(vaoGround);
-
-	GLuint buffGround;
-	glGenBuffers(1, &buffGround);
-	glBindBuffer(GL_ARRAY_BUFFER, buffGround);
-	glBufferData(GL_ARRAY_BUFFER,
-		(sizeof(point3) + sizeof(vec3)) * numVerticesGround,
-		NULL,
-		GL_STATIC_DRAW);
-
-	glBufferSubData(GL_ARRAY_BUFFER,
-		0,
-		sizeof(point3) * numVerticesGround,
-		ptGround);
-
-	delete[] ptGround;
-
-	glBufferSubData(GL_ARRAY_BUFFER,
-		sizeof(point3) * numVerticesGround,
-		sizeof(vec3) * numVerticesGround,
-		nGround);
-
-	delete[] nGround;
-
-	glEnableVertexAttribArray(vPosition);
-	glVertexAttribPointer(vPosition, 3, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(0));
-
-	glEnableVertexAttribArray(vNormal);
-	glVertexAttribPointer(vNormal, 3, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(sizeof(point3) * numVerticesGround));
-}
-
-// 创建球体函数：
-// 用于生成一个中心在原点的球的顶点坐标数据(南北极在z轴方向)
-// 参数为球的半径及经线和纬线数
-void BuildSphere(GLfloat radius, GLsizei columns, GLsizei rows)
-{
-	int index = 0;	// 数组索引
-	point3* vertices = new point3[(rows + 1) * (columns + 1)]; // 存放不同顶点的数组
-
-	for (int r = 0; r <= rows; r++)
-	{
-		float v = (float)r / (float)rows;  // [0,1]
-		float theta1 = v * (float)M_PI;	   // [0,PI]
-
-		point3 temp(0, 0, 1);
-		point3 n = temp;
-		GLfloat cosTheta1 = cos(theta1);
-		GLfloat sinTheta1 = sin(theta1);
-		n.x = temp.x * cosTheta1 + temp.z * sinTheta1;
-		n.z = -temp.x * sinTheta1 + temp.z * cosTheta1;
-
-		for (int c = 0; c <= columns; c++)
-		{
-			float u = (float)c / (float)columns; // [0,1]
-			float theta2 = u * (float)(M_PI * 2); // [0,2PI]
-			point3 pos = n;
-			temp = n;
-			GLfloat cosTheta2 = cos(theta2);
-			GLfloat sinTheta2 = sin(theta2);
-
-			pos.x = temp.x * cosTheta2 - temp.y * sinTheta2;
-			pos.y = temp.x * sinTheta2 + temp.y * cosTheta2;
-
-			point3 posFull = pos;
-			posFull *= radius;
-
-			vertices[index++] = posFull;
-		}
-	}
-
-	/*生成最终顶点数组数据*/
-	if (ptSphere)
-	{
-		delete[] ptSphere;	// 如果sphere已经有数据，先回收
-	}
-
-	numVerticesSphere = rows * columns * 6; // 顶点数
-	ptSphere = new point3[numVerticesSphere];
-
-	int colLength = columns + 1;
-	index = 0;
-	for (int r = 0; r < rows; r++)
-	{
-		int offset = r * colLength;
-
-		for (int c = 0; c < columns; c++)
-		{
-			int ul = offset + c;						// 左上
-			int ur = offset + c + 1;					// 右上
-			int br = offset + (c + 1 + colLength);	// 右下
-			int bl = offset + (c + 0 + colLength);	// 左下
-
-			// 由两条经线和纬线围成的矩形
-			ptSphere[index++] = vertices[ul];
-			ptSphere[index++] = vertices[bl];
-			ptSphere[index++] = vertices[br];
-			ptSphere[index++] = vertices[ul];
-			ptSphere[index++] = vertices[br];
-			ptSphere[index++] = vertices[ur];
-		}
-	}
-
-	delete[]vertices;
+	heightMap = HeightMap::Fractal(12, 1.0f, 200.0f);
+	terrain = new Terrain(heightMap, VIEW_DISTANCE, 64.0f, 300000);
+	terrain->init(vPosition, vNormal);
 }
 
 void InitSphere()
 {
 	for (int iSphere = 0; iSphere < NUM_SPHERES; iSphere++)
 	{
-		// 在 -20 到 20 以一米 为步长随机生成一个位置
+		// 在 -20 到 20 以一米 为步长随机生成一个位置，放在地面上方
 		float x = (float)((rand() % 400) - 200) * 0.1f;
 		float z = (float)((rand() % 400) - 200) * 0.1f;
-		spheres[iSphere].x = x;
-		spheres[iSphere].z = z;
+		spheres[iSphere] = point3(x, heightMap.height(x, z) + EYE_HEIGHT, z);
 	}
 
-	BuildSphere(0.2, 15, 15);
-
-	glGenVertexArrays(1, &vaoSphere);
-	glBindVertexArray(vaoSphere);
-	GLuint buffSphere;
-	glGenBuffers(1, &buffSphere);
-	glBindBuffer(GL_ARRAY_BUFFER, buffSphere);
-	glBufferData(GL_ARRAY_BUFFER,
-		sizeof(point3) * numVerticesSphere,
-		ptSphere,
-		GL_STATIC_DRAW);
-
-	delete[] ptSphere;
-
-	glEnableVertexAttribArray(vPosition);
-	glVertexAttribPointer(vPosition,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		0,
-		BUFFER_OFFSET(0));
-
-	glEnableVertexAttribArray(vNormal);
-	glVertexAttribPointer(vNormal,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		0,
-		BUFFER_OFFSET(0));
-}
-
-// 构建中心在原点的圆环(由三角形构建)
-// 参数分别为圆环的主半径(决定环的大小)，圆环截面圆的半径(决定环的粗细)，
-// numMajor和numMinor决定模型精细程度
-void BuildTorus(GLfloat majorRadius, GLfloat minorRadius, GLint numMajor, GLint numMinor)
-{
-	numVerticesTorus = numMajor * numMinor * 6; // 顶点数
-
-	if (NULL != ptTorus)
-	{
-		delete[] ptTorus;	// 如果ptTorus已经有数据，先回收
-	}
-	ptTorus = new point3[numVerticesTorus];
-
-	if (NULL != nTorus)
-	{
-		delete[] nTorus;
-	}
-	nTorus = new vec3[numVerticesTorus];
-
-	double majorStep = 2.0f * M_PI / numMajor;
-	double minorStep = 2.0f * M_PI / numMinor;
-
-	int index = 0;
-	for (int i = 0; i < numMajor; ++i)
-	{
-		double a0 = i * majorStep;
-		double a1 = a0 + majorStep;
-		GLfloat x0 = (GLfloat)cos(a0);
-		GLfloat y0 = (GLfloat)sin(a0);
-		GLfloat x1 = (GLfloat)cos(a1);
-		GLfloat y1 = (GLfloat)sin(a1);
-
-		point3 center0 = majorRadius * point3(x0, y0, 0);
-		point3 center1 = majorRadius * point3(x1, y1, 0);
+	sphere = &MeshCache::Sphere(0.2, 15, 15);
 
-		for (int j = 0; j < numMinor; ++j)
-		{
-			double b0 = j * minorStep;
-			double b1 = b0 + minorStep;
-			GLfloat c0 = (GLfloat)cos(b0);
-			GLfloat r0 = minorRadius * c0 + majorRadius;
-			GLfloat z0 = minorRadius * (GLfloat)sin(b0);
-			GLfloat c1 = (GLfloat)cos(b1);
-			GLfloat r1 = minorRadius * c1 + majorRadius;
-			GLfloat z1 = minorRadius * (GLfloat)sin(b1);
-
-			point3 left0 = point3(x0 * r0, y0 * r0, z0);
-			point3 right0 = point3(x1 * r0, y1 * r0, z0);
-			point3 left1 = point3(x0 * r1, y0 * r1, z1);
-			point3 right1 = point3(x1 * r1, y1 * r1, z1);
-			nTorus[index] = left0 - center0;
-			ptTorus[index++] = left0;
-
-			nTorus[index] = right0 - center1;
-			ptTorus[index++] = right0;
-
-			nTorus[index] = left1 - center0;
-			ptTorus[index++] = left1;
-
-			nTorus[index] = left1 - center0;
-			ptTorus[index++] = left1;
-
-			nTorus[index] = right0 - center1;
-			ptTorus[index++] = right0;
-
-			nTorus[index] = right1 - center1;
-			ptTorus[index++] = right1;
-		}
-	}
+	vaoSphere = sphere->vertexArray(vPosition, vNormal);
 }
 
 void InitTorus()
 {
-	BuildTorus(0.35, 0.15, 40, 20);
-
-	glGenVertexArrays(1, &vaoTorus);
-	glBindVertexArray(vaoTorus);
+	torus = &MeshCache::Torus(0.35, 0.15, 40, 20);
 
-	GLuint buffTorus;
-	glGenBuffers(1, &buffTorus);
-	glBindBuffer(GL_ARRAY_BUFFER, buffTorus);
-	glBufferData(GL_ARRAY_BUFFER, (sizeof(point3) + sizeof(vec3)) * numVerticesTorus, NULL, GL_STATIC_DRAW);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(point3) * numVerticesTorus, ptTorus);
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(point3) * numVerticesTorus,
-		sizeof(vec3) * numVerticesTorus, nTorus);
-
-	delete[] ptTorus;
-	delete[] nTorus;
-
-	glEnableVertexAttribArray(vPosition);
-	glVertexAttribPointer(vPosition, 3, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(0));
-
-	glEnableVertexAttribArray(vNormal);
-	glVertexAttribPointer(vNormal, 3, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(sizeof(point3) * numVerticesTorus));
+	vaoTorus = torus->vertexArray(vPosition, vNormal);
 }
 
 
@@ -439,33 +166,35 @@ void Init()
 {
 	/*加载shader并使用所得到的shader程序*/
 	// InitShader为InitShader.cpp中定义的函数，参数分别为顶点和片元shader的文件名
-	// 返回值为shader程序对象的ID
-	GLuint program = InitShader("vPhong.glsl", "fPhong.glsl");
-	glUseProgram(program); // 使用该shader程序
+	// 返回值为shader程序对象的ID，由 Program 列出其中所有的 uniform 和属性变量
+	phong = Program(InitShader("vPhong.glsl", "fPhong.glsl"));
+	phong.use(); // 使用该shader程序
+	WatchShader(phong.id(), "vPhong.glsl", "fPhong.glsl");
 	// 获取shader程序中属性变量的位置(索引)
-	vPosition = glGetAttribLocation(program, "vPosition");
-	vNormal = glGetAttribLocation(program, "vNormal");
-	ModelView = glGetUniformLocation(program, "ModelView");
-	// 获取shader中uniform变量"Projection"的索引
-	Projection = glGetUniformLocation(program, "Projection");
-
-	AmbientProduct = glGetUniformLocation(program, "AmbientProduct");
-	DiffuseProduct = glGetUniformLocation(program, "DiffuseProduct");
-	SpecularProduct = glGetUniformLocation(program, "SpecularProduct");
-	Shininess = glGetUniformLocation(program, "Shininess");
-	Emission = glGetUniformLocation(program, "Emission");
-	LightPosition = glGetUniformLocation(program, "LightPosition");
-	LightOn = glGetUniformLocation(program, "LightOn");
+	vPosition = phong.attrib("vPosition");
+	vNormal = phong.attrib("vNormal");
+	// 获取shader中uniform变量的句柄，数组按元素分别获取
+	ModelView = phong.uniform("ModelView");
+	Projection = phong.uniform("Projection");
+	Shininess = phong.uniform("Shininess");
+	Emission = phong.uniform("Emission");
+	for (int i = 0; i < 3; i++)
+	{
+		AmbientProduct[i] = phong.uniform("AmbientProduct", i);
+		DiffuseProduct[i] = phong.uniform("DiffuseProduct", i);
+		SpecularProduct[i] = phong.uniform("SpecularProduct", i);
+		LightPosition[i] = phong.uniform("LightPosition", i);
+		LightOn[i] = phong.uniform("LightOn", i);
+	}
 
 	// 设置手电筒位置
-	glUniform4fv(LightPosition + 2, 1, vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	phong.set(LightPosition[2], vec4(0.0f, 0.0f, 0.0f, 1.0f));
 	// 聚光灯照射方向(观察坐标系)
-	glUniform3fv(glGetUniformLocation(program, "SpotDirection"),
-		1, vec3(0.0f, 0.0f, -1.0f));
+	phong.set("SpotDirection", vec3(0.0f, 0.0f, -1.0f));
 	// 聚光灯截止角(角度)
-	glUniform1f(glGetUniformLocation(program, "SpotCutOff"), 8);
+	phong.set("SpotCutOff", 8.0f);
 	// 衰减指数
-	glUniform1f(glGetUniformLocation(program, "SpotExponent"), 3);
+	phong.set("SpotExponent", 3.0f);
 
 	InitGround();
 	InitSphere();
@@ -483,76 +212,80 @@ void Init()
 	glEnable(GL_CULL_FACE);
 }
 
+// 每次绘制前都会调用，与当前材质相同的值由 phong.set() 跳过
 void SetMaterial(const int lightNum, const materialStruct& material, const lightingStruct light[])
 {
 	for (int i = 0; i < lightNum; i++)
 	{
-		glUniform4fv(AmbientProduct + i, 1, material.ambient * light[i].ambient);
-		glUniform4fv(DiffuseProduct + i, 1, material.diffuse * light[i].diffuse);
-		glUniform4fv(SpecularProduct + i, 1, material.specular * light[i].specular);
+		phong.set(AmbientProduct[i], material.ambient * light[i].ambient);
+		phong.set(DiffuseProduct[i], material.diffuse * light[i].diffuse);
+		phong.set(SpecularProduct[i], material.specular * light[i].specular);
 	}
 
-	glUniform4fv(Emission, 1, material.emission);
-	glUniform1f(Shininess, material.shininess);
+	phong.set(Emission, material.emission);
+	phong.set(Shininess, material.shininess);
+}
+
+// 当前照相机在世界坐标系下的位置，即相机变换逆矩阵的平移部分
+// 需要时再由 matCamera 求得，不再额外维护一个逆矩阵
+vec3 CameraPosition()
+{
+	mat4 matInverse = affineInverse(matCamera);
+	return vec3(matInverse[0][3], matInverse[1][3], matInverse[2][3]);
 }
 
 void SetLegalPos()
 {
-	// 相机移动范围 [-20, 20]
-	if (matReverse[0][3] < MIN_POS)
+	// 相机移动范围为整个地形，高度保持在地面上方 EYE_HEIGHT 处
+	vec3 pos = CameraPosition();
+	float maxPos = 0.5f * heightMap.extent();
+	float deltaX = 0.0f;
+	float deltaZ = 0.0f;
+
+	if (pos.x < -maxPos)
 	{
-		float deltaX = MIN_POS - matReverse[0][3];
-		matCamera = Translate(-deltaX, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(deltaX, 0.0, 0.0);
+		deltaX = -maxPos - pos.x;
 	}
-
-	if (matReverse[0][3] > MAX_POS)
+	else if (pos.x > maxPos)
 	{
-		float deltaX = MAX_POS - matReverse[0][3];
-		matCamera = Translate(-deltaX, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(deltaX, 0.0, 0.0);
+		deltaX = maxPos - pos.x;
 	}
 
-	if (matReverse[2][3] < MIN_POS)
+	if (pos.z < -maxPos)
 	{
-		float deltaX = MIN_POS - matReverse[2][3];
-		matCamera = Translate(0.0, 0.0, -deltaX) * matCamera;
-		matReverse *= Translate(0.0, 0.0, deltaX);
+		deltaZ = -maxPos - pos.z;
 	}
+	else if (pos.z > maxPos)
+	{
+		deltaZ = maxPos - pos.z;
+	}
+
+	float deltaY = heightMap.height(pos.x + deltaX, pos.z + deltaZ) + EYE_HEIGHT - pos.y;
 
-	if (matReverse[2][3] > MAX_POS)
+	if (deltaX != 0.0f || deltaY != 0.0f || deltaZ != 0.0f)
 	{
-		float deltaX = MAX_POS - matReverse[2][3];
-		matCamera = Translate(0.0, 0.0, -deltaX) * matCamera;
-		matReverse *= Translate(0.0, 0.0, deltaX);
+		matCamera = Translate(-deltaX, -deltaY, -deltaZ) * matCamera;
 	}
 }
 
 void UpdateCamera()
 {
-	// 在每次 matCamera 左乘一个最新变换的时候
-	// matReverse 都右乘一个最新变换的逆变换
-	// 这样可保证matReverse始终都是 matCamera 的逆矩阵
-	// 当前照相机在世界坐标系下的位置就是(matReverse[0][3], matReverse[1][3], matReverse[2][3])
+	// 每次移动都左乘到 matCamera 上，相机位置由 CameraPosition() 按需求得
 	if (KeyDown[UP])
 	{
 		matCamera = Translate(0.0, 0.0, 0.1) * matCamera;
-		matReverse *= Translate(0.0, 0.0, -0.1);
 	}
 	if (KeyDown[DOWN])
 	{
 		matCamera = Translate(0.0, 0.0, -0.1) * matCamera;
-		matReverse *= Translate(0.0, 0.0, 0.1);
 	}
 	if (KeyDown[LEFT])
 	{
 		matCamera = Translate(0.1, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(-0.1, 0.0, 0.0);
 	}
 	if (KeyDown[RIGHT])
 	{
 		matCamera = Translate(-0.1, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(0.1, 0.0, 0.0);
 	}
 
 	SetLegalPos();
@@ -568,57 +301,58 @@ void RenderScene()
 	UpdateCamera();
 
 	//mat4 matMVP = matProj * matCamera;
-	mat4 matModelView = matCamera;
+	// 模视变换用 TransformChain 组合，每一步直接更新 3x4 仿射矩阵，不生成 4x4 临时矩阵
+	// 上传时也只传 3x4 仿射矩阵的三行(shader 中为 vec4 ModelView[3])，不需要驱动转置
+	TransformChain matModelView(matCamera);
 	// 光源 1 位置
 	vec4 lightPos(1.0, 1.0, 1.0, 0.0);
-	glUniform4fv(LightPosition, 1, matModelView * lightPos);
+	phong.set(LightPosition[0], matModelView * lightPos);
 
-	// 绘制地面
-	MVPStack.push(matModelView);
-	matModelView *= Translate(0.0, -0.4, 0.0);
+	// 保存/恢复变换状态直接复制即可(只有 12 个 float)
+	TransformChain m;
+
+	// 绘制地形，每块的顶点坐标相对于块的原点
 	SetMaterial(3, materialGround, Lights);
-	glBindVertexArray(vaoGround);
-	glUniformMatrix4fv(ModelView, 1, GL_TRUE, matModelView);
-	glDrawArrays(GL_TRIANGLES, 0, numVerticesGround);
-	matModelView = MVPStack.pop();
+	terrain->draw(CameraPosition(), [&](const vec3& origin) {
+		m = matModelView;
+		m.translate(origin);
+		phong.set(ModelView, affine3x4(m));
+	});
+
+	// 圆环和旋转的球放在 (0, -2.5) 处的地面上方
+	GLfloat baseY = heightMap.height(0.0f, -2.5f) + EYE_HEIGHT;
 
 	// 圆环
-	MVPStack.push(matModelView);
-	matModelView *= Translate(0.0, 0.1, -2.5f);
-	matModelView *= Rotate(-yRot, 0.0f, 1.0f, 0.0f);
+	m = matModelView;
+	m.translate(0.0, baseY + 0.1f, -2.5f).rotateY(-yRot);
 	glBindVertexArray(vaoTorus);
-	glUniformMatrix4fv(ModelView, 1, GL_TRUE, matModelView);
-	glDrawArrays(GL_TRIANGLES, 0, numVerticesTorus);
-	matModelView = MVPStack.pop();
+	phong.set(ModelView, affine3x4(m));
+	torus->draw();
 
 	// 绘制球
 	glBindVertexArray(vaoSphere);
 	for (int iSphere = 0; iSphere < NUM_SPHERES; iSphere++)
 	{
-		MVPStack.push(matModelView);
-		matModelView *= Translate(spheres[iSphere].x, 0.0, spheres[iSphere].z);
-		matModelView *= Rotate(90, 1.0, 0.0, 0.0);
-		glUniformMatrix4fv(ModelView, 1, GL_TRUE, matModelView);
-		glDrawArrays(GL_TRIANGLES, 0, numVerticesSphere);
-		matModelView = MVPStack.pop();
+		m = matModelView;
+		m.translate(spheres[iSphere]).rotateX90();
+		phong.set(ModelView, affine3x4(m));
+		sphere->draw();
 	}
 
-	matModelView *= Translate(0.0, 0.0, -2.5f);
+	matModelView.translate(0.0, baseY, -2.5f);
 	// 旋转的球
-	MVPStack.push(matModelView);
+	m = matModelView;
 	if (arrLightOn[1])
 	{
 		SetMaterial(3, materialRedLight, Lights);
 	}
-	matModelView *= Rotate(yRot, 0.0f, 1.0f, 0.0f);
-	matModelView *= Translate(1.0, 0.0f, 0.0f);
+	m.rotateY(yRot).translate(1.0, 0.0f, 0.0f);
 	// 设置第二个光源位置
-	glUniform4fv(LightPosition + 1, 1, matModelView * vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	phong.set(LightPosition[1], m * vec4(0.0f, 0.0f, 0.0f, 1.0f));
 
-	matModelView *= Rotate(90, 1.0f, 0.0f, 0.0f);
-	glUniformMatrix4fv(ModelView, 1, GL_TRUE, matModelView);
-	glDrawArrays(GL_TRIANGLES, 0, numVerticesSphere);
-	matModelView = MVPStack.pop();
+	m.rotateX90();
+	phong.set(ModelView, affine3x4(m));
+	sphere->draw();
 
 	// 交换缓存
 	glutSwapBuffers();
@@ -636,8 +370,8 @@ void ChangeSize(int w, int h)
 	GLfloat fAspect = (GLfloat)w / (GLfloat)h;	// 计算窗口宽高比
 
 	// 设置透视投影视域体
-	matProj = Perspective(35.0f, fAspect, 1.0f, 50.0f);
-	glUniformMatrix4fv(Projection, 1, GL_TRUE, matProj);
+	matProj = Perspective(35.0f, fAspect, 1.0f, VIEW_DISTANCE);
+	phong.set(Projection, matProj);
 }
 
 void MyKeyDown(unsigned char key, int x, int y)
@@ -675,17 +409,19 @@ void MyKeyDown(unsigned char key, int x, int y)
 		break;
 	case '1':
 		arrLightOn[0] = !arrLightOn[0];
-		glUniform1i(LightOn, arrLightOn[0]);
+		phong.set(LightOn[0], arrLightOn[0]);
 		break;
 	case '2':
 		arrLightOn[1] = !arrLightOn[1];
-		glUniform1i(LightOn + 1, arrLightOn[1]);
+		phong.set(LightOn[1], arrLightOn[1]);
 		break;
 	case '3':
 		arrLightOn[2] = !arrLightOn[2];
-		glUniform1i(LightOn + 2, arrLightOn[2]);
+		phong.set(LightOn[2], arrLightOn[2]);
 		break;
 	case 27:	// Esc键
+		std::cout << "glUniform: " << phong.stats().issued << " issued, "
+			<< phong.stats().skipped << " skipped" << std::endl;
 		exit(EXIT_SUCCESS);
 		break;
 	default:
@@ -726,27 +462,19 @@ void MyKeyUp(unsigned char key, int x, int y)
 
 void SpecialKeys(int key, int x, int y)
 {
-	// 在每次 matCamera 左乘一个最新变换的时候
-	// matReverse都右乘一个最新变换的逆变换
-	// 这样可保证 matReverse 始终都是 matCamera 的逆矩阵
-	// 当前照相机在世界坐标系下的位置就是(matReverse[0][3], matReverse[1][3], matReverse[2][3])
 	switch (key)
 	{
 	case GLUT_KEY_UP:
 		matCamera = Translate(0.0, 0.0, 0.1) * matCamera;
-		matReverse *= Translate(0.0, 0.0, -0.1);
 		break;
 	case GLUT_KEY_DOWN:
 		matCamera = Translate(0.0, 0.0, -0.1) * matCamera;
-		matReverse *= Translate(0.0, 0.0, 0.1);
 		break;
 	case GLUT_KEY_LEFT:
 		matCamera = Translate(0.1, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(-0.1, 0.0, 0.0);
 		break;
 	case GLUT_KEY_RIGHT:
 		matCamera = Translate(-0.1, 0.0, 0.0) * matCamera;
-		matReverse *= Translate(0.1, 0.0, 0.0);
 		break;
 	}
 	glutPostRedisplay();
@@ -0,0 +1,1148 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+//
+//  --- mesh.h ---
+//  程序化生成的网格：不重复的顶点 + 索引，以及按生成参数缓存的 GPU 网格
+//
+//   IndexedMesh       顶点位置(和法向)数组、索引数组及图元类型
+//   MeshEmitter       生成器的输出：按下标写入的顶点和索引 span，可指向 CPU 数组或映射的缓冲区
+//   XxxGenerator      生成器，layout() 给出输出的大小，emit(out) 写出顶点和索引：
+//     Sphere          中心在原点的球(南北极在z轴方向)
+//     Torus           中心在原点的圆环(在 xy 平面内)
+//     Ring            中心在原点的圆(在 xy 平面内，GL_LINE_LOOP)
+//     Ground          y = 0 的地面(三角形)
+//     Grid            y = 0 的地面网格线(GL_LINES)
+//     Sierpinski      任意细分次数的 Sierpinski 四面体，相邻小四面体共用顶点
+//   BuildXxxMesh      用对应的生成器生成 IndexedMesh
+//   EmitSierpinskiOffsets  Sierpinski 四面体中每个小四面体的格点原点，用于实例化绘制
+//   OptimizeMesh      重排三角形和顶点(顶点缓存、过度绘制、顶点读取，见 meshopt.h)
+//   BufferIndices     上传索引，顶点数不超过 65536 时自动改用 16 位索引
+//
+//   MeshBuffers       上传到 GPU 的网格，可绑定到任意 VAO 上绘制
+//   EmitMesh          生成器直接写入映射的 GPU 缓冲区，不经过 CPU 数组
+//   MeshCache         以 "生成器(参数)" 为键缓存 MeshBuffers，例如 "sphere(r=1,15,15)"，
+//                     同样的请求直接返回已上传的缓冲区，不再重新生成和上传；
+//                     三角形网格在上传前经过 OptimizeMesh
+//
+//   以 15 x 15 的球为例：展开的三角形需要 15 * 15 * 6 = 1350 个顶点，
+//   索引网格只有 16 * 16 = 256 个顶点，外加 1350 个 16 位索引
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ANGEL_MESH_H__
+#define __ANGEL_MESH_H__
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+#include "vec.h"
+#include "trig.h"
+#include "vertex.h"
+#include "meshopt.h"
+
+namespace Angel
+{
+
+	struct IndexedMesh
+	{
+		std::vector<vec3>    vertices;	// 不重复的顶点
+		std::vector<vec3>    normals;	// 顶点法向，为空表示没有法向
+		std::vector<GLuint>  indices;	// 顶点索引，为空表示按顶点顺序绘制
+		GLenum               mode = GL_TRIANGLES;	// 图元类型
+
+		GLsizei indexCount() const { return (GLsizei)indices.size(); }
+	};
+
+	// 生成器输出的大小和格式，生成之前就能确定，用来预先分配 CPU 数组或 GPU 缓冲区
+	struct MeshLayout
+	{
+		GLenum   mode;
+		size_t   vertexCount;
+		size_t   indexCount;	// 0 表示没有索引
+		bool     normals;		// 是否有法向
+		GLfloat  extent;		// 顶点坐标绝对值的上限，决定 GPU 上的位置格式
+	};
+
+	namespace detail
+	{
+		inline void storeNormal(vec3& dst, const vec3& n) { dst = n; }
+		inline void storeNormal(snorm16x2& dst, const vec3& n) { dst = PackOctahedral(n); }
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  MeshEmitter - 生成器的输出
+	//
+	//    生成器不分配数组，而是按下标把顶点和索引写到这里的 span 中。span 可以指向 IndexedMesh 的数组，
+	//    也可以直接指向 glMapBufferRange 映射的缓冲区(见 EmitMesh)，省去中间数组和一次拷贝。
+	//    Position / Normal 为存储格式：vec3 或 pack.h 中的压缩格式(法向为八面体编码的 snorm16x2)，
+	//    Index 为 GLushort 或 GLuint。不同线程可以同时写不同的下标。
+	//    mapped 为 true 时输出只能写不能读(映射的缓冲区)，需要回读的生成器改用临时数组
+	//
+
+	template <typename Position, typename Normal, typename Index>
+	struct MeshEmitter
+	{
+		typedef Index index_type;
+
+		span<Position>  positions;
+		span<Normal>    normals;	// 为空表示不输出法向
+		span<Index>     indices;
+		bool            mapped = false;
+
+		void vertex(size_t i, const vec3& position)
+		{
+			positions[i] = Position(position);
+		}
+
+		void vertex(size_t i, const vec3& position, const vec3& normal)
+		{
+			positions[i] = Position(position);
+			if (!normals.empty())
+			{
+				detail::storeNormal(normals[i], normal);
+			}
+		}
+
+		void index(size_t i, GLuint v)
+		{
+			indices[i] = (Index)v;
+		}
+	};
+
+	// 写入 IndexedMesh 的输出
+	typedef MeshEmitter<vec3, vec3, GLuint> IndexedMeshEmitter;
+
+	// 按 layout 分配 mesh 的数组，返回写入这些数组的输出
+	inline IndexedMeshEmitter AllocateMesh(IndexedMesh& mesh, const MeshLayout& layout)
+	{
+		mesh.mode = layout.mode;
+		mesh.vertices.resize(layout.vertexCount);
+		mesh.normals.resize(layout.normals ? layout.vertexCount : 0);
+		mesh.indices.resize(layout.indexCount);
+
+		IndexedMeshEmitter out;
+		out.positions = make_span(mesh.vertices);
+		out.normals = make_span(mesh.normals);
+		out.indices = make_span(mesh.indices);
+		return out;
+	}
+
+	// 用生成器生成 CPU 上的网格
+	template <typename Generator>
+	IndexedMesh BuildMesh(const Generator& generator, size_t parallelThreshold = BatchParallelThreshold)
+	{
+		IndexedMesh mesh;
+		IndexedMeshEmitter out = AllocateMesh(mesh, generator.layout());
+		generator.emit(out, parallelThreshold);
+		return mesh;
+	}
+
+	// 网格类几何体的索引：(rows + 1) x (columns + 1) 个顶点按行排列，每个格子两个三角形，
+	// 按行分段并行填写，每行的输出位置固定，结果与串行生成完全相同
+	// 每个格子沿 左上-右下 对角线分为 (左上, 左下, 右下)(左上, 右下, 右上)，
+	// otherDiagonal 为 true 时沿 右上-左下 分为 (左上, 左下, 右上)(右上, 左下, 右下)
+	template <typename Index>
+	void BuildGridIndices(Index* indices, size_t columns, size_t rows, bool otherDiagonal, size_t parallelThreshold)
+	{
+		GLuint colLength = (GLuint)columns + 1;
+		ParallelFor(rows, parallelThreshold / (columns + 1), [=](size_t begin, size_t end) {
+			for (size_t r = begin; r < end; r++)
+			{
+				Index* out = indices + r * columns * 6;
+				GLuint offset = (GLuint)r * colLength;
+
+				for (size_t c = 0; c < columns; c++)
+				{
+					GLuint ul = offset + (GLuint)c;		// 左上
+					GLuint ur = ul + 1;					// 右上
+					GLuint bl = ul + colLength;			// 左下
+					GLuint br = bl + 1;					// 右下
+
+					// 由两条经线和纬线围成的矩形
+					*out++ = (Index)ul;
+					*out++ = (Index)bl;
+					*out++ = (Index)(otherDiagonal ? ur : br);
+					*out++ = (Index)(otherDiagonal ? ur : ul);
+					*out++ = (Index)(otherDiagonal ? bl : br);
+					*out++ = (Index)(otherDiagonal ? br : ur);
+				}
+			}
+		});
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  --- Generators ---
+	//
+	//    每个生成器保存生成参数，layout() 给出输出的大小，emit(out) 把顶点和索引写到 MeshEmitter 中
+	//
+
+	// 中心在原点的球，参数为球的半径及经线和纬线数
+	// 顶点按行(纬线)排列，每行 columns + 1 个(首尾经度相同但分别存放，便于以后加纹理坐标)
+	// 顶点数达到 parallelThreshold 时按行分段并行生成
+	struct SphereGenerator
+	{
+		GLfloat radius;
+		GLsizei columns, rows;
+
+		MeshLayout layout() const
+		{
+			MeshLayout layout = { GL_TRIANGLES, (size_t)(rows + 1) * (columns + 1), (size_t)rows * columns * 6, true, radius };
+			return layout;
+		}
+
+		template <typename Emitter>
+		void emit(Emitter& out, size_t parallelThreshold = BatchParallelThreshold) const
+		{
+			size_t colLength = columns + 1;
+
+			// 纬度角(行)和经度角(列)分别建 sin/cos 表，顶点只是两张表的乘积
+			SinCosTable lat(0.0f, (float)M_PI / rows, rows + 1);				// theta1: [0,PI]
+			SinCosTable lon(0.0f, (float)(M_PI * 2) / columns, columns + 1);	// theta2: [0,2PI]
+
+			ParallelFor(rows + 1, parallelThreshold / colLength, [&](size_t begin, size_t end) {
+				for (size_t r = begin; r < end; r++)
+				{
+					// 点(0, 0, 1)绕y轴旋转theta1
+					vec3 n(lat.sin(r), 0.0f, lat.cos(r));
+
+					size_t index = r * colLength;
+					for (size_t c = 0; c < colLength; c++, index++)
+					{
+						// 再绕z轴旋转theta2，单位球上的点即为法向
+						vec3 pos(n.x * lon.cos(c), n.x * lon.sin(c), n.z);
+						out.vertex(index, pos * radius, pos);
+					}
+				}
+			});
+
+			BuildGridIndices(out.indices.data(), columns, rows, false, parallelThreshold);
+		}
+	};
+
+	// 中心在原点的圆环(在 xy 平面内)
+	// 参数分别为圆环的主半径(决定环的大小)，圆环截面圆的半径(决定环的粗细)，
+	// numMajor和numMinor决定模型精细程度；顶点数达到 parallelThreshold 时按主圆分段并行生成
+	struct TorusGenerator
+	{
+		GLfloat majorRadius, minorRadius;
+		GLsizei numMajor, numMinor;
+
+		MeshLayout layout() const
+		{
+			MeshLayout layout = { GL_TRIANGLES, (size_t)(numMajor + 1) * (numMinor + 1), (size_t)numMajor * numMinor * 6,
+				true, majorRadius + minorRadius };
+			return layout;
+		}
+
+		template <typename Emitter>
+		void emit(Emitter& out, size_t parallelThreshold = BatchParallelThreshold) const
+		{
+			size_t colLength = numMinor + 1;
+
+			// 主圆和截面圆的角度都是等步长的，先建 sin/cos 表
+			SinCosTable major(0.0f, 2.0f * (float)M_PI / numMajor, numMajor + 1);
+			SinCosTable minor(0.0f, 2.0f * (float)M_PI / numMinor, numMinor + 1);
+
+			// 截面圆上各点到 z 轴的距离和高度，所有主圆位置共用
+			std::vector<GLfloat> ringRadius(colLength), ringZ(colLength);
+			for (size_t j = 0; j < colLength; j++)
+			{
+				ringRadius[j] = minorRadius * minor.cos(j) + majorRadius;
+				ringZ[j] = minorRadius * minor.sin(j);
+			}
+
+			ParallelFor(numMajor + 1, parallelThreshold / colLength, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+				{
+					GLfloat x = major.cos(i);
+					GLfloat y = major.sin(i);
+
+					size_t index = i * colLength;
+					for (size_t j = 0; j < colLength; j++, index++)
+					{
+						// 法向为截面圆上的方向，即截面圆的 (cos, sin) 在主圆方向上展开，已是单位向量
+						out.vertex(index, vec3(x * ringRadius[j], y * ringRadius[j], ringZ[j]),
+							vec3(x * minor.cos(j), y * minor.cos(j), minor.sin(j)));
+					}
+				}
+			});
+
+			// 行为主圆位置、列为截面圆位置，三角形为 (left0, right0, left1)(left1, right0, right1)
+			BuildGridIndices(out.indices.data(), numMinor, numMajor, true, parallelThreshold);
+		}
+	};
+
+	// 中心在原点、半径为 radius 的圆(在 xy 平面内，GL_LINE_LOOP)，由 num 段折线组成
+	struct RingGenerator
+	{
+		GLfloat radius;
+		GLsizei num;
+
+		MeshLayout layout() const
+		{
+			MeshLayout layout = { GL_LINE_LOOP, (size_t)num, 0, false, radius };
+			return layout;
+		}
+
+		template <typename Emitter>
+		void emit(Emitter& out, size_t /*parallelThreshold*/ = BatchParallelThreshold) const
+		{
+			SinCosTable angle(0.0f, 2.0f * (float)M_PI / num, num); // 第i段的角度: [0,2PI)
+
+			for (int i = 0; i < num; i++)
+			{
+				out.vertex(i, vec3(radius * angle.cos(i), radius * angle.sin(i), 0.0f));
+			}
+		}
+	};
+
+	// y = 0 且中心为原点的地面(三角形，法向向上)，extent 为地面范围，step 为间隔
+	struct GroundGenerator
+	{
+		GLfloat extent, step;
+
+		int cells() const { return (int)(2 * extent / step); }
+
+		MeshLayout layout() const
+		{
+			size_t colLength = cells() + 1;
+			MeshLayout layout = { GL_TRIANGLES, colLength * colLength, (size_t)cells() * cells() * 6, true, extent };
+			return layout;
+		}
+
+		template <typename Emitter>
+		void emit(Emitter& out, size_t /*parallelThreshold*/ = BatchParallelThreshold) const
+		{
+			int cells = this->cells();
+			int colLength = cells + 1;
+
+			int index = 0;
+			for (int i = 0; i <= cells; i++)
+			{
+				for (int k = 0; k <= cells; k++)
+				{
+					out.vertex(index++, vec3(-extent + i * step, 0.0, -extent + k * step), vec3(0.0, 1.0, 0.0));
+				}
+			}
+
+			index = 0;
+			for (int i = 0; i < cells; i++)
+			{
+				for (int k = 0; k < cells; k++)
+				{
+					GLuint upperLeft = i * colLength + k;		// (x, z)
+					GLuint lowerLeft = upperLeft + 1;			// (x, z + step)
+					GLuint upperRight = upperLeft + colLength;	// (x + step, z)
+					GLuint lowerRight = lowerLeft + colLength;	// (x + step, z + step)
+
+					out.index(index++, upperLeft);
+					out.index(index++, lowerLeft);
+					out.index(index++, lowerRight);
+					out.index(index++, upperLeft);
+					out.index(index++, lowerRight);
+					out.index(index++, upperRight);
+				}
+			}
+		}
+	};
+
+	// y = 0 且中心为原点的地面网格线(GL_LINES)，extent 为地面范围，step 为间隔
+	struct GridGenerator
+	{
+		GLfloat extent, step;
+
+		int lines() const { return (int)(2 * extent / step) + 1; }
+
+		MeshLayout layout() const
+		{
+			MeshLayout layout = { GL_LINES, (size_t)lines() * 4, 0, false, extent };
+			return layout;
+		}
+
+		template <typename Emitter>
+		void emit(Emitter& out, size_t /*parallelThreshold*/ = BatchParallelThreshold) const
+		{
+			int lines = this->lines();
+			for (int i = 0; i < lines; i++)
+			{
+				GLfloat t = -extent + i * step;
+				out.vertex(i * 4, vec3(t, 0, extent));
+				out.vertex(i * 4 + 1, vec3(t, 0, -extent));
+				out.vertex(i * 4 + 2, vec3(extent, 0, t));
+				out.vertex(i * 4 + 3, vec3(-extent, 0, t));
+			}
+		}
+	};
+
+	inline IndexedMesh BuildSphereMesh(GLfloat radius, GLsizei columns, GLsizei rows,
+		size_t parallelThreshold = BatchParallelThreshold)
+	{
+		return BuildMesh(SphereGenerator{ radius, columns, rows }, parallelThreshold);
+	}
+
+	inline IndexedMesh BuildTorusMesh(GLfloat majorRadius, GLfloat minorRadius, GLsizei numMajor, GLsizei numMinor,
+		size_t parallelThreshold = BatchParallelThreshold)
+	{
+		return BuildMesh(TorusGenerator{ majorRadius, minorRadius, numMajor, numMinor }, parallelThreshold);
+	}
+
+	inline IndexedMesh BuildRingMesh(GLfloat radius, GLsizei num)
+	{
+		return BuildMesh(RingGenerator{ radius, num });
+	}
+
+	inline IndexedMesh BuildGroundMesh(GLfloat extent, GLfloat step)
+	{
+		return BuildMesh(GroundGenerator{ extent, step });
+	}
+
+	inline IndexedMesh BuildGridMesh(GLfloat extent, GLfloat step)
+	{
+		return BuildMesh(GridGenerator{ extent, step });
+	}
+
+	namespace detail
+	{
+		// 格点坐标 (i, j, k) 到顶点号的散列表(开放寻址，线性探测)
+		// 格点坐标都是整数，相同的点键值完全相同，不需要按距离容差比较
+		const unsigned long long EmptyLatticeKey = ~0ull;
+
+		class LatticeVertexMap
+		{
+			std::vector<unsigned long long> _keys;
+			std::vector<GLuint> _values;
+			size_t _mask;
+
+		public:
+			// count 为最多存放的顶点数，装填因子不超过 1/2
+			explicit LatticeVertexMap(size_t count)
+			{
+				size_t capacity = 16;
+				while (capacity < count * 2)
+				{
+					capacity *= 2;
+				}
+				_keys.assign(capacity, EmptyLatticeKey);
+				_values.resize(capacity);
+				_mask = capacity - 1;
+			}
+
+			static unsigned long long Key(GLuint i, GLuint j, GLuint k)
+			{
+				return ((unsigned long long)i << 42) | ((unsigned long long)j << 21) | k;
+			}
+
+			// 查找 key，不存在时以 next 为顶点号插入；返回 key 的顶点号
+			GLuint insert(unsigned long long key, GLuint next)
+			{
+				size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & _mask;
+				while (_keys[slot] != key)
+				{
+					if (_keys[slot] == EmptyLatticeKey)
+					{
+						_keys[slot] = key;
+						_values[slot] = next;
+						return next;
+					}
+					slot = (slot + 1) & _mask;
+				}
+				return _values[slot];
+			}
+
+			// 查找 key，不存在时返回 NotFound
+			GLuint find(unsigned long long key) const
+			{
+				size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & _mask;
+				while (_keys[slot] != key)
+				{
+					if (_keys[slot] == EmptyLatticeKey)
+					{
+						return NotFound;
+					}
+					slot = (slot + 1) & _mask;
+				}
+				return _values[slot];
+			}
+
+			static const GLuint NotFound = ~0u;
+		};
+
+		// BuildSierpinskiMesh 中的一棵子树
+		struct SierpinskiSubtree
+		{
+			std::vector<vec3> vertices;		// 子树内的顶点，按第一次出现的顺序
+			unsigned long long cornerKeys[4];	// 四个角的格点
+			GLuint corners[4];				// 四个角的子树内顶点号
+			GLuint firstVertex;				// 子树新顶点的第一个全局顶点号
+			GLuint shared[4];				// 已在前面的子树中出现的角(子树内顶点号)
+			GLuint sharedVertex[4];			// 这些角的全局顶点号
+			int sharedCount;
+
+			// 子树内顶点号 v 对应的全局顶点号：新顶点按子树内的顺序连续编号，跳过已出现过的角
+			GLuint vertex(GLuint v) const
+			{
+				GLuint skipped = 0;
+				for (int i = 0; i < sharedCount; i++)
+				{
+					if (v == shared[i])
+					{
+						return sharedVertex[i];
+					}
+					skipped += v > shared[i];
+				}
+				return firstVertex + v - skipped;
+			}
+		};
+
+		// 细分时按前几层划分子树的层数，4^3 = 64 棵子树
+		const int SierpinskiSplitDepth = 3;
+
+		// 把边长为 size 个格点、原点在格点 (i, j, k) 的四面体细分到边长为 1，
+		// 按与原来的 DivideTetra 相同的顺序(a, b, c, d 角上的小四面体)对每个小四面体调用 emit(i, j, k)
+		template <typename Emit>
+		void DivideTetra(GLuint i, GLuint j, GLuint k, GLuint size, Emit& emit)
+		{
+			if (size > 1)
+			{
+				GLuint half = size / 2;
+				DivideTetra(i, j, k, half, emit);
+				DivideTetra(i + half, j, k, half, emit);
+				DivideTetra(i, j + half, k, half, emit);
+				DivideTetra(i, j, k + half, half, emit);
+			}
+			else
+			{
+				emit(i, j, k);
+			}
+		}
+	}
+
+	// 细分 depth 次后 4^depth 个小四面体的格点原点 (i, j, k)，顺序与 SierpinskiGenerator 相同，
+	// 每个存为 4 个 GLushort(第 4 个为 0)，可直接作为 GL_RGBA16UI 纹理缓冲区；depth 不超过 16
+	// 第 t 个小四面体的原点由 t 的四进制各位直接求出，不需要递归：
+	// 从高位起第 l 位为 1、2、3 时，i、j、k 分别加上 2^(depth-1-l)；数量达到 parallelThreshold 时分段并行生成
+	// offsets 可以是映射的缓冲区，长度为 4 * 4^depth
+	inline void EmitSierpinskiOffsets(int depth, span<GLushort> offsets, size_t parallelThreshold = BatchParallelThreshold)
+	{
+		size_t tetrahedra = (size_t)1 << (2 * depth);
+
+		GLushort* out = offsets.data();
+		ParallelFor(tetrahedra, parallelThreshold, [=](size_t begin, size_t end) {
+			for (size_t t = begin; t < end; t++)
+			{
+				// lattice[0] 接收四进制位为 0 的情况，不需要分支
+				GLushort lattice[4] = { 0, 0, 0, 0 };
+				for (int l = 0; l < depth; l++)
+				{
+					int shift = depth - 1 - l;
+					lattice[(t >> (2 * shift)) & 3] += (GLushort)(1 << shift);
+				}
+
+				GLushort* offset = out + t * 4;
+				offset[0] = lattice[1];
+				offset[1] = lattice[2];
+				offset[2] = lattice[3];
+				offset[3] = 0;
+			}
+		});
+	}
+
+	inline std::vector<GLushort> BuildSierpinskiOffsets(int depth, size_t parallelThreshold = BatchParallelThreshold)
+	{
+		std::vector<GLushort> offsets(((size_t)4 << (2 * depth)));
+		EmitSierpinskiOffsets(depth, make_span(offsets), parallelThreshold);
+		return offsets;
+	}
+
+	// 细分 depth 次的 Sierpinski 四面体，corners 为初始四面体的四个顶点 a, b, c, d
+	// 细分后的每个顶点都是格点 a + (i * (b - a) + j * (c - a) + k * (d - a)) / 2^depth，
+	// 以格点坐标为键去重：4^depth 个小四面体只有 2 * 4^depth + 2 个不同的顶点(展开为三角形需要 12 * 4^depth 个)
+	// 每个小四面体的四个面 (a, b, c)(a, c, d)(a, d, b)(b, d, c) 分别存入索引的四段，
+	// 每段 3 * 4^depth 个索引，各段可以用不同的颜色绘制；depth 不超过 20
+	//
+	// 前 SierpinskiSplitDepth 层把四面体分为互不相交的子树(最多 64 棵)，每棵子树的三角形在每段索引中的位置固定，
+	// 小四面体数达到 parallelThreshold 时各子树并行细分和去重。子树之间只在角上共用顶点，
+	// 按子树顺序给顶点编号后，顶点和索引的顺序与整体串行细分(小四面体按 DivideTetra 的顺序，
+	// 顶点按第一次出现的顺序)完全相同，与线程数无关
+	// 索引先写子树内的顶点号再换成全局顶点号，输出为映射的缓冲区时子树内的顶点号写在临时数组中
+	struct SierpinskiGenerator
+	{
+		vec3 corners[4];
+		int depth;
+
+		size_t tetrahedra() const { return (size_t)1 << (2 * depth); }
+
+		MeshLayout layout() const
+		{
+			GLfloat extent = 0.0f;
+			for (const vec3& c : corners)
+			{
+				extent = std::fmax(extent, std::fmax(std::fabs(c.x), std::fmax(std::fabs(c.y), std::fabs(c.z))));
+			}
+			MeshLayout layout = { GL_TRIANGLES, 2 * tetrahedra() + 2, tetrahedra() * 12, false, extent };
+			return layout;
+		}
+
+		template <typename Emitter>
+		void emit(Emitter& out, size_t parallelThreshold = BatchParallelThreshold) const
+		{
+			typedef typename Emitter::index_type Index;
+
+			size_t tetrahedra = this->tetrahedra();
+			size_t faceLength = tetrahedra * 3;
+			GLuint size = 1u << depth;
+
+			vec3 origin = corners[0];
+			vec3 du = (corners[1] - corners[0]) / (GLfloat)size;
+			vec3 dv = (corners[2] - corners[0]) / (GLfloat)size;
+			vec3 dw = (corners[3] - corners[0]) / (GLfloat)size;
+
+			int split = depth < detail::SierpinskiSplitDepth ? depth : detail::SierpinskiSplitDepth;
+			size_t subtreeCount = (size_t)1 << (2 * split);
+			size_t subtreeTetrahedra = tetrahedra / subtreeCount;
+			GLuint subtreeSize = size >> split;
+			std::vector<GLushort> subtreeOrigins = BuildSierpinskiOffsets(split, ~size_t(0));
+			std::vector<detail::SierpinskiSubtree> subtrees(subtreeCount);
+
+			// 子树内的顶点号：输出可读时直接写在输出中，之后原地换成全局顶点号
+			std::vector<Index> scratch;
+			Index* local = out.indices.data();
+			if (out.mapped)
+			{
+				scratch.resize(out.indices.size());
+				local = scratch.data();
+			}
+
+			// 第一步(并行)：每棵子树单独细分、去重，索引先写子树内的顶点号
+			ParallelFor(subtreeCount, parallelThreshold / subtreeTetrahedra, [&](size_t begin, size_t end) {
+				for (size_t s = begin; s < end; s++)
+				{
+					detail::SierpinskiSubtree& subtree = subtrees[s];
+					GLuint i0 = subtreeOrigins[s * 4] * subtreeSize;
+					GLuint j0 = subtreeOrigins[s * 4 + 1] * subtreeSize;
+					GLuint k0 = subtreeOrigins[s * 4 + 2] * subtreeSize;
+
+					detail::LatticeVertexMap map(2 * subtreeTetrahedra + 2);
+					subtree.vertices.reserve(2 * subtreeTetrahedra + 2);
+					Index* indices = local + s * subtreeTetrahedra * 3;
+
+					auto vertex = [&](GLuint i, GLuint j, GLuint k) -> Index {
+						GLuint next = (GLuint)subtree.vertices.size();
+						GLuint index = map.insert(detail::LatticeVertexMap::Key(i, j, k), next);
+						if (index == next)
+						{
+							subtree.vertices.push_back(origin + du * (GLfloat)i + dv * (GLfloat)j + dw * (GLfloat)k);
+						}
+						return (Index)index;
+					};
+
+					auto emit = [&](GLuint i, GLuint j, GLuint k) {
+						Index a = vertex(i, j, k);
+						Index b = vertex(i + 1, j, k);
+						Index c = vertex(i, j + 1, k);
+						Index d = vertex(i, j, k + 1);
+
+						indices[0] = a; indices[1] = b; indices[2] = c;
+						indices[faceLength] = a; indices[faceLength + 1] = c; indices[faceLength + 2] = d;
+						indices[faceLength * 2] = a; indices[faceLength * 2 + 1] = d; indices[faceLength * 2 + 2] = b;
+						indices[faceLength * 3] = b; indices[faceLength * 3 + 1] = d; indices[faceLength * 3 + 2] = c;
+						indices += 3;
+					};
+					detail::DivideTetra(i0, j0, k0, subtreeSize, emit);
+
+					// 子树四个角的格点和子树内顶点号
+					const GLuint cornerOffsets[4][3] = { { 0, 0, 0 }, { subtreeSize, 0, 0 }, { 0, subtreeSize, 0 }, { 0, 0, subtreeSize } };
+					for (int c = 0; c < 4; c++)
+					{
+						subtree.cornerKeys[c] = detail::LatticeVertexMap::Key(
+							i0 + cornerOffsets[c][0], j0 + cornerOffsets[c][1], k0 + cornerOffsets[c][2]);
+						subtree.corners[c] = map.find(subtree.cornerKeys[c]);
+					}
+				}
+			});
+
+			// 第二步(串行)：按子树顺序编号，角上的顶点已在前面的子树中出现时沿用原来的顶点号
+			detail::LatticeVertexMap cornerMap(4 * subtreeCount);
+			GLuint next = 0;
+			for (detail::SierpinskiSubtree& subtree : subtrees)
+			{
+				subtree.firstVertex = next;
+				subtree.sharedCount = 0;
+				for (int c = 0; c < 4; c++)
+				{
+					GLuint shared = cornerMap.find(subtree.cornerKeys[c]);
+					if (shared != detail::LatticeVertexMap::NotFound)
+					{
+						subtree.shared[subtree.sharedCount] = subtree.corners[c];
+						subtree.sharedVertex[subtree.sharedCount] = shared;
+						subtree.sharedCount++;
+					}
+				}
+				for (int c = 0; c < 4; c++)
+				{
+					cornerMap.insert(subtree.cornerKeys[c], subtree.vertex(subtree.corners[c]));
+				}
+				next += (GLuint)subtree.vertices.size() - subtree.sharedCount;
+			}
+
+			// 第三步(并行)：索引换成全局顶点号，顶点写到全局位置
+			ParallelFor(subtreeCount, parallelThreshold / subtreeTetrahedra, [&](size_t begin, size_t end) {
+				for (size_t s = begin; s < end; s++)
+				{
+					detail::SierpinskiSubtree& subtree = subtrees[s];
+					for (int face = 0; face < 4; face++)
+					{
+						size_t first = face * faceLength + s * subtreeTetrahedra * 3;
+						for (size_t i = first; i < first + subtreeTetrahedra * 3; i++)
+						{
+							out.index(i, subtree.vertex(local[i]));
+						}
+					}
+					for (GLuint v = 0; v < (GLuint)subtree.vertices.size(); v++)
+					{
+						out.vertex(subtree.vertex(v), subtree.vertices[v]);
+					}
+					std::vector<vec3>().swap(subtree.vertices);
+				}
+			});
+		}
+	};
+
+	inline IndexedMesh BuildSierpinskiMesh(const vec3 corners[4], int depth,
+		size_t parallelThreshold = BatchParallelThreshold)
+	{
+		SierpinskiGenerator generator = { { corners[0], corners[1], corners[2], corners[3] }, depth };
+		return BuildMesh(generator, parallelThreshold);
+	}
+
+	// 依次进行顶点缓存、过度绘制和顶点读取优化，只处理三角形网格
+	// 生成器按行列顺序输出三角形，以 15 x 15 的球为例 ACMR 由 1.07 降为 0.70(16 项 FIFO 缓存)
+	inline void OptimizeMesh(IndexedMesh& mesh, unsigned cacheSize = VertexCacheSize)
+	{
+		if (mesh.mode != GL_TRIANGLES || mesh.indices.empty())
+		{
+			return;
+		}
+
+		std::vector<size_t> clusters;
+		mesh.indices = OptimizeVertexCache(make_span(mesh.indices), mesh.vertices.size(), &clusters, cacheSize);
+		mesh.indices = OptimizeOverdraw(make_span(mesh.indices), make_span(mesh.vertices), clusters);
+
+		size_t count;
+		std::vector<GLuint> remap = OptimizeVertexFetch(make_span(mesh.indices), mesh.vertices.size(), count);
+		mesh.vertices = RemapVertices(mesh.vertices, remap, count);
+		if (!mesh.normals.empty())
+		{
+			mesh.normals = RemapVertices(mesh.normals, remap, count);
+		}
+	}
+
+	// 把索引上传到当前 VAO 绑定的 GL_ELEMENT_ARRAY_BUFFER，
+	// 顶点数不超过 65536 时转为 16 位索引，返回 glDrawElements 应使用的索引类型
+	inline GLenum BufferIndices(span<const GLuint> indices, size_t vertexCount, GLenum usage)
+	{
+		if (vertexCount <= 65536)
+		{
+			std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+			BufferData(GL_ELEMENT_ARRAY_BUFFER, make_span(shortIndices), usage);
+			return GL_UNSIGNED_SHORT;
+		}
+
+		BufferData(GL_ELEMENT_ARRAY_BUFFER, indices, usage);
+		return GL_UNSIGNED_INT;
+	}
+
+	inline GLenum BufferIndices(const IndexedMesh& mesh, GLenum usage)
+	{
+		return BufferIndices(make_span(mesh.indices), mesh.vertices.size(), usage);
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  MeshBuffers - 已上传到 GPU 的网格
+	//
+	//    顶点缓冲区是 Planar 排列的 VertexBuffer(见 vertex.h)：属性 "position" 为全部位置，
+	//    位置都在 [-1, 1] 内时用 snorm16x4，否则用 half4；之后是属性 "normal"，
+	//    为全部法向(八面体编码的 snorm16x2，shader 中为 vec2，需解码)，没有法向的网格没有这个属性。
+	//    VAO 记录的是 shader 的属性索引，所以 VAO 仍由各程序用 vertexArray 创建，
+	//    用同一个网格的多个 VAO 共用这里的缓冲区
+	//
+
+	struct MeshBuffers
+	{
+		VertexBuffer  vertices;
+		GLuint        indexBuffer = 0;			// 0 表示没有索引，用 glDrawArrays 绘制
+		GLenum        mode = GL_TRIANGLES;
+		GLenum        indexType = GL_UNSIGNED_SHORT;
+		GLsizei       vertexCount = 0;
+		GLsizei       indexCount = 0;
+		size_t        bytes = 0;				// 顶点和索引共占用的显存
+
+		// 在当前 VAO 上设置位置属性
+		void attribPosition(GLuint index) const
+		{
+			vertices.bind(index, "position");
+		}
+
+		// 在当前 VAO 上设置法向属性
+		void attribNormal(GLuint index) const
+		{
+			vertices.bind(index, "normal");
+		}
+
+		// 把索引缓冲区绑定到当前 VAO
+		void bindIndices() const
+		{
+			if (indexBuffer)
+			{
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+			}
+		}
+
+		// 在当前 VAO 上设置位置(和法向)属性并绑定索引
+		void bind(GLuint position) const
+		{
+			attribPosition(position);
+			bindIndices();
+		}
+
+		void bind(GLuint position, GLuint normal) const
+		{
+			attribPosition(position);
+			attribNormal(normal);
+			bindIndices();
+		}
+
+		// 新建一个 VAO，按 bindings 设置属性("position"、"normal")并绑定索引，返回后该 VAO 为当前 VAO
+		GLuint vertexArray(std::initializer_list<VertexBinding> bindings) const
+		{
+			GLuint vao = vertices.vertexArray(bindings);
+			bindIndices();
+			return vao;
+		}
+
+		GLuint vertexArray(GLuint position) const
+		{
+			return vertexArray({ { position, "position" } });
+		}
+
+		GLuint vertexArray(GLuint position, GLuint normal) const
+		{
+			return vertexArray({ { position, "position" }, { normal, "normal" } });
+		}
+
+		// 用当前 VAO 绘制整个网格
+		void draw() const
+		{
+			draw(0, indexBuffer ? indexCount : vertexCount);
+		}
+
+		// 用当前 VAO 绘制第 first 个索引(没有索引时为顶点)开始的 count 个
+		void draw(GLsizei first, GLsizei count) const
+		{
+			if (indexBuffer)
+			{
+				size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+				glDrawElements(mode, count, indexType, BUFFER_OFFSET(first * indexSize));
+			}
+			else
+			{
+				glDrawArrays(mode, first, count);
+			}
+		}
+
+		// 删除缓冲区(由 UploadMesh 直接得到、不在 MeshCache 中的网格)
+		void release()
+		{
+			vertices.release();
+			if (indexBuffer)
+			{
+				glDeleteBuffers(1, &indexBuffer);
+			}
+			indexBuffer = 0;
+		}
+	};
+
+	namespace detail
+	{
+		// 网格顶点缓冲区的布局：位置(snorm16x4 或 half4)，有法向时后面是法向；
+		// 数据可以为空(只用于计算偏移，见 EmitMesh)
+		template <typename Position>
+		VertexLayout meshVertexLayout(span<const Position> positions, span<const snorm16x2> normals)
+		{
+			VertexLayout layout(VertexLayout::Planar);
+			layout.attribute("position", positions);
+			if (normals.size())
+			{
+				layout.attribute("normal", normals);
+			}
+			return layout;
+		}
+	}
+
+	// 上传网格，返回的缓冲区不依赖于当前 VAO(索引缓冲区绑定时临时解绑 VAO)
+	inline MeshBuffers UploadMesh(const IndexedMesh& mesh, GLenum usage = GL_STATIC_DRAW)
+	{
+		MeshBuffers buffers;
+		buffers.mode = mesh.mode;
+		buffers.vertexCount = (GLsizei)mesh.vertices.size();
+		buffers.indexCount = mesh.indexCount();
+
+		GLfloat extent = 0.0f;
+		for (const vec3& v : mesh.vertices)
+		{
+			extent = std::fmax(extent, std::fmax(std::fabs(v.x), std::fmax(std::fabs(v.y), std::fabs(v.z))));
+		}
+		std::vector<snorm16x2> normals = PackNormals(make_span(mesh.normals));
+		if (extent <= 1.0f)
+		{
+			std::vector<snorm16x4> positions = PackArray<snorm16x4>(make_span(mesh.vertices));
+			buffers.vertices = detail::meshVertexLayout<snorm16x4>(make_span(positions), make_span(normals)).upload(usage);
+		}
+		else
+		{
+			std::vector<half4> positions = PackArray<half4>(make_span(mesh.vertices));
+			buffers.vertices = detail::meshVertexLayout<half4>(make_span(positions), make_span(normals)).upload(usage);
+		}
+		buffers.bytes = buffers.vertices.bytes;
+
+		if (!mesh.indices.empty())
+		{
+			// GL_ELEMENT_ARRAY_BUFFER 的绑定属于 VAO，先解绑，以免改动调用者当前的 VAO
+			GLint vao;
+			glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+			glBindVertexArray(0);
+
+			glGenBuffers(1, &buffers.indexBuffer);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBuffer);
+			buffers.indexType = BufferIndices(mesh, usage);
+			buffers.bytes += buffers.indexCount * (buffers.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+
+			glBindVertexArray(vao);
+		}
+
+		return buffers;
+	}
+
+	// glUnmapBuffer 返回 GL_FALSE(显存内容丢失)时重新写入的最多次数，之后改用 glBufferData 上传
+	const int MapBufferRetries = 3;
+
+	namespace detail
+	{
+		// 映射 buffers 的缓冲区并让 generator 写入；glUnmapBuffer 返回 GL_FALSE 时重新生成，
+		// 映射失败(例如显存不足)或重试 MapBufferRetries 次仍失败时返回 false，缓冲区已解除映射
+		template <typename Position, typename Index, typename Generator>
+		bool emitMesh(const Generator& generator, const MeshLayout& layout, const MeshBuffers& buffers, size_t parallelThreshold)
+		{
+			const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+			for (int attempt = 0; attempt < MapBufferRetries; attempt++)
+			{
+				MeshEmitter<Position, snorm16x2, Index> out;
+				out.mapped = true;
+
+				const VertexBuffer& vb = buffers.vertices;
+				glBindBuffer(GL_ARRAY_BUFFER, vb.buffer);
+				GLubyte* vertices = static_cast<GLubyte*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, vb.bytes, access));
+				if (!vertices)
+				{
+					return false;
+				}
+				out.positions = make_span(reinterpret_cast<Position*>(vertices + vb.find("position")->offset), layout.vertexCount);
+				if (const VertexAttrib* normal = vb.find("normal"))
+				{
+					out.normals = make_span(reinterpret_cast<snorm16x2*>(vertices + normal->offset), layout.vertexCount);
+				}
+				if (buffers.indexBuffer)
+				{
+					glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBuffer);
+					out.indices = MapBufferRange<Index>(GL_ELEMENT_ARRAY_BUFFER, 0, layout.indexCount, access);
+					if (out.indices.empty())
+					{
+						glUnmapBuffer(GL_ARRAY_BUFFER);
+						return false;
+					}
+				}
+
+				generator.emit(out, parallelThreshold);
+
+				bool done = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+				if (buffers.indexBuffer)
+				{
+					done = glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE && done;
+				}
+				if (done)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+
+	// 用生成器生成网格并直接写入映射的 GPU 缓冲区，不分配 CPU 数组，也没有 UploadMesh 中的格式转换拷贝，
+	// 大网格的内存峰值减半以上；格式与 UploadMesh 相同(位置按 layout().extent 选择 snorm16x4 或 half4，
+	// 法向为八面体编码，顶点数不超过 65536 时用 16 位索引)。顶点不经过 OptimizeMesh，生成顺序即绘制顺序。
+	// 缓冲区不能映射时改为 BuildMesh + UploadMesh，结果相同，只是多用一份 CPU 内存
+	template <typename Generator>
+	MeshBuffers EmitMesh(const Generator& generator, GLenum usage = GL_STATIC_DRAW,
+		size_t parallelThreshold = BatchParallelThreshold)
+	{
+		MeshLayout layout = generator.layout();
+
+		MeshBuffers buffers;
+		buffers.mode = layout.mode;
+		buffers.vertexCount = (GLsizei)layout.vertexCount;
+		buffers.indexCount = (GLsizei)layout.indexCount;
+		// 只分配缓冲区，偏移由与 UploadMesh 相同的布局给出
+		bool snorm = layout.extent <= 1.0f;
+		span<const snorm16x2> normals(nullptr, layout.normals ? layout.vertexCount : 0);
+		if (snorm)
+		{
+			buffers.vertices = detail::meshVertexLayout(span<const snorm16x4>(nullptr, layout.vertexCount), normals).allocate(usage);
+		}
+		else
+		{
+			buffers.vertices = detail::meshVertexLayout(span<const half4>(nullptr, layout.vertexCount), normals).allocate(usage);
+		}
+		buffers.bytes = buffers.vertices.bytes;
+
+		// GL_ELEMENT_ARRAY_BUFFER 的绑定属于 VAO，先解绑，以免改动调用者当前的 VAO
+		GLint vao;
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+		glBindVertexArray(0);
+
+		bool shortIndices = layout.vertexCount <= 65536;
+		if (layout.indexCount)
+		{
+			buffers.indexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+			size_t indexBytes = layout.indexCount * (shortIndices ? sizeof(GLushort) : sizeof(GLuint));
+			glGenBuffers(1, &buffers.indexBuffer);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBuffer);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, NULL, usage);
+		}
+
+		bool emitted;
+		if (snorm && shortIndices)
+		{
+			emitted = detail::emitMesh<snorm16x4, GLushort>(generator, layout, buffers, parallelThreshold);
+		}
+		else if (snorm)
+		{
+			emitted = detail::emitMesh<snorm16x4, GLuint>(generator, layout, buffers, parallelThreshold);
+		}
+		else if (shortIndices)
+		{
+			emitted = detail::emitMesh<half4, GLushort>(generator, layout, buffers, parallelThreshold);
+		}
+		else
+		{
+			emitted = detail::emitMesh<half4, GLuint>(generator, layout, buffers, parallelThreshold);
+		}
+		buffers.bytes += buffers.indexCount * (shortIndices ? sizeof(GLushort) : sizeof(GLuint));
+
+		glBindVertexArray(vao);
+		if (!emitted)
+		{
+			buffers.release();
+			return UploadMesh(BuildMesh(generator, parallelThreshold), usage);
+		}
+		return buffers;
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  MeshCache - 按生成器和参数缓存的网格
+	//
+	//    MeshCache::Sphere(1.0, 15, 15) 第一次调用时生成并上传，以后返回同一个 MeshBuffers；
+	//    返回的引用在 Clear() 之前一直有效。
+	//    键中的浮点参数用 %.9g 格式化：9 位有效数字可以区分任意两个不同的 float，
+	//    %g 只有 6 位，1.0000001f 与 1.0f 会得到同一个键
+	//
+
+	class MeshCache
+	{
+		static std::map<std::string, MeshBuffers>& entries()
+		{
+			static std::map<std::string, MeshBuffers> cache;
+			return cache;
+		}
+
+	public:
+		// 按键查找，没有时调用 build() 生成网格并上传
+		template <typename Build>
+		static const MeshBuffers& Get(const std::string& key, Build build)
+		{
+			std::map<std::string, MeshBuffers>& cache = entries();
+			auto it = cache.find(key);
+			if (it == cache.end())
+			{
+				IndexedMesh mesh = build();
+				OptimizeMesh(mesh);
+				it = cache.emplace(key, UploadMesh(mesh)).first;
+			}
+			return it->second;
+		}
+
+		static const MeshBuffers& Sphere(GLfloat radius, GLsizei columns, GLsizei rows)
+		{
+			char key[96];
+			snprintf(key, sizeof(key), "sphere(r=%.9g,%d,%d)", radius, columns, rows);
+			return Get(key, [=] { return BuildSphereMesh(radius, columns, rows); });
+		}
+
+		static const MeshBuffers& Torus(GLfloat majorRadius, GLfloat minorRadius, GLsizei numMajor, GLsizei numMinor)
+		{
+			char key[96];
+			snprintf(key, sizeof(key), "torus(R=%.9g,r=%.9g,%d,%d)", majorRadius, minorRadius, numMajor, numMinor);
+			return Get(key, [=] { return BuildTorusMesh(majorRadius, minorRadius, numMajor, numMinor); });
+		}
+
+		static const MeshBuffers& Ring(GLfloat radius, GLsizei num)
+		{
+			char key[96];
+			snprintf(key, sizeof(key), "ring(r=%.9g,%d)", radius, num);
+			return Get(key, [=] { return BuildRingMesh(radius, num); });
+		}
+
+		static const MeshBuffers& Ground(GLfloat extent, GLfloat step)
+		{
+			char key[96];
+			snprintf(key, sizeof(key), "ground(%.9g,%.9g)", extent, step);
+			return Get(key, [=] { return BuildGroundMesh(extent, step); });
+		}
+
+		static const MeshBuffers& Grid(GLfloat extent, GLfloat step)
+		{
+			char key[96];
+			snprintf(key, sizeof(key), "grid(%.9g,%.9g)", extent, step);
+			return Get(key, [=] { return BuildGridMesh(extent, step); });
+		}
+
+		// 缓存的网格个数和共占用的显存
+		static size_t Size() { return entries().size(); }
+
+		static size_t Bytes()
+		{
+			size_t bytes = 0;
+			for (const auto& entry : entries())
+			{
+				bytes += entry.second.bytes;
+			}
+			return bytes;
+		}
+
+		// 删除所有缓冲区，之前返回的 MeshBuffers 引用全部失效
+		static void Clear()
+		{
+			for (auto& entry : entries())
+			{
+				entry.second.release();
+			}
+			entries().clear();
+		}
+	};
+
+}  // namespace Angel
+
+#endif // __ANGEL_MESH_H__
@@ -3,24 +3,39 @@
 const int LightNum = 3; // 光源数量
 
 in vec3 vPosition;	// 顶点位置(建模坐标系)
-in vec3 vNormal;	// 顶点法向(建模坐标系)
+in vec2 vNormal;	// 顶点法向(建模坐标系，八面体编码，见 pack.h)
 
 out vec3 fN;	// 法向(观察坐标系)
 out vec3 fE;	// 观察向量(观察坐标系)
 out vec3 fL[LightNum];	// 光照向量(观察坐标系)
 out float dist;	// 顶点到手电筒光源距离
 
-uniform mat4 ModelView;		// 模视矩阵
+uniform vec4 ModelView[3];	// 模视矩阵(3x4 仿射矩阵的三行，最后一行恒为 (0, 0, 0, 1))
 uniform mat4 Projection;	// 投影矩阵
 uniform vec4 LightPosition[LightNum];	// 光源位置(观察坐标系)
 
+// 八面体编码的法向解码为单位向量
+vec3 DecodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
+// 用模视矩阵变换点(v.w = 1)或方向(v.w = 0)
+vec3 TransformModelView(vec4 v)
+{
+	return vec3(dot(ModelView[0], v), dot(ModelView[1], v), dot(ModelView[2], v));
+}
+
 void main()
 {
     // 将顶点坐标转到观察坐标系下(在观察坐标系计算光照)
-    vec3 pos = (ModelView * vec4(vPosition, 1.0)).xyz;
+    vec3 pos = TransformModelView(vec4(vPosition, 1.0));
 	fE = -pos;		// 观察者方向向量
 	// 将顶点法向转到观察坐标系下(针对模视变换不含非均匀缩放情况)
-    fN = (ModelView * vec4(vNormal, 0.0)).xyz;
+    fN = TransformModelView(vec4(DecodeOctahedral(vNormal), 0.0));
 	
 	for(int i = 0; i < LightNum; i++){	
 		if(LightPosition[i].w != 0) // 近距离光源
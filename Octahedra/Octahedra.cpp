@@ -17,12 +17,15 @@ const float AngleStepMin = 0.1f;	// 角度变化步长最小值
 int WireFrameOn = 0;			// 线框模式标志，当等于1时为线框模式
 
 /*定义类的别名*/
-typedef Angel::vec4 point4;
-typedef Angel::vec4 color4;
+// 顶点数据按压缩格式存放：坐标都在 [-1, 1] 内，用 snorm16(8 字节)，颜色用 unorm8(4 字节)
+// 每个顶点由 32 字节(位置 + 颜色)减为 12 字节
+typedef Angel::snorm16x4 point4;
+typedef Angel::unorm8x4 color4;
 
 // 以原点为中心八面体顶点
 // 使用齐次坐标，第4个坐标都为1，表示是点而不是向量
-point4 vertices[6] =
+// 以下顶点和颜色表均为 constexpr，在编译期生成，存放于只读数据段
+constexpr point4 vertices[6] =
 {
 	point4(0.0, 1.0, 0.0, 1.0), // 顶
 	point4(-1.0, 0.0, 0.0, 1.0), // 左
@@ -33,7 +36,7 @@ point4 vertices[6] =
 };
 
 // RGBA颜色
-color4 colors[10] =
+constexpr color4 colors[10] =
 {
 	color4(1.0, 0.0, 0.0, 1.0),	// 红
 	color4(1.0, 1.0, 0.0, 1.0),	// 黄
@@ -51,7 +54,7 @@ color4 colors[10] =
 enum { RED, YELLOW, GREEN, BLUE, HALF_RED, HALF_YELLOW, HALF_GREEN, HALF_BLUE, WHITE, BLACK };
 
 const int NumVertices = 24;	// 8个面，每个面1个三角形，每个三角形3个顶点，共24个顶点
-point4 points[NumVertices] =
+constexpr point4 points[NumVertices] =
 {
 	// 立方体顶点坐标数组
 	// 上半部分
@@ -67,7 +70,7 @@ point4 points[NumVertices] =
 };
 
 // 右边图形顶点颜色数组
-color4 colorsRight[NumVertices] =
+constexpr color4 colorsRight[NumVertices] =
 {
 	// 上半部分
 	colors[RED], colors[RED], colors[RED],
@@ -83,7 +86,7 @@ color4 colorsRight[NumVertices] =
 };
 
 // 左边图形顶点颜色数组(注意和points中顶点序列对应)
-color4 colorsLeft[NumVertices] =
+constexpr color4 colorsLeft[NumVertices] =
 {
 	// 上半部分
 	colors[WHITE], colors[RED], colors[GREEN],
@@ -98,7 +101,9 @@ color4 colorsLeft[NumVertices] =
 	colors[YELLOW], colors[BLACK], colors[RED],
 };
 
-GLuint vColor;	// shader中顶点属性变量"vColor"的索引
+// 两种颜色模式各用一个VAO，共用同一个缓冲区中的顶点位置，绘制时只需切换VAO
+GLuint vaoFlat;		// 右方图形：每个面一种颜色
+GLuint vaoSmooth;	// 左方图形：顶点颜色插值
 GLuint MVPMatrix;	// shader中uniform变量"MVPMatrix"的索引
 GLuint bSmooth;	// shader中uniform变量"bSmooth"的索引
 
@@ -198,15 +203,7 @@ void Display(void)
 		transform1
 	);
 	glUniform1f(bSmooth, 0);  // 不使用平滑着色，即使用平面着色
-	// 为顶点属性数组提供数据(数据存放在之前buffer对象中)
-	glVertexAttribPointer(
-		vColor,				// 属性变量索引
-		4,					// 每个顶点属性的分量个数
-		GL_FLOAT,			// 数组数据类型
-		GL_FALSE,			// 是否进行归一化处理
-		0,					// 在数组中相邻属性成员间的间隔(以字节为单位)
-		BUFFER_OFFSET(sizeof(points) + sizeof(colorsLeft))  // 第一个属性值在buffer中的偏移量
-	);
+	glBindVertexArray(vaoFlat);
 	glDrawArrays(GL_TRIANGLES, 0, NumVertices);	// 绘制
 
 	/*绘制左方图形*/
@@ -218,15 +215,7 @@ void Display(void)
 		transform2
 	);
 	glUniform1f(bSmooth, 1);  // 使用平滑着色
-	// 为顶点属性数组提供数据(数据存放在之前buffer对象中)
-	glVertexAttribPointer(
-		vColor,				// 属性变量索引
-		4,					// 每个顶点属性的分量个数
-		GL_FLOAT,			// 数组数据类型
-		GL_FALSE,			// 是否进行归一化处理
-		0,					// 在数组中相邻属性成员间的间隔(以字节为单位)
-		BUFFER_OFFSET(sizeof(points))  // 第一个属性值在buffer中的偏移量
-	);
+	glBindVertexArray(vaoSmooth);
 	glDrawArrays(GL_TRIANGLES, 0, NumVertices);	// 绘制
 
 	glutSwapBuffers();	// 交换前后端缓存
@@ -236,53 +225,27 @@ void Display(void)
 // 初始化函数
 void Init()
 {
-	/*创建一个顶点数组对象(VAO)*/
-	GLuint vao;
-	glGenVertexArrays(1, &vao);  // 生成一个未用的VAO ID，存于变量vao中
-	glBindVertexArray(vao);      // 创建id为vao的VAO，并绑定为当前VAO
-
-	/*创建并初始化一个缓冲区对象(Buffer Object)*/
-	GLuint buffer;
-	glGenBuffers(1, &buffer); // 生成一个未用的缓冲区对象ID，存于变量buffer中
-	// 创建id为buffer的Array Buffer对象，并绑定为当前Array Buffer对象
-	glBindBuffer(GL_ARRAY_BUFFER, buffer);
-	// 为Buffer对象在GPU端申请空间，并提供数据
-	glBufferData(GL_ARRAY_BUFFER,	// Buffer类型
-		sizeof(points) + sizeof(colorsLeft) + sizeof(colorsRight),  // 申请空间大小(存坐标和颜色)
-		NULL,			// 暂不提供数据
-		GL_STATIC_DRAW	// 表明将如何使用Buffer的标志(GL_STATIC_DRAW含义是一次提供数据，多遍绘制)
-	);
-	glBufferSubData(GL_ARRAY_BUFFER, 0,
-		sizeof(points), points);			// 加载顶点位置数据
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(points),
-		sizeof(colorsLeft), colorsLeft);	// 加载颜色数据，注意偏移量的变化
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(points) + sizeof(colorsLeft),
-		sizeof(colorsRight), colorsRight);	// 加载颜色数据，注意偏移量的变化
-
 	/*加载shader并使用所得到的shader程序*/
 	// InitShader为InitShader.cpp中定义的函数，参数分别为顶点和片元shader的文件名
 	// 返回值为shader程序对象的ID
 	GLuint program = InitShader("vOctahedra.glsl", "fOctahedra.glsl");
 	glUseProgram(program); // 使用该shader程序
 
-	/*初始化顶点着色器中的顶点位置属性*/
+	/*创建并初始化一个缓冲区对象(Buffer Object)*/
+	// 顶点布局列出缓冲区中的各个属性，偏移量由布局计算，
+	// 分量个数、类型和归一化由数组元素的类型(point4、color4)决定
+	VertexLayout layout(VertexLayout::Planar);	// 位置、左方颜色、右方颜色依次连续存放
+	layout.attribute("position", make_span(points))
+		.attribute("colorsLeft", make_span(colorsLeft))
+		.attribute("colorsRight", make_span(colorsRight));
+	VertexBuffer buffer = layout.upload(GL_STATIC_DRAW);
+
+	/*为两种颜色模式各创建一个顶点数组对象(VAO)*/
 	// 获取shader程序中属性变量的位置(索引)
 	GLuint vPosition = glGetAttribLocation(program, "vPosition");
-	glEnableVertexAttribArray(vPosition);	// 启用顶点属性数组
-	// 为顶点属性数组提供数据(数据存放在之前buffer对象中)
-	glVertexAttribPointer(
-		vPosition,			// 属性变量索引
-		4,					// 每个顶点属性的分量个数
-		GL_FLOAT,			// 数组数据类型
-		GL_FALSE,			// 是否进行归一化处理
-		0,					// 在数组中相邻属性成员间的间隔(以字节为单位)
-		BUFFER_OFFSET(0)    // 第一个属性值在buffer中的偏移量
-	);
-
-	/*初始化顶点着色器中的顶点颜色属性*/
-	// 获取shader程序中属性变量的位置(索引)
-	vColor = glGetAttribLocation(program, "vColor");
-	glEnableVertexAttribArray(vColor);	// 启用顶点属性数组
+	GLuint vColor = glGetAttribLocation(program, "vColor");
+	vaoFlat = buffer.vertexArray({ { vPosition, "position" }, { vColor, "colorsRight" } });
+	vaoSmooth = buffer.vertexArray({ { vPosition, "position" }, { vColor, "colorsLeft" } });
 
 	// 获取uniform变量索引
 	MVPMatrix = glGetUniformLocation(program, "MVPMatrix");
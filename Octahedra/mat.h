@@ -7,8 +7,36 @@
 #ifndef __ANGEL_MAT_H__
 #define __ANGEL_MAT_H__
 
+#include <stddef.h>
+#include <thread>
+#include <vector>
 #include "vec.h"
 
+//----------------------------------------------------------------------------
+//
+//  --- SIMD configuration ---
+//
+//   mat4 的乘法按编译目标自动选择 AVX / SSE / NEON 实现，
+//   定义 ANGEL_NO_SIMD 可强制使用标量实现(用于调试和对比测试)
+//
+
+#if !defined(ANGEL_NO_SIMD)
+#  if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#    define ANGEL_SIMD_NEON
+#    include <arm_neon.h>
+#  elif defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || \
+		(defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#    define ANGEL_SIMD_SSE
+#    include <xmmintrin.h>
+#    if defined(__AVX__)
+#      define ANGEL_SIMD_AVX
+#      include <immintrin.h>
+#    endif
+#  endif
+#endif
+
+#include "trig.h"
+
 namespace Angel
 {
 
@@ -27,50 +55,37 @@ namespace Angel
 		//  --- Constructors and Destructors ---
 		//
 
-		mat2(const GLfloat d = GLfloat(1.0))  // Create a diagional matrix
-		{
-			_m[0].x = d;  _m[1].y = d;
-		}
-
-		mat2(const vec2& a, const vec2& b)
-		{
-			_m[0] = a;  _m[1] = b;
-		}
+		constexpr mat2(const GLfloat d = GLfloat(1.0)) :  // Create a diagional matrix
+			_m{ vec2(d, 0.0), vec2(0.0, d) } {}
 
-		mat2(GLfloat m00, GLfloat m10, GLfloat m01, GLfloat m11)
-		{
-			_m[0] = vec2(m00, m01); _m[1] = vec2(m10, m11);
-		}
+		constexpr mat2(const vec2& a, const vec2& b) :
+			_m{ a, b } {}
 
-		mat2(const mat2& m) {
-			if (*this != m) {
-				_m[0] = m._m[0];
-				_m[1] = m._m[1];
-			}
-		}
+		constexpr mat2(GLfloat m00, GLfloat m10, GLfloat m01, GLfloat m11) :
+			_m{ vec2(m00, m01), vec2(m10, m11) } {}
 
 		//
 		//  --- Indexing Operator ---
 		//
 
-		vec2& operator [] (int i) { return _m[i]; }
-		const vec2& operator [] (int i) const { return _m[i]; }
+		constexpr vec2& operator [] (int i) { return _m[i]; }
+		constexpr const vec2& operator [] (int i) const { return _m[i]; }
 
 		//
 		//  --- (non-modifying) Arithmatic Operators ---
 		//
 
-		mat2 operator + (const mat2& m) const
+		constexpr mat2 operator + (const mat2& m) const
 		{
 			return mat2(_m[0] + m[0], _m[1] + m[1]);
 		}
 
-		mat2 operator - (const mat2& m) const
+		constexpr mat2 operator - (const mat2& m) const
 		{
 			return mat2(_m[0] - m[0], _m[1] - m[1]);
 		}
 
-		mat2 operator * (const GLfloat s) const
+		constexpr mat2 operator * (const GLfloat s) const
 		{
 			return mat2(s * _m[0], s * _m[1]);
 		}
@@ -88,7 +103,7 @@ namespace Angel
 			return *this * r;
 		}
 
-		friend mat2 operator * (const GLfloat s, const mat2& m)
+		friend constexpr mat2 operator * (const GLfloat s, const mat2& m)
 		{
 			return m * s;
 		}
@@ -112,19 +127,19 @@ namespace Angel
 		//  --- (modifying) Arithmetic Operators ---
 		//
 
-		mat2& operator += (const mat2& m)
+		constexpr mat2& operator += (const mat2& m)
 		{
 			_m[0] += m[0];  _m[1] += m[1];
 			return *this;
 		}
 
-		mat2& operator -= (const mat2& m)
+		constexpr mat2& operator -= (const mat2& m)
 		{
 			_m[0] -= m[0];  _m[1] -= m[1];
 			return *this;
 		}
 
-		mat2& operator *= (const GLfloat s)
+		constexpr mat2& operator *= (const GLfloat s)
 		{
 			_m[0] *= s;  _m[1] *= s;
 			return *this;
@@ -209,10 +224,11 @@ namespace Angel
 			A[1][0] * B[1][0], A[1][1] * B[1][1]);
 	}
 
-	inline mat2 transpose(const mat2& A)
+	inline constexpr mat2 transpose(const mat2& A)
 	{
-		return mat2(A[0][0], A[1][0],
-			A[0][1], A[1][1]);
+		// 构造函数按列传入元素，A 的第 i 行即结果的第 i 列
+		return mat2(A[0].x, A[0].y,
+			A[1].x, A[1].y);
 	}
 
 	//----------------------------------------------------------------------------
@@ -230,57 +246,41 @@ namespace Angel
 		//  --- Constructors and Destructors ---
 		//
 
-		mat3(const GLfloat d = GLfloat(1.0))  // Create a diagional matrix
-		{
-			_m[0].x = d;  _m[1].y = d;  _m[2].z = d;
-		}
+		constexpr mat3(const GLfloat d = GLfloat(1.0)) :  // Create a diagional matrix
+			_m{ vec3(d, 0.0, 0.0), vec3(0.0, d, 0.0), vec3(0.0, 0.0, d) } {}
 
-		mat3(const vec3& a, const vec3& b, const vec3& c)
-		{
-			_m[0] = a;  _m[1] = b;  _m[2] = c;
-		}
+		constexpr mat3(const vec3& a, const vec3& b, const vec3& c) :
+			_m{ a, b, c } {}
 
-		mat3(GLfloat m00, GLfloat m10, GLfloat m20,
+		constexpr mat3(GLfloat m00, GLfloat m10, GLfloat m20,
 			GLfloat m01, GLfloat m11, GLfloat m21,
-			GLfloat m02, GLfloat m12, GLfloat m22)
-		{
-			_m[0] = vec3(m00, m01, m02);
-			_m[1] = vec3(m10, m11, m12);
-			_m[2] = vec3(m20, m21, m22);
-		}
-
-		mat3(const mat3& m)
-		{
-			if (*this != m)
-			{
-				_m[0] = m._m[0];
-				_m[1] = m._m[1];
-				_m[2] = m._m[2];
-			}
-		}
+			GLfloat m02, GLfloat m12, GLfloat m22) :
+			_m{ vec3(m00, m01, m02),
+				vec3(m10, m11, m12),
+				vec3(m20, m21, m22) } {}
 
 		//
 		//  --- Indexing Operator ---
 		//
 
-		vec3& operator [] (int i) { return _m[i]; }
-		const vec3& operator [] (int i) const { return _m[i]; }
+		constexpr vec3& operator [] (int i) { return _m[i]; }
+		constexpr const vec3& operator [] (int i) const { return _m[i]; }
 
 		//
 		//  --- (non-modifying) Arithmatic Operators ---
 		//
 
-		mat3 operator + (const mat3& m) const
+		constexpr mat3 operator + (const mat3& m) const
 		{
 			return mat3(_m[0] + m[0], _m[1] + m[1], _m[2] + m[2]);
 		}
 
-		mat3 operator - (const mat3& m) const
+		constexpr mat3 operator - (const mat3& m) const
 		{
 			return mat3(_m[0] - m[0], _m[1] - m[1], _m[2] - m[2]);
 		}
 
-		mat3 operator * (const GLfloat s) const
+		constexpr mat3 operator * (const GLfloat s) const
 		{
 			return mat3(s * _m[0], s * _m[1], s * _m[2]);
 		}
@@ -300,7 +300,7 @@ namespace Angel
 			return *this * r;
 		}
 
-		friend mat3 operator * (const GLfloat s, const mat3& m)
+		friend constexpr mat3 operator * (const GLfloat s, const mat3& m)
 		{
 			return m * s;
 		}
@@ -324,19 +324,19 @@ namespace Angel
 		//  --- (modifying) Arithmetic Operators ---
 		//
 
-		mat3& operator += (const mat3& m)
+		constexpr mat3& operator += (const mat3& m)
 		{
 			_m[0] += m[0];  _m[1] += m[1];  _m[2] += m[2];
 			return *this;
 		}
 
-		mat3& operator -= (const mat3& m)
+		constexpr mat3& operator -= (const mat3& m)
 		{
 			_m[0] -= m[0];  _m[1] -= m[1];  _m[2] -= m[2];
 			return *this;
 		}
 
-		mat3& operator *= (const GLfloat s)
+		constexpr mat3& operator *= (const GLfloat s)
 		{
 			_m[0] *= s;  _m[1] *= s;  _m[2] *= s;
 			return *this;
@@ -429,13 +429,156 @@ namespace Angel
 			A[2][0] * B[2][0], A[2][1] * B[2][1], A[2][2] * B[2][2]);
 	}
 
-	inline mat3 transpose(const mat3& A)
+	inline constexpr mat3 transpose(const mat3& A)
 	{
-		return mat3(A[0][0], A[1][0], A[2][0],
-			A[0][1], A[1][1], A[2][1],
-			A[0][2], A[1][2], A[2][2]);
+		// 构造函数按列传入元素，A 的第 i 行即结果的第 i 列
+		return mat3(A[0].x, A[0].y, A[0].z,
+			A[1].x, A[1].y, A[1].z,
+			A[2].x, A[2].y, A[2].z);
 	}
 
+	//----------------------------------------------------------------------------
+	//
+	//  mat4 kernels
+	//
+	//    矩阵为行主序的 16 个 GLfloat(与 mat4 的内存布局一致)。
+	//    输入全部读入寄存器后才写出结果，因此输出可以与任一输入重叠。
+	//
+
+	namespace detail
+	{
+		// 标量实现：c = a * b
+		inline void mat4MulScalar(const GLfloat* a, const GLfloat* b, GLfloat* c)
+		{
+			GLfloat r[16];
+
+			for (int i = 0; i < 4; ++i)
+			{
+				const GLfloat* ai = a + 4 * i;
+				for (int j = 0; j < 4; ++j)
+				{
+					r[4 * i + j] = ai[0] * b[j] + ai[1] * b[4 + j]
+						+ ai[2] * b[8 + j] + ai[3] * b[12 + j];
+				}
+			}
+
+			for (int i = 0; i < 16; ++i)
+			{
+				c[i] = r[i];
+			}
+		}
+
+		// 标量实现：r = a * v
+		inline void mat4MulVec4Scalar(const GLfloat* a, const GLfloat* v, GLfloat* r)
+		{
+			GLfloat x = v[0], y = v[1], z = v[2], w = v[3];
+
+			r[0] = a[0] * x + a[1] * y + a[2] * z + a[3] * w;
+			r[1] = a[4] * x + a[5] * y + a[6] * z + a[7] * w;
+			r[2] = a[8] * x + a[9] * y + a[10] * z + a[11] * w;
+			r[3] = a[12] * x + a[13] * y + a[14] * z + a[15] * w;
+		}
+
+		// c = a * b
+		// 结果的第 i 行 = a[i][0] * b第0行 + a[i][1] * b第1行 + a[i][2] * b第2行 + a[i][3] * b第3行
+		inline void mat4Mul(const GLfloat* a, const GLfloat* b, GLfloat* c)
+		{
+#if defined(ANGEL_SIMD_AVX)
+			// 一次处理两行：高低 128 位分别为 a 的相邻两行
+			__m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b));
+			__m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 4));
+			__m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 8));
+			__m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 12));
+			__m256 a01 = _mm256_loadu_ps(a);
+			__m256 a23 = _mm256_loadu_ps(a + 8);
+
+			__m256 c01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x00), b0);
+			c01 = _mm256_add_ps(c01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x55), b1));
+			c01 = _mm256_add_ps(c01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xAA), b2));
+			c01 = _mm256_add_ps(c01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xFF), b3));
+
+			__m256 c23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x00), b0);
+			c23 = _mm256_add_ps(c23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x55), b1));
+			c23 = _mm256_add_ps(c23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xAA), b2));
+			c23 = _mm256_add_ps(c23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xFF), b3));
+
+			_mm256_storeu_ps(c, c01);
+			_mm256_storeu_ps(c + 8, c23);
+#elif defined(ANGEL_SIMD_SSE)
+			__m128 b0 = _mm_loadu_ps(b);
+			__m128 b1 = _mm_loadu_ps(b + 4);
+			__m128 b2 = _mm_loadu_ps(b + 8);
+			__m128 b3 = _mm_loadu_ps(b + 12);
+			__m128 r[4];
+
+			for (int i = 0; i < 4; ++i)
+			{
+				__m128 ai = _mm_loadu_ps(a + 4 * i);
+				__m128 ri = _mm_mul_ps(_mm_shuffle_ps(ai, ai, 0x00), b0);
+				ri = _mm_add_ps(ri, _mm_mul_ps(_mm_shuffle_ps(ai, ai, 0x55), b1));
+				ri = _mm_add_ps(ri, _mm_mul_ps(_mm_shuffle_ps(ai, ai, 0xAA), b2));
+				ri = _mm_add_ps(ri, _mm_mul_ps(_mm_shuffle_ps(ai, ai, 0xFF), b3));
+				r[i] = ri;
+			}
+
+			for (int i = 0; i < 4; ++i)
+			{
+				_mm_storeu_ps(c + 4 * i, r[i]);
+			}
+#elif defined(ANGEL_SIMD_NEON)
+			float32x4_t b0 = vld1q_f32(b);
+			float32x4_t b1 = vld1q_f32(b + 4);
+			float32x4_t b2 = vld1q_f32(b + 8);
+			float32x4_t b3 = vld1q_f32(b + 12);
+			float32x4_t r[4];
+
+			for (int i = 0; i < 4; ++i)
+			{
+				float32x4_t ai = vld1q_f32(a + 4 * i);
+				float32x4_t ri = vmulq_n_f32(b0, vgetq_lane_f32(ai, 0));
+				ri = vmlaq_n_f32(ri, b1, vgetq_lane_f32(ai, 1));
+				ri = vmlaq_n_f32(ri, b2, vgetq_lane_f32(ai, 2));
+				ri = vmlaq_n_f32(ri, b3, vgetq_lane_f32(ai, 3));
+				r[i] = ri;
+			}
+
+			for (int i = 0; i < 4; ++i)
+			{
+				vst1q_f32(c + 4 * i, r[i]);
+			}
+#else
+			mat4MulScalar(a, b, c);
+#endif
+		}
+
+		// r = a * v
+		inline void mat4MulVec4(const GLfloat* a, const GLfloat* v, GLfloat* r)
+		{
+#if defined(ANGEL_SIMD_SSE)
+			__m128 v4 = _mm_loadu_ps(v);
+			__m128 p0 = _mm_mul_ps(_mm_loadu_ps(a), v4);
+			__m128 p1 = _mm_mul_ps(_mm_loadu_ps(a + 4), v4);
+			__m128 p2 = _mm_mul_ps(_mm_loadu_ps(a + 8), v4);
+			__m128 p3 = _mm_mul_ps(_mm_loadu_ps(a + 12), v4);
+
+			// 转置后按列相加，即得到四行各自的点积
+			_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+			_mm_storeu_ps(r, _mm_add_ps(_mm_add_ps(p0, p1), _mm_add_ps(p2, p3)));
+#elif defined(ANGEL_SIMD_NEON)
+			// vld4q 按 4 路交错读取，val[k] 恰好是矩阵的第 k 列
+			float32x4x4_t cols = vld4q_f32(a);
+			float32x4_t v4 = vld1q_f32(v);
+			float32x4_t ri = vmulq_n_f32(cols.val[0], vgetq_lane_f32(v4, 0));
+			ri = vmlaq_n_f32(ri, cols.val[1], vgetq_lane_f32(v4, 1));
+			ri = vmlaq_n_f32(ri, cols.val[2], vgetq_lane_f32(v4, 2));
+			ri = vmlaq_n_f32(ri, cols.val[3], vgetq_lane_f32(v4, 3));
+			vst1q_f32(r, ri);
+#else
+			mat4MulVec4Scalar(a, v, r);
+#endif
+		}
+	}  // namespace detail
+
 	//----------------------------------------------------------------------------
 	//
 	//  mat4.h - 4D square matrix
@@ -451,60 +594,44 @@ namespace Angel
 		//  --- Constructors and Destructors ---
 		//
 
-		mat4(const GLfloat d = GLfloat(1.0))  // Create a diagional matrix
-		{
-			_m[0].x = d;  _m[1].y = d;  _m[2].z = d;  _m[3].w = d;
-		}
+		constexpr mat4(const GLfloat d = GLfloat(1.0)) :  // Create a diagional matrix
+			_m{ vec4(d, 0.0, 0.0, 0.0), vec4(0.0, d, 0.0, 0.0),
+				vec4(0.0, 0.0, d, 0.0), vec4(0.0, 0.0, 0.0, d) } {}
 
-		mat4(const vec4& a, const vec4& b, const vec4& c, const vec4& d)
-		{
-			_m[0] = a;  _m[1] = b;  _m[2] = c;  _m[3] = d;
-		}
+		constexpr mat4(const vec4& a, const vec4& b, const vec4& c, const vec4& d) :
+			_m{ a, b, c, d } {}
 
-		mat4(GLfloat m00, GLfloat m10, GLfloat m20, GLfloat m30,
+		constexpr mat4(GLfloat m00, GLfloat m10, GLfloat m20, GLfloat m30,
 			GLfloat m01, GLfloat m11, GLfloat m21, GLfloat m31,
 			GLfloat m02, GLfloat m12, GLfloat m22, GLfloat m32,
-			GLfloat m03, GLfloat m13, GLfloat m23, GLfloat m33)
-		{
-			_m[0] = vec4(m00, m01, m02, m03);
-			_m[1] = vec4(m10, m11, m12, m13);
-			_m[2] = vec4(m20, m21, m22, m23);
-			_m[3] = vec4(m30, m31, m32, m33);
-		}
-
-		mat4(const mat4& m)
-		{
-			if (*this != m)
-			{
-				_m[0] = m._m[0];
-				_m[1] = m._m[1];
-				_m[2] = m._m[2];
-				_m[3] = m._m[3];
-			}
-		}
+			GLfloat m03, GLfloat m13, GLfloat m23, GLfloat m33) :
+			_m{ vec4(m00, m01, m02, m03),
+				vec4(m10, m11, m12, m13),
+				vec4(m20, m21, m22, m23),
+				vec4(m30, m31, m32, m33) } {}
 
 		//
 		//  --- Indexing Operator ---
 		//
 
-		vec4& operator [] (int i) { return _m[i]; }
-		const vec4& operator [] (int i) const { return _m[i]; }
+		constexpr vec4& operator [] (int i) { return _m[i]; }
+		constexpr const vec4& operator [] (int i) const { return _m[i]; }
 
 		//
 		//  --- (non-modifying) Arithematic Operators ---
 		//
 
-		mat4 operator + (const mat4& m) const
+		constexpr mat4 operator + (const mat4& m) const
 		{
 			return mat4(_m[0] + m[0], _m[1] + m[1], _m[2] + m[2], _m[3] + m[3]);
 		}
 
-		mat4 operator - (const mat4& m) const
+		constexpr mat4 operator - (const mat4& m) const
 		{
 			return mat4(_m[0] - m[0], _m[1] - m[1], _m[2] - m[2], _m[3] - m[3]);
 		}
 
-		mat4 operator * (const GLfloat s) const
+		constexpr mat4 operator * (const GLfloat s) const
 		{
 			return mat4(s * _m[0], s * _m[1], s * _m[2], s * _m[3]);
 		}
@@ -524,26 +651,15 @@ namespace Angel
 			return *this * r;
 		}
 
-		friend mat4 operator * (const GLfloat s, const mat4& m)
+		friend constexpr mat4 operator * (const GLfloat s, const mat4& m)
 		{
 			return m * s;
 		}
 
 		mat4 operator * (const mat4& m) const
 		{
-			mat4  a(0.0);
-
-			for (int i = 0; i < 4; ++i)
-			{
-				for (int j = 0; j < 4; ++j)
-				{
-					for (int k = 0; k < 4; ++k)
-					{
-						a[i][j] += _m[i][k] * m[k][j];
-					}
-				}
-			}
-
+			mat4  a;
+			detail::mat4Mul(*this, m, a);
 			return a;
 		}
 
@@ -551,19 +667,19 @@ namespace Angel
 		//  --- (modifying) Arithematic Operators ---
 		//
 
-		mat4& operator += (const mat4& m)
+		constexpr mat4& operator += (const mat4& m)
 		{
 			_m[0] += m[0];  _m[1] += m[1];  _m[2] += m[2];  _m[3] += m[3];
 			return *this;
 		}
 
-		mat4& operator -= (const mat4& m)
+		constexpr mat4& operator -= (const mat4& m)
 		{
 			_m[0] -= m[0];  _m[1] -= m[1];  _m[2] -= m[2];  _m[3] -= m[3];
 			return *this;
 		}
 
-		mat4& operator *= (const GLfloat s)
+		constexpr mat4& operator *= (const GLfloat s)
 		{
 			_m[0] *= s;  _m[1] *= s;  _m[2] *= s;  _m[3] *= s;
 			return *this;
@@ -571,20 +687,9 @@ namespace Angel
 
 		mat4& operator *= (const mat4& m)
 		{
-			mat4  a(0.0);
-
-			for (int i = 0; i < 4; ++i)
-			{
-				for (int j = 0; j < 4; ++j)
-				{
-					for (int k = 0; k < 4; ++k)
-					{
-						a[i][j] += _m[i][k] * m[k][j];
-					}
-				}
-			}
-
-			return *this = a;
+			// 内核允许输出与输入重叠，直接写回自身，无需临时矩阵
+			detail::mat4Mul(*this, m, *this);
+			return *this;
 		}
 
 		mat4& operator /= (const GLfloat s)
@@ -608,11 +713,9 @@ namespace Angel
 
 		vec4 operator * (const vec4& v) const
 		{  // m * v
-			return vec4(_m[0][0] * v.x + _m[0][1] * v.y + _m[0][2] * v.z + _m[0][3] * v.w,
-				_m[1][0] * v.x + _m[1][1] * v.y + _m[1][2] * v.z + _m[1][3] * v.w,
-				_m[2][0] * v.x + _m[2][1] * v.y + _m[2][2] * v.z + _m[2][3] * v.w,
-				_m[3][0] * v.x + _m[3][1] * v.y + _m[3][2] * v.z + _m[3][3] * v.w
-			);
+			vec4  r;
+			detail::mat4MulVec4(*this, v, r);
+			return r;
 		}
 
 		//
@@ -648,6 +751,38 @@ namespace Angel
 		}
 	};
 
+	//
+	//  --- Layout guarantees ---
+	//
+	//   矩阵按行连续存放 GLfloat，可平凡复制，可直接作为 glUniformMatrix*fv 的数据
+	//
+
+	static_assert(sizeof(mat2) == 4 * sizeof(GLfloat), "mat2 must be four packed GLfloats");
+	static_assert(sizeof(mat3) == 9 * sizeof(GLfloat), "mat3 must be nine packed GLfloats");
+	static_assert(sizeof(mat4) == 16 * sizeof(GLfloat), "mat4 must be sixteen packed GLfloats");
+	static_assert(std::is_trivially_copyable<mat2>::value, "mat2 must be trivially copyable");
+	static_assert(std::is_trivially_copyable<mat3>::value, "mat3 must be trivially copyable");
+	static_assert(std::is_trivially_copyable<mat4>::value, "mat4 must be trivially copyable");
+	static_assert(std::is_standard_layout<mat4>::value, "mat4 must be standard layout");
+
+	//
+	//  --- 16-byte aligned variant ---
+	//
+	//   mat4a 按 16 字节对齐，每行可用对齐加载；运算结果为普通的 mat4
+	//
+
+	class alignas(16) mat4a : public mat4
+	{
+	public:
+		using mat4::mat4;
+
+		constexpr mat4a() : mat4() {}
+		constexpr mat4a(const mat4& m) : mat4(m) {}
+	};
+
+	static_assert(sizeof(mat4a) == sizeof(mat4) && alignof(mat4a) == 16, "mat4a must be 64 bytes, 16-byte aligned");
+	static_assert(std::is_trivially_copyable<mat4a>::value, "mat4a must be trivially copyable");
+
 	//
 	//  --- Non-class mat4 Methods ---
 	//
@@ -661,12 +796,154 @@ namespace Angel
 			A[3][0] * B[3][0], A[3][1] * B[3][1], A[3][2] * B[3][2], A[3][3] * B[3][3]);
 	}
 
-	inline mat4 transpose(const mat4& A)
+	inline constexpr mat4 transpose(const mat4& A)
 	{
-		return mat4(A[0][0], A[1][0], A[2][0], A[3][0],
-			A[0][1], A[1][1], A[2][1], A[3][1],
-			A[0][2], A[1][2], A[2][2], A[3][2],
-			A[0][3], A[1][3], A[2][3], A[3][3]);
+		// 构造函数按列传入元素，A 的第 i 行即结果的第 i 列
+		return mat4(A[0].x, A[0].y, A[0].z, A[0].w,
+			A[1].x, A[1].y, A[1].z, A[1].w,
+			A[2].x, A[2].y, A[2].z, A[2].w,
+			A[3].x, A[3].y, A[3].z, A[3].w);
+	}
+
+	// 通用 4x4 矩阵求逆(余子式展开)，矩阵不可逆时返回恒等矩阵
+	inline mat4 inverse(const mat4& A)
+	{
+		const GLfloat* m = A;
+		GLfloat inv[16];
+
+		inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15]
+			+ m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+		inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15]
+			- m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+		inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15]
+			+ m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+		inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14]
+			- m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+		inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15]
+			- m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+		inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15]
+			+ m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+		inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15]
+			- m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+		inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14]
+			+ m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+		inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15]
+			+ m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+		inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15]
+			- m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+		inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15]
+			+ m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+		inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14]
+			- m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+		inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11]
+			- m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+		inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11]
+			+ m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+		inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11]
+			- m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+		inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10]
+			+ m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+		GLfloat det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+		if (std::fabs(det) < DivideByZeroTolerance)
+		{
+#ifdef DEBUG
+			std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
+				<< "Singular matrix" << std::endl;
+#endif // DEBUG
+			return mat4();
+		}
+
+		GLfloat r = GLfloat(1.0) / det;
+		return mat4(inv[0] * r, inv[4] * r, inv[8] * r, inv[12] * r,
+			inv[1] * r, inv[5] * r, inv[9] * r, inv[13] * r,
+			inv[2] * r, inv[6] * r, inv[10] * r, inv[14] * r,
+			inv[3] * r, inv[7] * r, inv[11] * r, inv[15] * r);
+	}
+
+	// 仿射矩阵快速求逆：A = [R*S t; 0 1]，其中 R 为旋转，S 为(非均匀)缩放
+	// 即左上 3x3 部分的各列相互正交(不含切变)，相机矩阵和模视矩阵都满足此条件
+	// 逆矩阵为 [S^-1 * R^T, -S^-1 * R^T * t]：转置 3x3 部分，
+	// 再将每行除以对应列长度的平方，最后修正平移部分
+	inline mat4 affineInverse(const mat4& A)
+	{
+		const GLfloat* m = A;
+		mat4 c;
+		GLfloat* out = c;
+
+#if defined(ANGEL_SIMD_SSE)
+		__m128 r0 = _mm_loadu_ps(m);
+		__m128 r1 = _mm_loadu_ps(m + 4);
+		__m128 r2 = _mm_loadu_ps(m + 8);
+
+		// sq 的第 i 个分量为第 i 列长度的平方，第 4 个分量置 1 以免除 0，求倒数后再置 0
+		__m128 xyz = _mm_setr_ps(1.0f, 1.0f, 1.0f, 0.0f);
+		__m128 sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, r0), _mm_mul_ps(r1, r1)), _mm_mul_ps(r2, r2));
+		sq = _mm_add_ps(_mm_mul_ps(sq, xyz), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+		__m128 sinv = _mm_mul_ps(_mm_div_ps(_mm_set1_ps(1.0f), sq), xyz);
+
+		// 结果的前 3 列，即原矩阵的前 3 行逐分量乘以 sinv
+		__m128 c0 = _mm_mul_ps(r0, sinv);
+		__m128 c1 = _mm_mul_ps(r1, sinv);
+		__m128 c2 = _mm_mul_ps(r2, sinv);
+
+		// 结果的第 4 列：-(c0 * tx + c1 * ty + c2 * tz) + (0, 0, 0, 1)
+		__m128 c3 = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(c0, _mm_shuffle_ps(r0, r0, 0xFF)),
+			_mm_mul_ps(c1, _mm_shuffle_ps(r1, r1, 0xFF))),
+			_mm_mul_ps(c2, _mm_shuffle_ps(r2, r2, 0xFF)));
+		c3 = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), c3);
+
+		// 按列求得，转置后按行写出
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_storeu_ps(out, c0);
+		_mm_storeu_ps(out + 4, c1);
+		_mm_storeu_ps(out + 8, c2);
+		_mm_storeu_ps(out + 12, c3);
+#elif defined(ANGEL_SIMD_NEON)
+		float32x4_t r0 = vld1q_f32(m);
+		float32x4_t r1 = vld1q_f32(m + 4);
+		float32x4_t r2 = vld1q_f32(m + 8);
+
+		float32x4_t sq = vmlaq_f32(vmlaq_f32(vmulq_f32(r0, r0), r1, r1), r2, r2);
+		sq = vsetq_lane_f32(1.0f, sq, 3);
+		// 倒数估计加两次牛顿迭代，精度与除法相当
+		float32x4_t sinv = vrecpeq_f32(sq);
+		sinv = vmulq_f32(vrecpsq_f32(sq, sinv), sinv);
+		sinv = vmulq_f32(vrecpsq_f32(sq, sinv), sinv);
+		sinv = vsetq_lane_f32(0.0f, sinv, 3);
+
+		float32x4x4_t cols;
+		cols.val[0] = vmulq_f32(r0, sinv);
+		cols.val[1] = vmulq_f32(r1, sinv);
+		cols.val[2] = vmulq_f32(r2, sinv);
+
+		float32x4_t t = vmulq_n_f32(cols.val[0], vgetq_lane_f32(r0, 3));
+		t = vmlaq_n_f32(t, cols.val[1], vgetq_lane_f32(r1, 3));
+		t = vmlaq_n_f32(t, cols.val[2], vgetq_lane_f32(r2, 3));
+		cols.val[3] = vsetq_lane_f32(1.0f, vnegq_f32(t), 3);
+
+		// vst4q 交错写出，恰好完成转置
+		vst4q_f32(out, cols);
+#else
+		GLfloat sinv[3];
+		for (int i = 0; i < 3; i++)
+		{
+			sinv[i] = GLfloat(1.0) / (m[i] * m[i] + m[4 + i] * m[4 + i] + m[8 + i] * m[8 + i]);
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			GLfloat* row = out + 4 * i;
+			row[0] = m[i] * sinv[i];
+			row[1] = m[4 + i] * sinv[i];
+			row[2] = m[8 + i] * sinv[i];
+			row[3] = -(row[0] * m[3] + row[1] * m[7] + row[2] * m[11]);
+		}
+
+		out[12] = 0.0f;  out[13] = 0.0f;  out[14] = 0.0f;  out[15] = 1.0f;
+#endif
+		return c;
 	}
 
 	//////////////////////////////////////////////////////////////////////////////
@@ -695,38 +972,93 @@ namespace Angel
 	//
 	//  Rotation matrix generators
 	//
+	//    RotateX/Y/Z 为 constexpr，常量角度(如 RotateX(90.0))在编译期求值
+	//
 
-	inline mat4 RotateX(const GLfloat theta)
+	namespace detail
+	{
+		// 编译期可用的正弦/余弦：先把弧度规约到 [-PI, PI]，再用双精度泰勒级数(展开到 23 次)求值，
+		// 误差小于 1e-10，转换为 GLfloat 后与 std::sin/std::cos 的结果一致
+		inline constexpr double constexprReduce(double x)
+		{
+			const double twoPi = 2.0 * M_PI;
+			long long k = (long long)(x / twoPi + (x >= 0.0 ? 0.5 : -0.5));
+			return x - twoPi * k;
+		}
+
+		inline constexpr double constexprSin(double x)
+		{
+			x = constexprReduce(x);
+			double x2 = x * x;
+			double s = 1.0 / 25852016738884976640000.0;   // 1/23!
+			s = 1.0 / 51090942171709440000.0 - x2 * s;     // 1/21!
+			s = 1.0 / 121645100408832000.0 - x2 * s;       // 1/19!
+			s = 1.0 / 355687428096000.0 - x2 * s;          // 1/17!
+			s = 1.0 / 1307674368000.0 - x2 * s;            // 1/15!
+			s = 1.0 / 6227020800.0 - x2 * s;               // 1/13!
+			s = 1.0 / 39916800.0 - x2 * s;                 // 1/11!
+			s = 1.0 / 362880.0 - x2 * s;                   // 1/9!
+			s = 1.0 / 5040.0 - x2 * s;                     // 1/7!
+			s = 1.0 / 120.0 - x2 * s;                      // 1/5!
+			s = 1.0 / 6.0 - x2 * s;                        // 1/3!
+			s = 1.0 - x2 * s;
+			return x * s;
+		}
+
+		inline constexpr double constexprCos(double x)
+		{
+			x = constexprReduce(x);
+			double x2 = x * x;
+			double c = 1.0 / 620448401733239439360000.0;  // 1/24!
+			c = 1.0 / 1124000727777607680000.0 - x2 * c;  // 1/22!
+			c = 1.0 / 2432902008176640000.0 - x2 * c;     // 1/20!
+			c = 1.0 / 6402373705728000.0 - x2 * c;        // 1/18!
+			c = 1.0 / 20922789888000.0 - x2 * c;          // 1/16!
+			c = 1.0 / 87178291200.0 - x2 * c;             // 1/14!
+			c = 1.0 / 479001600.0 - x2 * c;               // 1/12!
+			c = 1.0 / 3628800.0 - x2 * c;                 // 1/10!
+			c = 1.0 / 40320.0 - x2 * c;                   // 1/8!
+			c = 1.0 / 720.0 - x2 * c;                     // 1/6!
+			c = 1.0 / 24.0 - x2 * c;                      // 1/4!
+			c = 1.0 / 2.0 - x2 * c;                       // 1/2!
+			return 1.0 - x2 * c;
+		}
+	}
+
+	inline constexpr mat4 RotateX(const GLfloat theta)
 	{
 		GLfloat angle = DegreesToRadians * theta;
+		GLfloat c = GLfloat(detail::constexprCos(angle));
+		GLfloat s = GLfloat(detail::constexprSin(angle));
 
-		mat4 c;
-		c[2][2] = c[1][1] = cos(angle);
-		c[2][1] = sin(angle);
-		c[1][2] = -c[2][1];
-		return c;
+		return mat4(1.0, 0.0, 0.0, 0.0,
+			0.0, c, s, 0.0,
+			0.0, -s, c, 0.0,
+			0.0, 0.0, 0.0, 1.0);
 	}
 
-	inline mat4 RotateY(const GLfloat theta)
+	inline constexpr mat4 RotateY(const GLfloat theta)
 	{
 		GLfloat angle = DegreesToRadians * theta;
+		GLfloat c = GLfloat(detail::constexprCos(angle));
+		GLfloat s = GLfloat(detail::constexprSin(angle));
 
-		mat4 c;
-		c[2][2] = c[0][0] = cos(angle);
-		c[0][2] = sin(angle);
-		c[2][0] = -c[0][2];
-		return c;
+		return mat4(c, 0.0, -s, 0.0,
+			0.0, 1.0, 0.0, 0.0,
+			s, 0.0, c, 0.0,
+			0.0, 0.0, 0.0, 1.0);
 	}
 
-	inline mat4 RotateZ(const GLfloat theta)
+	inline constexpr mat4 RotateZ(const GLfloat theta)
 	{
 		GLfloat angle = DegreesToRadians * theta;
+		GLfloat c = GLfloat(detail::constexprCos(angle));
+		GLfloat s = GLfloat(detail::constexprSin(angle));
 
-		mat4 c;
-		c[0][0] = c[1][1] = cos(angle);
-		c[1][0] = sin(angle);
-		c[0][1] = -c[1][0];
-		return c;
+		return mat4(c, s, 0.0, 0.0,
+			-s, c, 0.0, 0.0,
+			0.0, 0.0, 1.0, 0.0,
+			0.0, 0.0, 0.0, 1.0);
 	}
 
 	//----------------------------------------------------------------------------
@@ -734,21 +1066,20 @@ namespace Angel
 	//  Translation matrix generators
 	//
 
-	inline mat4 Translate(const GLfloat x, const GLfloat y, const GLfloat z)
+	inline constexpr mat4 Translate(const GLfloat x, const GLfloat y, const GLfloat z)
 	{
-		mat4 c;
-		c[0][3] = x;
-		c[1][3] = y;
-		c[2][3] = z;
-		return c;
+		return mat4(1.0, 0.0, 0.0, 0.0,
+			0.0, 1.0, 0.0, 0.0,
+			0.0, 0.0, 1.0, 0.0,
+			x, y, z, 1.0);
 	}
 
-	inline mat4 Translate(const vec3& v)
+	inline constexpr mat4 Translate(const vec3& v)
 	{
 		return Translate(v.x, v.y, v.z);
 	}
 
-	inline mat4 Translate(const vec4& v)
+	inline constexpr mat4 Translate(const vec4& v)
 	{
 		return Translate(v.x, v.y, v.z);
 	}
@@ -758,16 +1089,15 @@ namespace Angel
 	//  Scale matrix generators
 	//
 
-	inline mat4 Scale(const GLfloat x, const GLfloat y, const GLfloat z)
+	inline constexpr mat4 Scale(const GLfloat x, const GLfloat y, const GLfloat z)
 	{
-		mat4 c;
-		c[0][0] = x;
-		c[1][1] = y;
-		c[2][2] = z;
-		return c;
+		return mat4(x, 0.0, 0.0, 0.0,
+			0.0, y, 0.0, 0.0,
+			0.0, 0.0, z, 0.0,
+			0.0, 0.0, 0.0, 1.0);
 	}
 
-	inline mat4 Scale(const vec3& v)
+	inline constexpr mat4 Scale(const vec3& v)
 	{
 		return Scale(v.x, v.y, v.z);
 	}
@@ -783,41 +1113,32 @@ namespace Angel
 
 
 
-	inline mat4 Ortho(const GLfloat left, const GLfloat right,
+	inline constexpr mat4 Ortho(const GLfloat left, const GLfloat right,
 		const GLfloat bottom, const GLfloat top,
 		const GLfloat zNear, const GLfloat zFar)
 	{
-		mat4 c;
-		c[0][0] = 2.0 / (right - left);
-		c[1][1] = 2.0 / (top - bottom);
-		c[2][2] = 2.0 / (zNear - zFar);
-		c[3][3] = 1.0;
-		c[0][3] = -(right + left) / (right - left);
-		c[1][3] = -(top + bottom) / (top - bottom);
-		c[2][3] = -(zFar + zNear) / (zFar - zNear);
-		return c;
+		return mat4(2.0 / (right - left), 0.0, 0.0, 0.0,
+			0.0, 2.0 / (top - bottom), 0.0, 0.0,
+			0.0, 0.0, 2.0 / (zNear - zFar), 0.0,
+			-(right + left) / (right - left), -(top + bottom) / (top - bottom),
+			-(zFar + zNear) / (zFar - zNear), 1.0);
 	}
 
-	inline mat4 Ortho2D(const GLfloat left, const GLfloat right,
+	inline constexpr mat4 Ortho2D(const GLfloat left, const GLfloat right,
 		const GLfloat bottom, const GLfloat top)
 	{
 		return Ortho(left, right, bottom, top, -1.0, 1.0);
 	}
 
-	inline mat4 Frustum(const GLfloat left, const GLfloat right,
+	inline constexpr mat4 Frustum(const GLfloat left, const GLfloat right,
 		const GLfloat bottom, const GLfloat top,
 		const GLfloat zNear, const GLfloat zFar)
 	{
-		mat4 c;
-		c[0][0] = 2.0 * zNear / (right - left);
-		c[0][2] = (right + left) / (right - left);
-		c[1][1] = 2.0 * zNear / (top - bottom);
-		c[1][2] = (top + bottom) / (top - bottom);
-		c[2][2] = -(zFar + zNear) / (zFar - zNear);
-		c[2][3] = -2.0 * zFar * zNear / (zFar - zNear);
-		c[3][2] = -1.0;
-		c[3][3] = 0.0;
-		return c;
+		return mat4(2.0 * zNear / (right - left), 0.0, 0.0, 0.0,
+			0.0, 2.0 * zNear / (top - bottom), 0.0, 0.0,
+			(right + left) / (right - left), (top + bottom) / (top - bottom),
+			-(zFar + zNear) / (zFar - zNear), -1.0,
+			0.0, 0.0, -2.0 * zFar * zNear / (zFar - zNear), 0.0);
 	}
 
 	inline mat4 Perspective(const GLfloat fovy, const GLfloat aspect,
@@ -874,6 +1195,646 @@ namespace Angel
 		return d;
 	}
 
+	//----------------------------------------------------------------------------
+	//
+	//  affine3x4 - 3x4 仿射矩阵
+	//
+	//    模视矩阵都是仿射矩阵，最后一行恒为 (0, 0, 0, 1)，只保存前三行(行主序 12 个 GLfloat)。
+	//    相乘只需 36 次乘法(mat4 为 64 次)；上传 12 个 float，并且不需要驱动转置：
+	//      glUniform4fv(loc, 3, a);	// shader 中声明为 uniform vec4 ModelView[3]
+	//    shader 中按行点乘即可变换点(w = 1)或方向(w = 0)：
+	//      vec3(dot(ModelView[0], v), dot(ModelView[1], v), dot(ModelView[2], v))
+	//
+
+	namespace detail
+	{
+		// c = a * b，a 与 c 为 rows 行(3 或 4)，b 为 3x4 仿射矩阵(省略的第四行为 (0, 0, 0, 1))
+		// 全部行算完后才写出结果，因此输出可以与任一输入重叠
+		inline void affineMul(const GLfloat* a, int rows, const GLfloat* b, GLfloat* c)
+		{
+#if defined(ANGEL_SIMD_AVX)
+			// 与 mat4Mul 相同，一次处理两行：前两行用 256 位，第三行用低 128 位(rows 为 4 时也用 256 位)
+			__m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b));
+			__m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 4));
+			__m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 8));
+			__m256 wMask = _mm256_castsi256_ps(_mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1));
+
+			__m256 a01 = _mm256_loadu_ps(a);
+			__m256 c01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x00), b0);
+			c01 = _mm256_add_ps(c01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x55), b1));
+			c01 = _mm256_add_ps(c01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xAA), b2));
+			c01 = _mm256_add_ps(c01, _mm256_and_ps(a01, wMask));
+
+			if (rows == 4)
+			{
+				__m256 a23 = _mm256_loadu_ps(a + 8);
+				__m256 c23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x00), b0);
+				c23 = _mm256_add_ps(c23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x55), b1));
+				c23 = _mm256_add_ps(c23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xAA), b2));
+				c23 = _mm256_add_ps(c23, _mm256_and_ps(a23, wMask));
+				_mm256_storeu_ps(c, c01);
+				_mm256_storeu_ps(c + 8, c23);
+			}
+			else
+			{
+				__m128 a2 = _mm_loadu_ps(a + 8);
+				__m128 c2 = _mm_mul_ps(_mm_shuffle_ps(a2, a2, 0x00), _mm256_castps256_ps128(b0));
+				c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_shuffle_ps(a2, a2, 0x55), _mm256_castps256_ps128(b1)));
+				c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_shuffle_ps(a2, a2, 0xAA), _mm256_castps256_ps128(b2)));
+				c2 = _mm_add_ps(c2, _mm_and_ps(a2, _mm256_castps256_ps128(wMask)));
+				_mm256_storeu_ps(c, c01);
+				_mm_storeu_ps(c + 8, c2);
+			}
+#elif defined(ANGEL_SIMD_SSE)
+			__m128 b0 = _mm_loadu_ps(b);
+			__m128 b1 = _mm_loadu_ps(b + 4);
+			__m128 b2 = _mm_loadu_ps(b + 8);
+			// a[i][3] * (0, 0, 0, 1) 只需把 a 的第 i 行与掩码相与
+			__m128 wMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+			__m128 r[4];
+
+			for (int i = 0; i < rows; ++i)
+			{
+				__m128 ai = _mm_loadu_ps(a + 4 * i);
+				__m128 ri = _mm_mul_ps(_mm_shuffle_ps(ai, ai, 0x00), b0);
+				ri = _mm_add_ps(ri, _mm_mul_ps(_mm_shuffle_ps(ai, ai, 0x55), b1));
+				ri = _mm_add_ps(ri, _mm_mul_ps(_mm_shuffle_ps(ai, ai, 0xAA), b2));
+				r[i] = _mm_add_ps(ri, _mm_and_ps(ai, wMask));
+			}
+
+			for (int i = 0; i < rows; ++i)
+			{
+				_mm_storeu_ps(c + 4 * i, r[i]);
+			}
+#elif defined(ANGEL_SIMD_NEON)
+			float32x4_t b0 = vld1q_f32(b);
+			float32x4_t b1 = vld1q_f32(b + 4);
+			float32x4_t b2 = vld1q_f32(b + 8);
+			const uint32_t maskBits[4] = { 0u, 0u, 0u, 0xFFFFFFFFu };
+			uint32x4_t wMask = vld1q_u32(maskBits);
+			float32x4_t r[4];
+
+			for (int i = 0; i < rows; ++i)
+			{
+				float32x4_t ai = vld1q_f32(a + 4 * i);
+				float32x4_t ri = vmulq_n_f32(b0, vgetq_lane_f32(ai, 0));
+				ri = vmlaq_n_f32(ri, b1, vgetq_lane_f32(ai, 1));
+				ri = vmlaq_n_f32(ri, b2, vgetq_lane_f32(ai, 2));
+				r[i] = vaddq_f32(ri, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(ai), wMask)));
+			}
+
+			for (int i = 0; i < rows; ++i)
+			{
+				vst1q_f32(c + 4 * i, r[i]);
+			}
+#else
+			GLfloat r[16];
+
+			for (int i = 0; i < rows; ++i)
+			{
+				const GLfloat* ai = a + 4 * i;
+				for (int j = 0; j < 4; ++j)
+				{
+					r[4 * i + j] = ai[0] * b[j] + ai[1] * b[4 + j] + ai[2] * b[8 + j];
+				}
+				r[4 * i + 3] += ai[3];
+			}
+
+			for (int i = 0; i < 4 * rows; ++i)
+			{
+				c[i] = r[i];
+			}
+#endif
+		}
+	}  // namespace detail
+
+	class affine3x4
+	{
+
+		vec4  _r[3];	// 前三行
+
+	public:
+		//
+		//  --- Constructors and Destructors ---
+		//
+
+		constexpr affine3x4() :  // 恒等变换
+			_r{ vec4(1.0, 0.0, 0.0, 0.0), vec4(0.0, 1.0, 0.0, 0.0), vec4(0.0, 0.0, 1.0, 0.0) } {}
+
+		constexpr affine3x4(const vec4& r0, const vec4& r1, const vec4& r2) :
+			_r{ r0, r1, r2 } {}
+
+		// m 必须是仿射矩阵，最后一行被忽略
+		explicit constexpr affine3x4(const mat4& m) :
+			_r{ m[0], m[1], m[2] } {}
+
+		//
+		//  --- Indexing Operator ---
+		//
+
+		constexpr vec4& operator [] (int i) { return _r[i]; }
+		constexpr const vec4& operator [] (int i) const { return _r[i]; }
+
+		//
+		//  --- Arithematic Operators ---
+		//
+
+		affine3x4 operator * (const affine3x4& m) const
+		{
+			affine3x4 c;
+			detail::affineMul(*this, 3, m, c);
+			return c;
+		}
+
+		affine3x4& operator *= (const affine3x4& m)
+		{
+			detail::affineMul(*this, 3, m, *this);
+			return *this;
+		}
+
+		// 变换一个点(w = 1)或方向(w = 0)：12 次乘法
+		constexpr vec4 operator * (const vec4& v) const
+		{
+			return vec4(dot(_r[0], v), dot(_r[1], v), dot(_r[2], v), v.w);
+		}
+
+		// 投影矩阵左乘，得到完整的 4x4 矩阵(48 次乘法)
+		friend mat4 operator * (const mat4& p, const affine3x4& a)
+		{
+			mat4 c;
+			detail::affineMul(p, 4, a, c);
+			return c;
+		}
+
+		//
+		//  --- Conversion Operators ---
+		//
+
+		// 补上最后一行 (0, 0, 0, 1)
+		constexpr operator mat4 () const
+		{
+			return mat4(_r[0], _r[1], _r[2], vec4(0.0, 0.0, 0.0, 1.0));
+		}
+
+		operator const GLfloat* () const
+		{
+			return static_cast<const GLfloat*>(&_r[0].x);
+		}
+
+		operator GLfloat* ()
+		{
+			return static_cast<GLfloat*>(&_r[0].x);
+		}
+	};
+
+	static_assert(sizeof(affine3x4) == 12 * sizeof(GLfloat), "affine3x4 must be 12 tightly packed GLfloats");
+	static_assert(std::is_trivially_copyable<affine3x4>::value, "affine3x4 must be trivially copyable");
+
+	// 仿射矩阵求逆：A = [M t]，A^-1 = [M^-1, -M^-1 * t]
+	// 设 M 的三行为 a、b、c，则 M^-1 的三列为 b×c、c×a、a×b 除以 det = a·(b×c)
+	// 与 affineInverse(mat4) 不同，M 可以含切变；矩阵不可逆时返回恒等变换
+	inline affine3x4 inverse(const affine3x4& A)
+	{
+		vec3 a(A[0].x, A[0].y, A[0].z);
+		vec3 b(A[1].x, A[1].y, A[1].z);
+		vec3 c(A[2].x, A[2].y, A[2].z);
+		vec3 bc = cross(b, c);
+		vec3 ca = cross(c, a);
+		vec3 ab = cross(a, b);
+
+		GLfloat det = dot(a, bc);
+		if (std::fabs(det) < DivideByZeroTolerance)
+		{
+#ifdef DEBUG
+			std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
+				<< "Singular matrix" << std::endl;
+#endif // DEBUG
+			return affine3x4();
+		}
+		GLfloat r = GLfloat(1.0) / det;
+
+		vec3 r0 = vec3(bc.x, ca.x, ab.x) * r;
+		vec3 r1 = vec3(bc.y, ca.y, ab.y) * r;
+		vec3 r2 = vec3(bc.z, ca.z, ab.z) * r;
+		vec3 t(A[0].w, A[1].w, A[2].w);
+
+		return affine3x4(vec4(r0, -dot(r0, t)), vec4(r1, -dot(r1, t)), vec4(r2, -dot(r2, t)));
+	}
+
+	// 法向矩阵：左上 3x3 部分的逆矩阵的转置，即三行为 b×c、c×a、a×b 除以 det
+	inline mat3 Normal(const affine3x4& A)
+	{
+		vec3 a(A[0].x, A[0].y, A[0].z);
+		vec3 b(A[1].x, A[1].y, A[1].z);
+		vec3 c(A[2].x, A[2].y, A[2].z);
+		vec3 bc = cross(b, c);
+
+		GLfloat r = GLfloat(1.0) / dot(a, bc);
+		return mat3(bc * r, cross(c, a) * r, cross(a, b) * r);
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  TransformChain - 延迟组合的仿射变换
+	//
+	//    只保存 3x4 仿射矩阵(mat4 的前三行，省略的第四行恒为 (0, 0, 0, 1))。
+	//    translate/scale/rotateX/rotateY/rotateZ 按解析式直接更新这 12 个数，
+	//    组合顺序与 mv *= Translate(...) 相同(右乘)，但不生成 4x4 临时矩阵：
+	//      translate、scale 9 次乘法，rotateX/Y/Z 12 次，*= mat4(仿射)36 次，
+	//    而 mv *= Translate(...) 需要构造一个 mat4 再做 64 次乘法。
+	//    只有左乘投影矩阵(proj * chain)时才提升为完整的 mat4(48 次乘法)。
+	//    对象只有 48 字节且可平凡复制，保存/恢复状态直接复制即可，不必使用 MatrixStack。
+	//    组合结果可转为 affine3x4，按三个 vec4 上传。
+	//
+
+	class TransformChain
+	{
+
+		vec4  _r[3];	// 前三行
+
+	public:
+		//
+		//  --- Constructors and Destructors ---
+		//
+
+		constexpr TransformChain() :  // 恒等变换
+			_r{ vec4(1.0, 0.0, 0.0, 0.0), vec4(0.0, 1.0, 0.0, 0.0), vec4(0.0, 0.0, 1.0, 0.0) } {}
+
+		// m 必须是仿射矩阵，最后一行被忽略
+		explicit constexpr TransformChain(const mat4& m) :
+			_r{ m[0], m[1], m[2] } {}
+
+		explicit constexpr TransformChain(const affine3x4& a) :
+			_r{ a[0], a[1], a[2] } {}
+
+		//
+		//  --- Indexing Operator ---
+		//
+
+		constexpr const vec4& operator [] (int i) const { return _r[i]; }
+
+		//
+		//  --- Transform steps(右乘) ---
+		//
+
+		TransformChain& translate(const GLfloat x, const GLfloat y, const GLfloat z)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				_r[i].w += _r[i].x * x + _r[i].y * y + _r[i].z * z;
+			}
+			return *this;
+		}
+
+		TransformChain& translate(const vec3& v)
+		{
+			return translate(v.x, v.y, v.z);
+		}
+
+		TransformChain& scale(const GLfloat x, const GLfloat y, const GLfloat z)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				_r[i].x *= x;  _r[i].y *= y;  _r[i].z *= z;
+			}
+			return *this;
+		}
+
+		TransformChain& scale(const GLfloat s)
+		{
+			return scale(s, s, s);
+		}
+
+		// 绕x轴旋转 theta 度：第1、2列做平面旋转
+		TransformChain& rotateX(const GLfloat theta)
+		{
+			GLfloat s, c;
+			SinCos(DegreesToRadians * theta, s, c);
+			for (int i = 0; i < 3; ++i)
+			{
+				GLfloat y = _r[i].y, z = _r[i].z;
+				_r[i].y = y * c + z * s;
+				_r[i].z = z * c - y * s;
+			}
+			return *this;
+		}
+
+		// 绕y轴旋转 theta 度：第0、2列做平面旋转
+		TransformChain& rotateY(const GLfloat theta)
+		{
+			GLfloat s, c;
+			SinCos(DegreesToRadians * theta, s, c);
+			for (int i = 0; i < 3; ++i)
+			{
+				GLfloat x = _r[i].x, z = _r[i].z;
+				_r[i].x = x * c - z * s;
+				_r[i].z = z * c + x * s;
+			}
+			return *this;
+		}
+
+		// 绕z轴旋转 theta 度：第0、1列做平面旋转
+		TransformChain& rotateZ(const GLfloat theta)
+		{
+			GLfloat s, c;
+			SinCos(DegreesToRadians * theta, s, c);
+			for (int i = 0; i < 3; ++i)
+			{
+				GLfloat x = _r[i].x, y = _r[i].y;
+				_r[i].x = x * c + y * s;
+				_r[i].y = y * c - x * s;
+			}
+			return *this;
+		}
+
+		// 右乘一个仿射矩阵(例如 Rotate(q)、Transform(dq))，m 的最后一行被忽略
+		TransformChain& operator *= (const mat4& m)
+		{
+			detail::affineMul(&_r[0].x, 3, m, &_r[0].x);
+			return *this;
+		}
+
+		TransformChain& operator *= (const affine3x4& m)
+		{
+			detail::affineMul(&_r[0].x, 3, m, &_r[0].x);
+			return *this;
+		}
+
+		TransformChain& operator *= (const TransformChain& m)
+		{
+			detail::affineMul(&_r[0].x, 3, &m._r[0].x, &_r[0].x);
+			return *this;
+		}
+
+		TransformChain operator * (const TransformChain& m) const
+		{
+			TransformChain a(*this);
+			return a *= m;
+		}
+
+		// 变换一个点(w = 1)或方向(w = 0)：12 次乘法
+		vec4 operator * (const vec4& v) const
+		{
+			return vec4(dot(_r[0], v), dot(_r[1], v), dot(_r[2], v), v.w);
+		}
+
+		// 得到 3x4 仿射矩阵，可用 glUniform4fv(loc, 3, ...) 上传
+		constexpr operator affine3x4 () const
+		{
+			return affine3x4(_r[0], _r[1], _r[2]);
+		}
+
+		// 提升为 mat4，例如上传给只接受 4x4 矩阵的 uniform
+		explicit constexpr operator mat4 () const
+		{
+			return mat4(_r[0], _r[1], _r[2], vec4(0.0, 0.0, 0.0, 1.0));
+		}
+
+		// 投影矩阵左乘：唯一需要完整 4x4 结果的地方
+		friend mat4 operator * (const mat4& p, const TransformChain& a)
+		{
+			mat4 c;
+			detail::affineMul(p, 4, &a._r[0].x, c);
+			return c;
+		}
+	};
+
+	static_assert(sizeof(TransformChain) == 12 * sizeof(GLfloat), "TransformChain must be 12 tightly packed GLfloats");
+	static_assert(std::is_trivially_copyable<TransformChain>::value, "TransformChain must be trivially copyable");
+
+	//----------------------------------------------------------------------------
+	//
+	//  Batch transforms
+	//
+	//    用同一个矩阵变换一批点(w = 1)或方向(w = 0)，支持 AoS(vec3 数组)
+	//    和 SoA(x/y/z 三个 float 数组)两种输入。矩阵的最后一行视为 (0, 0, 0, 1)，
+	//    即只处理仿射变换，不做透视除法。输出可以与输入是同一数组。
+	//    元素个数达到 parallelThreshold 时按 CPU 核数分段并行处理。
+	//
+
+	// 默认的并行阈值(元素个数)
+	const size_t BatchParallelThreshold = 1 << 16;
+
+	namespace detail
+	{
+		// ParallelFor 使用的线程数，0 表示按 CPU 核数
+		inline unsigned& parallelThreads()
+		{
+			static unsigned threads = 0;
+			return threads;
+		}
+	}
+
+	// 设置 ParallelFor 使用的线程数(含调用线程)，0 表示按 CPU 核数；用于测试并行的伸缩性
+	inline void SetParallelThreads(unsigned threads)
+	{
+		detail::parallelThreads() = threads;
+	}
+
+	inline unsigned ParallelThreads()
+	{
+		unsigned threads = detail::parallelThreads();
+		return threads ? threads : std::thread::hardware_concurrency();
+	}
+
+	// 把 [0, count) 分成 ParallelThreads() 段(除最后一段外长度为 4 的倍数)，多线程执行 func(begin, end)
+	// count 小于 threshold 时直接在当前线程执行
+	template <typename Func>
+	inline void ParallelFor(size_t count, size_t threshold, Func func)
+	{
+		size_t numThreads = ParallelThreads();
+		if (count < threshold || numThreads <= 1)
+		{
+			func(size_t(0), count);
+			return;
+		}
+
+		size_t chunk = (count + numThreads - 1) / numThreads;
+		chunk = (chunk + 3) & ~size_t(3);
+
+		std::vector<std::thread> workers;
+		for (size_t begin = chunk; begin < count; begin += chunk)
+		{
+			size_t end = (begin + chunk < count) ? begin + chunk : count;
+			workers.push_back(std::thread(func, begin, end));
+		}
+
+		func(size_t(0), chunk < count ? chunk : count); // 当前线程处理第一段
+
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			workers[i].join();
+		}
+	}
+
+	namespace detail
+	{
+		// SoA 数据的 [begin, end) 区间：out = m * (x, y, z, w)
+		inline void transformSoA(const GLfloat* m, GLfloat w,
+			const GLfloat* xs, const GLfloat* ys, const GLfloat* zs,
+			GLfloat* outX, GLfloat* outY, GLfloat* outZ, size_t begin, size_t end)
+		{
+			size_t i = begin;
+#if defined(ANGEL_SIMD_SSE)
+			__m128 m00 = _mm_set1_ps(m[0]), m01 = _mm_set1_ps(m[1]), m02 = _mm_set1_ps(m[2]), m03 = _mm_set1_ps(m[3] * w);
+			__m128 m10 = _mm_set1_ps(m[4]), m11 = _mm_set1_ps(m[5]), m12 = _mm_set1_ps(m[6]), m13 = _mm_set1_ps(m[7] * w);
+			__m128 m20 = _mm_set1_ps(m[8]), m21 = _mm_set1_ps(m[9]), m22 = _mm_set1_ps(m[10]), m23 = _mm_set1_ps(m[11] * w);
+
+			for (; i + 4 <= end; i += 4)
+			{
+				__m128 x = _mm_loadu_ps(xs + i);
+				__m128 y = _mm_loadu_ps(ys + i);
+				__m128 z = _mm_loadu_ps(zs + i);
+
+				__m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m01, y)), _mm_add_ps(_mm_mul_ps(m02, z), m03));
+				__m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, x), _mm_mul_ps(m11, y)), _mm_add_ps(_mm_mul_ps(m12, z), m13));
+				__m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m20, x), _mm_mul_ps(m21, y)), _mm_add_ps(_mm_mul_ps(m22, z), m23));
+
+				_mm_storeu_ps(outX + i, rx);
+				_mm_storeu_ps(outY + i, ry);
+				_mm_storeu_ps(outZ + i, rz);
+			}
+#elif defined(ANGEL_SIMD_NEON)
+			float32x4_t m03 = vdupq_n_f32(m[3] * w);
+			float32x4_t m13 = vdupq_n_f32(m[7] * w);
+			float32x4_t m23 = vdupq_n_f32(m[11] * w);
+
+			for (; i + 4 <= end; i += 4)
+			{
+				float32x4_t x = vld1q_f32(xs + i);
+				float32x4_t y = vld1q_f32(ys + i);
+				float32x4_t z = vld1q_f32(zs + i);
+
+				float32x4_t rx = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(m03, x, m[0]), y, m[1]), z, m[2]);
+				float32x4_t ry = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(m13, x, m[4]), y, m[5]), z, m[6]);
+				float32x4_t rz = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(m23, x, m[8]), y, m[9]), z, m[10]);
+
+				vst1q_f32(outX + i, rx);
+				vst1q_f32(outY + i, ry);
+				vst1q_f32(outZ + i, rz);
+			}
+#endif
+			// 标量实现，同时处理 SIMD 剩余的尾部元素
+			for (; i < end; i++)
+			{
+				GLfloat x = xs[i], y = ys[i], z = zs[i];
+				outX[i] = m[0] * x + m[1] * y + m[2] * z + m[3] * w;
+				outY[i] = m[4] * x + m[5] * y + m[6] * z + m[7] * w;
+				outZ[i] = m[8] * x + m[9] * y + m[10] * z + m[11] * w;
+			}
+		}
+
+		// AoS 数据的 [begin, end) 区间：out = m * (in, w)
+		// SIMD 实现每次读入 4 个 vec3(12 个 float)，在寄存器中转成 SoA 计算后再写回
+		inline void transformAoS(const GLfloat* m, GLfloat w,
+			const vec3* in, vec3* out, size_t begin, size_t end)
+		{
+			size_t i = begin;
+#if defined(ANGEL_SIMD_SSE)
+			__m128 m00 = _mm_set1_ps(m[0]), m01 = _mm_set1_ps(m[1]), m02 = _mm_set1_ps(m[2]), m03 = _mm_set1_ps(m[3] * w);
+			__m128 m10 = _mm_set1_ps(m[4]), m11 = _mm_set1_ps(m[5]), m12 = _mm_set1_ps(m[6]), m13 = _mm_set1_ps(m[7] * w);
+			__m128 m20 = _mm_set1_ps(m[8]), m21 = _mm_set1_ps(m[9]), m22 = _mm_set1_ps(m[10]), m23 = _mm_set1_ps(m[11] * w);
+
+			for (; i + 4 <= end; i += 4)
+			{
+				const GLfloat* src = &in[i].x;
+				__m128 a = _mm_loadu_ps(src);		// x0 y0 z0 x1
+				__m128 b = _mm_loadu_ps(src + 4);	// y1 z1 x2 y2
+				__m128 c = _mm_loadu_ps(src + 8);	// z2 x3 y3 z3
+
+				__m128 t0 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));	// x2 y2 x3 y3
+				__m128 t1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));	// y0 z0 y1 z1
+				__m128 t2 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(3, 0, 1, 0));	// y1 z1 z2 z3
+				__m128 x = _mm_shuffle_ps(a, t0, _MM_SHUFFLE(2, 0, 3, 0));
+				__m128 y = _mm_shuffle_ps(t1, t0, _MM_SHUFFLE(3, 1, 2, 0));
+				__m128 z = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(3, 2, 3, 1));
+
+				__m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m01, y)), _mm_add_ps(_mm_mul_ps(m02, z), m03));
+				__m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, x), _mm_mul_ps(m11, y)), _mm_add_ps(_mm_mul_ps(m12, z), m13));
+				__m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m20, x), _mm_mul_ps(m21, y)), _mm_add_ps(_mm_mul_ps(m22, z), m23));
+
+				__m128 xy0 = _mm_unpacklo_ps(rx, ry);	// x0 y0 x1 y1
+				__m128 xy1 = _mm_unpackhi_ps(rx, ry);	// x2 y2 x3 y3
+				__m128 zx = _mm_shuffle_ps(rz, rx, _MM_SHUFFLE(1, 1, 0, 0));	// z0 z0 x1 x1
+				__m128 yz = _mm_shuffle_ps(xy0, rz, _MM_SHUFFLE(1, 1, 3, 3));	// y1 y1 z1 z1
+				__m128 zx3 = _mm_shuffle_ps(rz, xy1, _MM_SHUFFLE(2, 2, 2, 2));	// z2 z2 x3 x3
+				__m128 yz3 = _mm_shuffle_ps(xy1, rz, _MM_SHUFFLE(3, 3, 3, 3));	// y3 y3 z3 z3
+
+				GLfloat* dst = &out[i].x;
+				_mm_storeu_ps(dst, _mm_shuffle_ps(xy0, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+				_mm_storeu_ps(dst + 4, _mm_shuffle_ps(yz, xy1, _MM_SHUFFLE(1, 0, 2, 0)));
+				_mm_storeu_ps(dst + 8, _mm_shuffle_ps(zx3, yz3, _MM_SHUFFLE(2, 0, 2, 0)));
+			}
+#elif defined(ANGEL_SIMD_NEON)
+			float32x4_t m03 = vdupq_n_f32(m[3] * w);
+			float32x4_t m13 = vdupq_n_f32(m[7] * w);
+			float32x4_t m23 = vdupq_n_f32(m[11] * w);
+
+			for (; i + 4 <= end; i += 4)
+			{
+				// vld3q / vst3q 直接完成 AoS 与 SoA 之间的转换
+				float32x4x3_t p = vld3q_f32(&in[i].x);
+				float32x4x3_t r;
+				r.val[0] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(m03, p.val[0], m[0]), p.val[1], m[1]), p.val[2], m[2]);
+				r.val[1] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(m13, p.val[0], m[4]), p.val[1], m[5]), p.val[2], m[6]);
+				r.val[2] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(m23, p.val[0], m[8]), p.val[1], m[9]), p.val[2], m[10]);
+				vst3q_f32(&out[i].x, r);
+			}
+#endif
+			for (; i < end; i++)
+			{
+				GLfloat x = in[i].x, y = in[i].y, z = in[i].z;
+				out[i] = vec3(m[0] * x + m[1] * y + m[2] * z + m[3] * w,
+					m[4] * x + m[5] * y + m[6] * z + m[7] * w,
+					m[8] * x + m[9] * y + m[10] * z + m[11] * w);
+			}
+		}
+	}  // namespace detail
+
+	// 变换 count 个点(AoS)
+	inline void TransformPoints(const mat4& m, const vec3* in, vec3* out, size_t count,
+		size_t parallelThreshold = BatchParallelThreshold)
+	{
+		const GLfloat* pm = m;
+		ParallelFor(count, parallelThreshold, [=](size_t begin, size_t end) {
+			detail::transformAoS(pm, 1.0f, in, out, begin, end);
+		});
+	}
+
+	// 变换 count 个方向(AoS)，不受平移影响
+	inline void TransformDirections(const mat4& m, const vec3* in, vec3* out, size_t count,
+		size_t parallelThreshold = BatchParallelThreshold)
+	{
+		const GLfloat* pm = m;
+		ParallelFor(count, parallelThreshold, [=](size_t begin, size_t end) {
+			detail::transformAoS(pm, 0.0f, in, out, begin, end);
+		});
+	}
+
+	// 变换 count 个点(SoA)
+	inline void TransformPoints(const mat4& m,
+		const GLfloat* xs, const GLfloat* ys, const GLfloat* zs,
+		GLfloat* outX, GLfloat* outY, GLfloat* outZ, size_t count,
+		size_t parallelThreshold = BatchParallelThreshold)
+	{
+		const GLfloat* pm = m;
+		ParallelFor(count, parallelThreshold, [=](size_t begin, size_t end) {
+			detail::transformSoA(pm, 1.0f, xs, ys, zs, outX, outY, outZ, begin, end);
+		});
+	}
+
+	// 变换 count 个方向(SoA)
+	inline void TransformDirections(const mat4& m,
+		const GLfloat* xs, const GLfloat* ys, const GLfloat* zs,
+		GLfloat* outX, GLfloat* outY, GLfloat* outZ, size_t count,
+		size_t parallelThreshold = BatchParallelThreshold)
+	{
+		const GLfloat* pm = m;
+		ParallelFor(count, parallelThreshold, [=](size_t begin, size_t end) {
+			detail::transformSoA(pm, 0.0f, xs, ys, zs, outX, outY, outZ, begin, end);
+		});
+	}
+
 	//----------------------------------------------------------------------------
 
 	inline vec4 minus(const vec4& a, const vec4& b)
@@ -0,0 +1,376 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+//
+//  --- quat.h ---
+//  定义四元数类 quat 和对偶四元数类 dualquat
+//
+//   quat 表示旋转：两个旋转的组合只需 16 次乘法(4x4 矩阵相乘需 64 次)，
+//   并且可以用 slerp/nlerp 平滑插值。dualquat 表示旋转 + 平移(刚体变换)。
+//   组合好的变换用 Rotate(q) / Transform(dq) 转为 mat4，
+//   需要 3x4 仿射矩阵时再用 affine3x4(Rotate(q)) / affine3x4(Transform(dq))。
+//   旋转方向与 Rotate(theta, x, y, z) 一致，q1 * q2 对应 Rotate(q1) * Rotate(q2)。
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ANGEL_QUAT_H__
+#define __ANGEL_QUAT_H__
+
+#include "mat.h"
+
+namespace Angel
+{
+
+	//////////////////////////////////////////////////////////////////////////////
+	//
+	//  quat - (x, y, z) 为向量部分，w 为标量部分
+	//
+
+	struct quat
+	{
+
+		GLfloat  x;
+		GLfloat  y;
+		GLfloat  z;
+		GLfloat  w;
+
+		//
+		//  --- Constructors and Destructors ---
+		//
+
+		constexpr quat() :  // 单位四元数，表示不旋转
+			x(0.0), y(0.0), z(0.0), w(1.0) {}
+
+		constexpr quat(GLfloat x, GLfloat y, GLfloat z, GLfloat w) :
+			x(x), y(y), z(z), w(w) {}
+
+		constexpr quat(const vec3& v, GLfloat w) :
+			x(v.x), y(v.y), z(v.z), w(w) {}
+
+		//
+		//  --- (non-modifying) Arithematic Operators ---
+		//
+
+		constexpr quat operator - () const
+		{
+			return quat(-x, -y, -z, -w);
+		}
+
+		constexpr quat operator + (const quat& q) const
+		{
+			return quat(x + q.x, y + q.y, z + q.z, w + q.w);
+		}
+
+		constexpr quat operator - (const quat& q) const
+		{
+			return quat(x - q.x, y - q.y, z - q.z, w - q.w);
+		}
+
+		constexpr quat operator * (const GLfloat s) const
+		{
+			return quat(s * x, s * y, s * z, s * w);
+		}
+
+		friend constexpr quat operator * (const GLfloat s, const quat& q)
+		{
+			return q * s;
+		}
+
+		// 四元数乘法(Hamilton 积)，先旋转 q 再旋转 *this
+		constexpr quat operator * (const quat& q) const
+		{
+			return quat(w * q.x + x * q.w + y * q.z - z * q.y,
+				w * q.y - x * q.z + y * q.w + z * q.x,
+				w * q.z + x * q.y - y * q.x + z * q.w,
+				w * q.w - x * q.x - y * q.y - z * q.z);
+		}
+
+		//
+		//  --- (modifying) Arithematic Operators ---
+		//
+
+		constexpr quat& operator *= (const quat& q)
+		{
+			return *this = *this * q;
+		}
+
+		//
+		//  --- Quaternion / Vector operators ---
+		//
+
+		// 用单位四元数旋转向量 v
+		constexpr vec3 operator * (const vec3& v) const
+		{
+			// v' = v + w * t + u x t，其中 u = (x, y, z)，t = 2 * (u x v)
+			vec3 u(x, y, z);
+			vec3 t = 2.0 * cross(u, v);
+			return v + w * t + cross(u, t);
+		}
+
+		//
+		//  --- Insertion and Extraction Operators ---
+		//
+
+		friend std::ostream& operator << (std::ostream& os, const quat& q)
+		{
+			return os << "( " << q.x << ", " << q.y << ", " << q.z << ", " << q.w << " )";
+		}
+	};
+
+	static_assert(sizeof(quat) == 4 * sizeof(GLfloat), "quat must be four packed GLfloats");
+	static_assert(std::is_trivially_copyable<quat>::value, "quat must be trivially copyable");
+
+	//----------------------------------------------------------------------------
+	//
+	//  Non-class quat Methods
+	//
+
+	inline constexpr GLfloat dot(const quat& a, const quat& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	}
+
+	inline GLfloat length(const quat& q)
+	{
+		return std::sqrt(dot(q, q));
+	}
+
+	inline quat normalize(const quat& q)
+	{
+		GLfloat len = length(q);
+		if (len < DivideByZeroTolerance)
+		{
+			return quat();
+		}
+		return q * (GLfloat(1.0) / len);
+	}
+
+	// 共轭，对单位四元数即逆旋转
+	inline constexpr quat conjugate(const quat& q)
+	{
+		return quat(-q.x, -q.y, -q.z, q.w);
+	}
+
+	inline quat inverse(const quat& q)
+	{
+		GLfloat d = dot(q, q);
+		if (d < DivideByZeroTolerance)
+		{
+			return quat();
+		}
+		return conjugate(q) * (GLfloat(1.0) / d);
+	}
+
+	// 归一化线性插值：沿最短路径，速度不均匀但比 slerp 快得多，适合相邻帧之间的小角度插值
+	inline quat nlerp(const quat& a, const quat& b, const GLfloat t)
+	{
+		quat c = dot(a, b) < 0.0f ? -b : b;
+		return normalize(a * (1.0f - t) + c * t);
+	}
+
+	// 球面线性插值：沿最短路径匀速旋转
+	inline quat slerp(const quat& a, const quat& b, const GLfloat t)
+	{
+		GLfloat cosTheta = dot(a, b);
+		quat c = b;
+		if (cosTheta < 0.0f)
+		{
+			c = -b;
+			cosTheta = -cosTheta;
+		}
+
+		// 夹角很小时 sin(theta) 接近 0，退化为 nlerp
+		if (cosTheta > 0.9995f)
+		{
+			return normalize(a * (1.0f - t) + c * t);
+		}
+
+		GLfloat theta = std::acos(cosTheta);
+		GLfloat r = GLfloat(1.0) / std::sin(theta);
+		return a * (std::sin((1.0f - t) * theta) * r) + c * (std::sin(t * theta) * r);
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  Quaternion rotation generators
+	//
+	//    参数与 Rotate / RotateX / RotateY / RotateZ 相同(角度制)，
+	//    绕坐标轴的版本为 constexpr，常量角度在编译期求值
+	//
+
+	inline constexpr quat QuatRotateX(const GLfloat theta)
+	{
+		GLfloat half = DegreesToRadians * theta * 0.5f;
+		return quat(GLfloat(detail::constexprSin(half)), 0.0, 0.0, GLfloat(detail::constexprCos(half)));
+	}
+
+	inline constexpr quat QuatRotateY(const GLfloat theta)
+	{
+		GLfloat half = DegreesToRadians * theta * 0.5f;
+		return quat(0.0, GLfloat(detail::constexprSin(half)), 0.0, GLfloat(detail::constexprCos(half)));
+	}
+
+	inline constexpr quat QuatRotateZ(const GLfloat theta)
+	{
+		GLfloat half = DegreesToRadians * theta * 0.5f;
+		return quat(0.0, 0.0, GLfloat(detail::constexprSin(half)), GLfloat(detail::constexprCos(half)));
+	}
+
+	// 绕任意轴 (vx, vy, vz) 旋转 theta 度，轴长度为 0 时返回单位四元数
+	inline quat QuatRotate(const GLfloat theta, const GLfloat vx,
+		const GLfloat vy, const GLfloat vz)
+	{
+		GLfloat mag = std::sqrt(vx * vx + vy * vy + vz * vz);
+		if (mag < DivideByZeroTolerance)
+		{
+			return quat();
+		}
+
+		GLfloat s, c;
+		SinCos(DegreesToRadians * theta * 0.5f, s, c);
+		s /= mag;
+		return quat(vx * s, vy * s, vz * s, c);
+	}
+
+	// 单位四元数转为旋转矩阵
+	inline constexpr mat4 Rotate(const quat& q)
+	{
+		GLfloat xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		GLfloat xy = q.x * q.y, yz = q.y * q.z, zx = q.z * q.x;
+		GLfloat wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+		return mat4(vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz), 2.0f * (zx + wy), 0.0),
+			vec4(2.0f * (xy + wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx), 0.0),
+			vec4(2.0f * (zx - wy), 2.0f * (yz + wx), 1.0f - 2.0f * (xx + yy), 0.0),
+			vec4(0.0, 0.0, 0.0, 1.0));
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//
+	//  dualquat - 对偶四元数 real + e * dual
+	//
+	//    real 为旋转，dual = 0.5 * t * real(t 为平移)，表示先旋转再平移的刚体变换
+	//
+
+	struct dualquat
+	{
+
+		quat  real;
+		quat  dual;
+
+		//
+		//  --- Constructors and Destructors ---
+		//
+
+		constexpr dualquat() :  // 恒等变换
+			real(), dual(0.0, 0.0, 0.0, 0.0) {}
+
+		constexpr dualquat(const quat& real, const quat& dual) :
+			real(real), dual(dual) {}
+
+		// 纯旋转
+		constexpr dualquat(const quat& r) :
+			real(r), dual(0.0, 0.0, 0.0, 0.0) {}
+
+		// 先旋转 r，再平移 t
+		constexpr dualquat(const quat& r, const vec3& t) :
+			real(r), dual(quat(t, 0.0) * r * 0.5f) {}
+
+		//
+		//  --- (non-modifying) Arithematic Operators ---
+		//
+
+		constexpr dualquat operator + (const dualquat& q) const
+		{
+			return dualquat(real + q.real, dual + q.dual);
+		}
+
+		constexpr dualquat operator * (const GLfloat s) const
+		{
+			return dualquat(real * s, dual * s);
+		}
+
+		// 变换组合，先做 q 再做 *this，对应 Transform(*this) * Transform(q)
+		constexpr dualquat operator * (const dualquat& q) const
+		{
+			return dualquat(real * q.real, real * q.dual + dual * q.real);
+		}
+
+		constexpr dualquat& operator *= (const dualquat& q)
+		{
+			return *this = *this * q;
+		}
+
+		//
+		//  --- Dual quaternion / Point operators ---
+		//
+
+		// 平移部分 t = 2 * dual * conjugate(real)
+		constexpr vec3 translation() const
+		{
+			quat t = dual * conjugate(real) * 2.0f;
+			return vec3(t.x, t.y, t.z);
+		}
+
+		// 变换点 p(先旋转再平移)
+		constexpr vec3 operator * (const vec3& p) const
+		{
+			return real * p + translation();
+		}
+	};
+
+	static_assert(sizeof(dualquat) == 8 * sizeof(GLfloat), "dualquat must be eight packed GLfloats");
+	static_assert(std::is_trivially_copyable<dualquat>::value, "dualquat must be trivially copyable");
+
+	//----------------------------------------------------------------------------
+	//
+	//  Non-class dualquat Methods
+	//
+
+	// 归一化：real 变为单位四元数，并去掉 dual 中与 real 不正交的分量
+	inline dualquat normalize(const dualquat& q)
+	{
+		GLfloat len = length(q.real);
+		if (len < DivideByZeroTolerance)
+		{
+			return dualquat();
+		}
+
+		GLfloat r = GLfloat(1.0) / len;
+		quat real = q.real * r;
+		quat dual = q.dual * r;
+		return dualquat(real, dual - real * dot(real, dual));
+	}
+
+	// 单位对偶四元数的逆变换
+	inline constexpr dualquat conjugate(const dualquat& q)
+	{
+		return dualquat(conjugate(q.real), conjugate(q.dual));
+	}
+
+	// 对偶四元数线性混合(DLB)，沿最短路径
+	inline dualquat nlerp(const dualquat& a, const dualquat& b, const GLfloat t)
+	{
+		GLfloat s = dot(a.real, b.real) < 0.0f ? -t : t;
+		return normalize(a * (1.0f - t) + b * s);
+	}
+
+	// 旋转部分做 slerp，平移部分做线性插值
+	inline dualquat slerp(const dualquat& a, const dualquat& b, const GLfloat t)
+	{
+		vec3 ta = a.translation();
+		vec3 tb = b.translation();
+		return dualquat(slerp(a.real, b.real, t), ta + (tb - ta) * t);
+	}
+
+	// 单位对偶四元数转为 4x4 矩阵
+	inline constexpr mat4 Transform(const dualquat& q)
+	{
+		mat4 m = Rotate(q.real);
+		vec3 t = q.translation();
+		m[0].w = t.x;
+		m[1].w = t.y;
+		m[2].w = t.z;
+		return m;
+	}
+
+}  // namespace Angel
+
+#endif // __ANGEL_QUAT_H__
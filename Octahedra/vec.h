@@ -9,6 +9,8 @@
 
 #include "Angel.h"
 
+#include <type_traits>
+
 namespace Angel
 {
 
@@ -27,17 +29,12 @@ namespace Angel
 		//  --- Constructors and Destructors ---
 		//
 
-		vec2(GLfloat s = GLfloat(0.0)) :
+		constexpr vec2(GLfloat s = GLfloat(0.0)) :
 			x(s), y(s) {}
 
-		vec2(GLfloat x, GLfloat y) :
+		constexpr vec2(GLfloat x, GLfloat y) :
 			x(x), y(y) {}
 
-		vec2(const vec2& v)
-		{
-			x = v.x;  y = v.y;
-		}
-
 		//
 		//  --- Indexing Operator ---
 		//
@@ -49,37 +46,37 @@ namespace Angel
 		//  --- (non-modifying) Arithematic Operators ---
 		//
 
-		vec2 operator - () const // unary minus operator
+		constexpr vec2 operator - () const // unary minus operator
 		{
 			return vec2(-x, -y);
 		}
 
-		vec2 operator + (const vec2& v) const
+		constexpr vec2 operator + (const vec2& v) const
 		{
 			return vec2(x + v.x, y + v.y);
 		}
 
-		vec2 operator - (const vec2& v) const
+		constexpr vec2 operator - (const vec2& v) const
 		{
 			return vec2(x - v.x, y - v.y);
 		}
 
-		vec2 operator * (const GLfloat s) const
+		constexpr vec2 operator * (const GLfloat s) const
 		{
 			return vec2(s * x, s * y);
 		}
 
-		vec2 operator * (const vec2& v) const
+		constexpr vec2 operator * (const vec2& v) const
 		{
 			return vec2(x * v.x, y * v.y);
 		}
 
-		friend vec2 operator * (const GLfloat s, const vec2& v)
+		friend constexpr vec2 operator * (const GLfloat s, const vec2& v)
 		{
 			return v * s;
 		}
 
-		vec2 operator / (const GLfloat s) const {
+		constexpr vec2 operator / (const GLfloat s) const {
 #ifdef DEBUG
 			if (std::fabs(s) < DivideByZeroTolerance) {
 				std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
@@ -96,27 +93,27 @@ namespace Angel
 		//  --- (modifying) Arithematic Operators ---
 		//
 
-		vec2& operator += (const vec2& v)
+		constexpr vec2& operator += (const vec2& v)
 		{
 			x += v.x;  y += v.y;   return *this;
 		}
 
-		vec2& operator -= (const vec2& v)
+		constexpr vec2& operator -= (const vec2& v)
 		{
 			x -= v.x;  y -= v.y;  return *this;
 		}
 
-		vec2& operator *= (const GLfloat s)
+		constexpr vec2& operator *= (const GLfloat s)
 		{
 			x *= s;  y *= s;   return *this;
 		}
 
-		vec2& operator *= (const vec2& v)
+		constexpr vec2& operator *= (const vec2& v)
 		{
 			x *= v.x;  y *= v.y; return *this;
 		}
 
-		vec2& operator /= (const GLfloat s)
+		constexpr vec2& operator /= (const GLfloat s)
 		{
 #ifdef DEBUG
 			if (std::fabs(s) < DivideByZeroTolerance)
@@ -166,7 +163,7 @@ namespace Angel
 	//  Non-class vec2 Methods
 	//
 
-	inline GLfloat dot(const vec2& u, const vec2& v)
+	inline constexpr GLfloat dot(const vec2& u, const vec2& v)
 	{
 		return u.x * v.x + u.y * v.y;
 	}
@@ -198,15 +195,14 @@ namespace Angel
 		//  --- Constructors and Destructors ---
 		//
 
-		vec3(GLfloat s = GLfloat(0.0)) :
+		constexpr vec3(GLfloat s = GLfloat(0.0)) :
 			x(s), y(s), z(s) {}
 
-		vec3(GLfloat x, GLfloat y, GLfloat z) :
+		constexpr vec3(GLfloat x, GLfloat y, GLfloat z) :
 			x(x), y(y), z(z) {}
 
-		vec3(const vec3& v) { x = v.x;  y = v.y;  z = v.z; }
-
-		vec3(const vec2& v, const float f) { x = v.x;  y = v.y;  z = f; }
+		constexpr vec3(const vec2& v, const float f) :
+			x(v.x), y(v.y), z(f) {}
 
 		//
 		//  --- Indexing Operator ---
@@ -219,37 +215,37 @@ namespace Angel
 		//  --- (non-modifying) Arithematic Operators ---
 		//
 
-		vec3 operator - () const  // unary minus operator
+		constexpr vec3 operator - () const  // unary minus operator
 		{
 			return vec3(-x, -y, -z);
 		}
 
-		vec3 operator + (const vec3& v) const
+		constexpr vec3 operator + (const vec3& v) const
 		{
 			return vec3(x + v.x, y + v.y, z + v.z);
 		}
 
-		vec3 operator - (const vec3& v) const
+		constexpr vec3 operator - (const vec3& v) const
 		{
 			return vec3(x - v.x, y - v.y, z - v.z);
 		}
 
-		vec3 operator * (const GLfloat s) const
+		constexpr vec3 operator * (const GLfloat s) const
 		{
 			return vec3(s * x, s * y, s * z);
 		}
 
-		vec3 operator * (const vec3& v) const
+		constexpr vec3 operator * (const vec3& v) const
 		{
 			return vec3(x * v.x, y * v.y, z * v.z);
 		}
 
-		friend vec3 operator * (const GLfloat s, const vec3& v)
+		friend constexpr vec3 operator * (const GLfloat s, const vec3& v)
 		{
 			return v * s;
 		}
 
-		vec3 operator / (const GLfloat s) const
+		constexpr vec3 operator / (const GLfloat s) const
 		{
 #ifdef DEBUG
 			if (std::fabs(s) < DivideByZeroTolerance)
@@ -268,27 +264,27 @@ namespace Angel
 		//  --- (modifying) Arithematic Operators ---
 		//
 
-		vec3& operator += (const vec3& v)
+		constexpr vec3& operator += (const vec3& v)
 		{
 			x += v.x;  y += v.y;  z += v.z;  return *this;
 		}
 
-		vec3& operator -= (const vec3& v)
+		constexpr vec3& operator -= (const vec3& v)
 		{
 			x -= v.x;  y -= v.y;  z -= v.z;  return *this;
 		}
 
-		vec3& operator *= (const GLfloat s)
+		constexpr vec3& operator *= (const GLfloat s)
 		{
 			x *= s;  y *= s;  z *= s;  return *this;
 		}
 
-		vec3& operator *= (const vec3& v)
+		constexpr vec3& operator *= (const vec3& v)
 		{
 			x *= v.x;  y *= v.y;  z *= v.z;  return *this;
 		}
 
-		vec3& operator /= (const GLfloat s)
+		constexpr vec3& operator /= (const GLfloat s)
 		{
 #ifdef DEBUG
 			if (std::fabs(s) < DivideByZeroTolerance)
@@ -338,7 +334,7 @@ namespace Angel
 	//  Non-class vec3 Methods
 	//
 
-	inline GLfloat dot(const vec3& u, const vec3& v)
+	inline constexpr GLfloat dot(const vec3& u, const vec3& v)
 	{
 		return u.x * v.x + u.y * v.y + u.z * v.z;
 	}
@@ -353,7 +349,7 @@ namespace Angel
 		return v / length(v);
 	}
 
-	inline vec3 cross(const vec3& a, const vec3& b)
+	inline constexpr vec3 cross(const vec3& a, const vec3& b)
 	{
 		return vec3(a.y * b.z - a.z * b.y,
 			a.z * b.x - a.x * b.z,
@@ -379,23 +375,17 @@ namespace Angel
 		//  --- Constructors and Destructors ---
 		//
 
-		vec4(GLfloat s = GLfloat(0.0)) :
+		constexpr vec4(GLfloat s = GLfloat(0.0)) :
 			x(s), y(s), z(s), w(s) {}
 
-		vec4(GLfloat x, GLfloat y, GLfloat z, GLfloat w) :
+		constexpr vec4(GLfloat x, GLfloat y, GLfloat z, GLfloat w) :
 			x(x), y(y), z(z), w(w) {}
 
-		vec4(const vec4& v) { x = v.x;  y = v.y;  z = v.z;  w = v.w; }
+		constexpr vec4(const vec3& v, const float w = 1.0) :
+			x(v.x), y(v.y), z(v.z), w(w) {}
 
-		vec4(const vec3& v, const float w = 1.0) : w(w)
-		{
-			x = v.x;  y = v.y;  z = v.z;
-		}
-
-		vec4(const vec2& v, const float z, const float w) : z(z), w(w)
-		{
-			x = v.x;  y = v.y;
-		}
+		constexpr vec4(const vec2& v, const float z, const float w) :
+			x(v.x), y(v.y), z(z), w(w) {}
 
 		//
 		//  --- Indexing Operator ---
@@ -408,37 +398,37 @@ namespace Angel
 		//  --- (non-modifying) Arithematic Operators ---
 		//
 
-		vec4 operator - () const  // unary minus operator
+		constexpr vec4 operator - () const  // unary minus operator
 		{
 			return vec4(-x, -y, -z, -w);
 		}
 
-		vec4 operator + (const vec4& v) const
+		constexpr vec4 operator + (const vec4& v) const
 		{
 			return vec4(x + v.x, y + v.y, z + v.z, w + v.w);
 		}
 
-		vec4 operator - (const vec4& v) const
+		constexpr vec4 operator - (const vec4& v) const
 		{
 			return vec4(x - v.x, y - v.y, z - v.z, w - v.w);
 		}
 
-		vec4 operator * (const GLfloat s) const
+		constexpr vec4 operator * (const GLfloat s) const
 		{
 			return vec4(s * x, s * y, s * z, s * w);
 		}
 
-		vec4 operator * (const vec4& v) const
+		constexpr vec4 operator * (const vec4& v) const
 		{
 			return vec4(x * v.x, y * v.y, z * v.z, w * v.w);
 		}
 
-		friend vec4 operator * (const GLfloat s, const vec4& v)
+		friend constexpr vec4 operator * (const GLfloat s, const vec4& v)
 		{
 			return v * s;
 		}
 
-		vec4 operator / (const GLfloat s) const
+		constexpr vec4 operator / (const GLfloat s) const
 		{
 #ifdef DEBUG
 			if (std::fabs(s) < DivideByZeroTolerance)
@@ -457,27 +447,27 @@ namespace Angel
 		//  --- (modifying) Arithematic Operators ---
 		//
 
-		vec4& operator += (const vec4& v)
+		constexpr vec4& operator += (const vec4& v)
 		{
 			x += v.x;  y += v.y;  z += v.z;  w += v.w;  return *this;
 		}
 
-		vec4& operator -= (const vec4& v)
+		constexpr vec4& operator -= (const vec4& v)
 		{
 			x -= v.x;  y -= v.y;  z -= v.z;  w -= v.w;  return *this;
 		}
 
-		vec4& operator *= (const GLfloat s)
+		constexpr vec4& operator *= (const GLfloat s)
 		{
 			x *= s;  y *= s;  z *= s;  w *= s;  return *this;
 		}
 
-		vec4& operator *= (const vec4& v)
+		constexpr vec4& operator *= (const vec4& v)
 		{
 			x *= v.x, y *= v.y, z *= v.z, w *= v.w;  return *this;
 		}
 
-		vec4& operator /= (const GLfloat s)
+		constexpr vec4& operator /= (const GLfloat s)
 		{
 #ifdef DEBUG
 			if (std::fabs(s) < DivideByZeroTolerance)
@@ -528,7 +518,7 @@ namespace Angel
 	//  Non-class vec4 Methods
 	//
 
-	inline GLfloat dot(const vec4& u, const vec4& v)
+	inline constexpr GLfloat dot(const vec4& u, const vec4& v)
 	{
 		return u.x * v.x + u.y * v.y + u.z * v.z + u.w + v.w;
 	}
@@ -543,7 +533,7 @@ namespace Angel
 		return v / length(v);
 	}
 
-	inline vec3 cross(const vec4& a, const vec4& b)
+	inline constexpr vec3 cross(const vec4& a, const vec4& b)
 	{
 		return vec3(a.y * b.z - a.z * b.y,
 			a.z * b.x - a.x * b.z,
@@ -551,6 +541,51 @@ namespace Angel
 	}
 
 	//----------------------------------------------------------------------------
+	//
+	//  --- Layout guarantees ---
+	//
+	//   向量与 GLfloat 数组的内存布局一致且可平凡复制(使用编译器生成的拷贝构造)，
+	//   因此 vec3 数组可以直接交给 glBufferData，std::vector 扩容时也可以按字节拷贝
+	//
+
+	static_assert(sizeof(vec2) == 2 * sizeof(GLfloat), "vec2 must be two packed GLfloats");
+	static_assert(sizeof(vec3) == 3 * sizeof(GLfloat), "vec3 must be three packed GLfloats");
+	static_assert(sizeof(vec4) == 4 * sizeof(GLfloat), "vec4 must be four packed GLfloats");
+	static_assert(std::is_trivially_copyable<vec2>::value, "vec2 must be trivially copyable");
+	static_assert(std::is_trivially_copyable<vec3>::value, "vec3 must be trivially copyable");
+	static_assert(std::is_trivially_copyable<vec4>::value, "vec4 must be trivially copyable");
+	static_assert(std::is_standard_layout<vec4>::value, "vec4 must be standard layout");
+
+	//----------------------------------------------------------------------------
+	//
+	//  --- 16-byte aligned variants ---
+	//
+	//   vec3a / vec4a 按 16 字节对齐(vec3a 末尾补 4 字节，步长为 16)，
+	//   用于 SIMD 对齐加载和 std140 布局的 uniform 块；运算结果为普通的 vec3 / vec4
+	//
+
+	struct alignas(16) vec3a : public vec3
+	{
+		using vec3::vec3;
+
+		constexpr vec3a() : vec3() {}
+		constexpr vec3a(const vec3& v) : vec3(v) {}
+	};
+
+	struct alignas(16) vec4a : public vec4
+	{
+		using vec4::vec4;
+
+		constexpr vec4a() : vec4() {}
+		constexpr vec4a(const vec4& v) : vec4(v) {}
+	};
+
+	static_assert(sizeof(vec3a) == 16 && alignof(vec3a) == 16, "vec3a must be 16 bytes, 16-byte aligned");
+	static_assert(sizeof(vec4a) == 16 && alignof(vec4a) == 16, "vec4a must be 16 bytes, 16-byte aligned");
+	static_assert(std::is_trivially_copyable<vec3a>::value, "vec3a must be trivially copyable");
+	static_assert(std::is_trivially_copyable<vec4a>::value, "vec4a must be trivially copyable");
+
+	//----------------------------------------------------------------------------
 
 }  // namespace Angel
 
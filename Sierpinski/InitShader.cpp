@@ -1,62 +1,447 @@
 ﻿#include "Angel.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <direct.h>
+#  include <GL/wglew.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#ifdef __linux__
+#  include <sys/inotify.h>
+#endif
 
 namespace Angel
 {
-	static char* readShaderSource(const char* shaderFile)
+#ifdef ANGEL_EMBED_SHADERS
+	// 嵌入的 shader 源码：以 /p:EmbedShaders=true 生成时，EmbedShaders.ps1 把工程目录下的 .glsl
+	// 生成为 EmbeddedShaders.h 中的字符串常量，运行时不读文件，也不依赖工作目录
+	struct EmbeddedShader
+	{
+		const char* filename;
+		const char* source;
+	};
+
+#  include "EmbeddedShaders.h"
+#endif
+
+	// 打开文件，VS 中 fopen 在 SDL 检查下不能使用，改用 fopen_s
+	static FILE* openFile(const char* filename, const char* mode)
 	{
+#ifdef _MSC_VER
 		FILE* fp;
-		char* buff = NULL;
-		if (!fopen_s(&fp, shaderFile, "r"))
+		return fopen_s(&fp, filename, mode) ? NULL : fp;
+#else
+		return fopen(filename, mode);
+#endif
+	}
+
+	// 映射到内存的 shader 文件，view 为 NULL 表示没有映射(嵌入的源码)
+	struct MappedFile
+	{
+		void*   view = NULL;
+		size_t  size = 0;
+	};
+
+	// 可执行文件所在目录(以路径分隔符结尾)，取不到时返回空串
+	static std::string executableDirectory()
+	{
+		char path[4096];
+#ifdef _WIN32
+		DWORD length = GetModuleFileNameA(NULL, path, sizeof(path));
+		if (length == 0 || length == sizeof(path))
 		{
-			fseek(fp, 0L, SEEK_END); // 将文件指针移动到文件尾
-			long size = ftell(fp); // 获取文件长度
+			return std::string();
+		}
+#else
+		ssize_t length = readlink("/proc/self/exe", path, sizeof(path));
+		if (length <= 0 || length == (ssize_t)sizeof(path))
+		{
+			return std::string();
+		}
+#endif
+		std::string dir(path, length);
+		size_t slash = dir.find_last_of("/\\");
+		return slash == std::string::npos ? std::string() : dir.substr(0, slash + 1);
+	}
 
-			fseek(fp, 0L, SEEK_SET); // 将指针移到文件头
-			buff = new char[size + 1]; // 增加一位给结尾符 '\0'
-			memset(buff, 0, size + 1); // 初始化
-			fread(buff, 1, size, fp); // 一次性读出整个文件
+	// 把文件只读映射到内存，失败(包括空文件)时返回 false
+	static bool mapFile(const std::string& filename, MappedFile& file)
+	{
+#ifdef _WIN32
+		HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (handle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		LARGE_INTEGER size;
+		HANDLE mapping = NULL;
+		if (GetFileSizeEx(handle, &size) && size.QuadPart > 0)
+		{
+			mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		}
+		if (mapping)
+		{
+			file.view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			file.size = (size_t)size.QuadPart;
+			CloseHandle(mapping);	// 映射视图保持文件映射对象有效
+		}
+		CloseHandle(handle);
+#else
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0)
+		{
+			void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view != MAP_FAILED)
+			{
+				file.view = view;
+				file.size = (size_t)st.st_size;
+			}
+		}
+		close(fd);	// 映射建立后即可关闭文件
+#endif
+		return file.view != NULL;
+	}
 
-			buff[size] = '\0';
-			fclose(fp);
+	static void unmapFile(MappedFile& file)
+	{
+		if (file.view)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(file.view);
+#else
+			munmap(file.view, file.size);
+#endif
 		}
+		file = MappedFile();
+	}
 
-		return buff;
+	// shader 文件的实际路径：先按给出的路径(相对于工作目录)查找，找不到再到可执行文件所在目录查找，都没有时返回空串
+	static std::string resolveShaderPath(const char* filename)
+	{
+		std::string candidates[2] = { filename, executableDirectory() + filename };
+		for (const std::string& path : candidates)
+		{
+			FILE* fp = openFile(path.c_str(), "rb");
+			if (fp)
+			{
+				fclose(fp);
+				return path;
+			}
+		}
+		return std::string();
 	}
 
-	// 根据顶点和片元Shader文件 创建 GLSL 程序对象
-	GLuint InitShader(const char* vShaderFile, const char* fShaderFile)
+	// 取得 s.filename 的源码：s.source 直接指向映射的文件(或嵌入的常量)，长度为 s.length，不拷贝、不以 '\0' 结尾
+	static bool loadShaderSource(Shader& s, MappedFile& file)
+	{
+#ifdef ANGEL_EMBED_SHADERS
+		for (const EmbeddedShader& embedded : EmbeddedShaders)
+		{
+			if (strcmp(embedded.filename, s.filename) == 0)
+			{
+				s.source = embedded.source;
+				s.length = (GLint)strlen(embedded.source);
+				return true;
+			}
+		}
+		return false;
+#else
+		std::string path = resolveShaderPath(s.filename);
+		if (path.empty() || !mapFile(path, file))
+		{
+			return false;
+		}
+		s.source = static_cast<const GLchar*>(file.view);
+		s.length = (GLint)file.size;
+		// 跳过 UTF-8 BOM，GLSL 编译器不一定接受
+		if (s.length >= 3 && memcmp(s.source, "\xEF\xBB\xBF", 3) == 0)
+		{
+			s.source += 3;
+			s.length -= 3;
+		}
+		return true;
+#endif
+	}
+
+	/*程序二进制缓存*/
+	// 链接好的程序用 glGetProgramBinary 取出存入缓存目录，下次启动时用 glProgramBinary 直接加载，省去编译和链接。
+	// 文件名为键的散列：两个 shader 的源码 + 驱动的厂商、渲染器、版本字符串，更新驱动或修改 shader 后自动失效；
+	// 属性没有用 glBindAttribLocation 指定，其位置由链接器决定并保存在二进制中，加载后与编译时一致。
+	// 缓存目录由环境变量 ANGEL_SHADER_CACHE 指定，默认为工作目录下的 shadercache，设为空串时不使用缓存。
+	// 驱动拒绝加载(格式不符等)时回退到正常编译，并覆盖缓存文件
+	struct ProgramBinaryHeader
+	{
+		char    magic[4];				// "APBC"
+		GLuint  version;				// 文件格式版本
+		GLenum  format;					// glGetProgramBinary 返回的二进制格式
+		GLuint  length;					// 二进制数据的字节数
+		GLuint  compileMicroseconds;	// 编译 + 链接用时，命中时用来报告节省的时间
+	};
+
+	const GLuint ProgramBinaryVersion = 1;
+
+	// FNV-1a 散列
+	static unsigned long long hashBytes(const char* s, size_t length, unsigned long long h)
+	{
+		for (size_t i = 0; i < length; i++)
+		{
+			h = (h ^ (unsigned char)s[i]) * 1099511628211ull;
+		}
+		return (h ^ 0xff) * 1099511628211ull; // 分隔符，使 "ab" + "c" 与 "a" + "bc" 不同
+	}
+
+	// NULL 按空串处理
+	static unsigned long long hashString(const char* s, unsigned long long h)
+	{
+		return hashBytes(s, s ? strlen(s) : 0, h);
+	}
+
+	static bool programBinarySupported()
+	{
+		if (!GLEW_ARB_get_program_binary)
+		{
+			return false;
+		}
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		return formats > 0;
+	}
+
+	// 缓存目录，不使用缓存时返回空串
+	static std::string programCacheDirectory()
+	{
+#ifdef _MSC_VER
+		char* dir = NULL;
+		size_t length;
+		if (_dupenv_s(&dir, &length, "ANGEL_SHADER_CACHE") || dir == NULL)
+		{
+			return "shadercache";
+		}
+		std::string result = dir;
+		free(dir);
+		return result;
+#else
+		const char* dir = getenv("ANGEL_SHADER_CACHE");
+		return dir ? dir : "shadercache";
+#endif
+	}
+
+	static std::string programCachePath(const std::string& dir, const Shader* shaders, int count)
+	{
+		unsigned long long h = 14695981039346656037ull;
+		for (int i = 0; i < count; i++)
+		{
+			h = hashBytes(shaders[i].source, shaders[i].length, h);
+		}
+		h = hashString((const char*)glGetString(GL_VENDOR), h);
+		h = hashString((const char*)glGetString(GL_RENDERER), h);
+		h = hashString((const char*)glGetString(GL_VERSION), h);
+
+		char name[32];
+		snprintf(name, sizeof(name), "/%016llx.bin", h);
+		return dir + name;
+	}
+
+	// 从缓存文件加载程序，文件不存在、已损坏或驱动拒绝时返回 0
+	static GLuint loadProgramBinary(const std::string& path, GLuint& compileMicroseconds)
 	{
+		FILE* fp = openFile(path.c_str(), "rb");
+		if (fp == NULL)
+		{
+			return 0;
+		}
+
+		ProgramBinaryHeader header;
+		std::vector<char> binary;
+		bool valid = fread(&header, sizeof(header), 1, fp) == 1
+			&& memcmp(header.magic, "APBC", 4) == 0 && header.version == ProgramBinaryVersion;
+		if (valid)
+		{
+			binary.resize(header.length);
+			valid = fread(binary.data(), 1, binary.size(), fp) == binary.size();
+		}
+		fclose(fp);
+		if (!valid)
+		{
+			return 0;
+		}
+
 		GLuint program = glCreateProgram();
+		glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+		GLint linked;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (!linked)
+		{
+			glDeleteProgram(program);
+			return 0;
+		}
+		compileMicroseconds = header.compileMicroseconds;
+		return program;
+	}
+
+	static void saveProgramBinary(const std::string& dir, const std::string& path, GLuint program, GLuint compileMicroseconds)
+	{
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+		{
+			return;
+		}
 
-		Shader shaders[2] =
+		ProgramBinaryHeader header = { { 'A', 'P', 'B', 'C' }, ProgramBinaryVersion, 0, 0, compileMicroseconds };
+		std::vector<char> binary(length);
+		glGetProgramBinary(program, length, &length, &header.format, binary.data());
+		header.length = (GLuint)length;
+
+#ifdef _WIN32
+		_mkdir(dir.c_str());	// 目录已存在时失败，不影响
+#else
+		mkdir(dir.c_str(), 0755);
+#endif
+		FILE* fp = openFile(path.c_str(), "wb");
+		if (fp == NULL)
 		{
-			{vShaderFile, GL_VERTEX_SHADER, NULL},
-			{fShaderFile, GL_FRAGMENT_SHADER, NULL},
-		};
+			std::cerr << "Failed to write program cache " << path << std::endl;
+			return;
+		}
+		fwrite(&header, sizeof(header), 1, fp);
+		fwrite(binary.data(), 1, header.length, fp);
+		fclose(fp);
+	}
+
+	// 一个程序从读取源码到链接完成的全部状态，编译可以在提交后由驱动或后台线程完成
+	struct ProgramBuild
+	{
+		Shader      shaders[2];
+		MappedFile  files[2];
+		GLuint      shaderIds[2] = { 0, 0 };
+		GLuint      program = 0;
+		GLuint      attribLocationsFrom = 0;	// 非 0 时链接前按此程序的属性位置绑定(重新编译时保持 VAO 有效)
+		std::string cacheDir;
+		std::string cachePath;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	// 读取源码并查程序二进制缓存，不需要再编译时返回 true：
+	// 缓存命中时 build.program 为加载好的程序，源文件读取失败时 build.program 为 0
+	static bool beginProgram(ProgramBuild& build, const char* vShaderFile, const char* fShaderFile)
+	{
+		build.shaders[0] = { vShaderFile, GL_VERTEX_SHADER, NULL, 0 };
+		build.shaders[1] = { fShaderFile, GL_FRAGMENT_SHADER, NULL, 0 };
 
 		for (int i = 0; i < 2; i++)
 		{
-			Shader& s = shaders[i];
-			s.source = readShaderSource(s.filename);
-			if (NULL == s.source)
+			Shader& s = build.shaders[i];
+			if (!loadShaderSource(s, build.files[i]))
 			{
 				std::cerr << "Failed to read " << s.filename << std::endl;
-				exit(EXIT_FAILURE);
+				unmapFile(build.files[0]);
+				build.program = 0;
+				return true;
 			}
+		}
 
-			GLuint shader = glCreateShader(s.type);
+		/* 先查程序二进制缓存，命中时不再编译 */
+		build.start = std::chrono::steady_clock::now();
+		build.cacheDir = programBinarySupported() ? programCacheDirectory() : std::string();
+		if (!build.cacheDir.empty())
+		{
+			build.cachePath = programCachePath(build.cacheDir, build.shaders, 2);
+		}
+		// 缓存的二进制中属性位置由当时的链接决定，需要保持属性位置时不加载，只在编译后更新缓存
+		if (!build.cachePath.empty() && build.attribLocationsFrom == 0)
+		{
+			GLuint compileMicroseconds;
+			build.program = loadProgramBinary(build.cachePath, compileMicroseconds);
+			if (build.program)
+			{
+				double loaded = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build.start).count();
+				printf("%s + %s: program cache hit, %.2f ms (compile + link %.2f ms, saved %.2f ms)\n",
+					vShaderFile, fShaderFile, loaded, compileMicroseconds / 1000.0, compileMicroseconds / 1000.0 - loaded);
+				unmapFile(build.files[0]);
+				unmapFile(build.files[1]);
+				return true;
+			}
+		}
+		return false;
+	}
 
-			std::cout << (const GLint*)strlen(s.source) << std::endl;
-			GLint stringLen = strlen(s.source);
-			//std::cout << s.source << std::endl;
+	// 提交编译和链接，不查询状态：查询会让驱动等待编译完成，留到 finishProgram 中进行
+	static void compileProgram(ProgramBuild& build)
+	{
+		build.program = glCreateProgram();
+		for (int i = 0; i < 2; i++)
+		{
+			Shader& s = build.shaders[i];
+			GLuint shader = glCreateShader(s.type);
 
 			// 参数1：shader对象ID,
 			// 参数2：参数3中含有的字符串个数, 
 			// 参数3：含有源码的字符串数组, 
-			// 参数4：字符串长度数组(成员为参数3中各字符串长度)，为NULL表示各字符串均以NULL结束)
-			glShaderSource(shader, 1, (const GLchar**)&s.source, NULL);
+			// 参数4：字符串长度数组(成员为参数3中各字符串长度)，源码直接指向映射的文件，不以 '\0' 结尾，必须给出长度
+			glShaderSource(shader, 1, &s.source, &s.length);
 			glCompileShader(shader); // 编译shader程序
 
+			unmapFile(build.files[i]);	// glShaderSource 已复制源码
+			glAttachShader(build.program, shader);
+			build.shaderIds[i] = shader;
+		}
+
+		if (build.attribLocationsFrom)
+		{
+			// 按原程序的属性位置绑定，已设置好的 VAO 对新程序仍然有效
+			GLint count = 0, maxLength = 0;
+			glGetProgramiv(build.attribLocationsFrom, GL_ACTIVE_ATTRIBUTES, &count);
+			glGetProgramiv(build.attribLocationsFrom, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+			std::vector<GLchar> name(maxLength + 1);
+			for (GLint i = 0; i < count; i++)
+			{
+				GLint size;
+				GLenum type;
+				glGetActiveAttrib(build.attribLocationsFrom, i, (GLsizei)name.size(), NULL, &size, &type, name.data());
+				GLint location = glGetAttribLocation(build.attribLocationsFrom, name.data());
+				if (location >= 0)
+				{
+					glBindAttribLocation(build.program, location, name.data());
+				}
+			}
+		}
+		if (!build.cacheDir.empty())
+		{
+			// 提示驱动保留可取回的二进制
+			glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glLinkProgram(build.program);	// 链接shader程序
+	}
+
+	// 检查编译和链接结果并存入程序二进制缓存；失败时输出错误信息，删除程序并返回 0(不退出，热重载时保留原程序)
+	static GLuint finishProgram(ProgramBuild& build)
+	{
+		bool failed = false;
+		for (int i = 0; i < 2; i++)
+		{
+			GLuint shader = build.shaderIds[i];
 			GLint compiled;
 			// 获取编译状态信息
 			glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
@@ -64,7 +449,7 @@ namespace Angel
 			if (!compiled)
 			{
 				// 如果编译失败
-				std::cerr << s.filename << " failed to compile:" << std::endl; // 输出错误信息
+				std::cerr << build.shaders[i].filename << " failed to compile:" << std::endl; // 输出错误信息
 				GLint logSize;
 				glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logSize); // 获取错误信息的长度
 				char* logMsg = new char[logSize];  // 根据信息长度创建buffer
@@ -78,20 +463,16 @@ namespace Angel
 
 				std::cerr << logMsg << std::endl;	// 输出错误信息
 				delete[] logMsg;
-				system("pause");
-				exit(EXIT_FAILURE);	// 退出程序
+				failed = true;
 			}
-
-			delete[] s.source;
-			glAttachShader(program, shader);
+			glDeleteShader(shader);	// 已附加到程序上，随程序一起删除
 		}
 
-		/* 链接并检查错误信息 */
-		glLinkProgram(program);	// 链接shader程序
-
+		/* 检查链接错误信息 */
+		GLuint program = build.program;
 		GLint linked;
 		glGetProgramiv(program, GL_LINK_STATUS, &linked); // 获取链接信息，参数含义和glGetShaderiv类似
-		if (!linked)
+		if (!linked && !failed)
 		{
 			// 链接失败？
 			std::cerr << "Shader program failed to link" << std::endl;
@@ -101,11 +482,611 @@ namespace Angel
 			glGetProgramInfoLog(program, logSize, NULL, logMsg);	// 获取链接信息
 			std::cerr << logMsg << std::endl;
 			delete[] logMsg;
-			system("pause");
-			exit(EXIT_FAILURE);
+		}
+		if (!linked)
+		{
+			glDeleteProgram(program);
+			return 0;
+		}
+
+		if (!build.cacheDir.empty())
+		{
+			auto compiled = std::chrono::steady_clock::now();
+			GLuint compileMicroseconds = (GLuint)std::chrono::duration_cast<std::chrono::microseconds>(compiled - build.start).count();
+			saveProgramBinary(build.cacheDir, build.cachePath, program, compileMicroseconds);
+			printf("%s + %s: compiled and linked in %.2f ms, saved to program cache\n",
+				build.shaders[0].filename, build.shaders[1].filename, compileMicroseconds / 1000.0);
 		}
 
 		return program;
 	}
 
+	// 根据顶点和片元Shader文件 创建 GLSL 程序对象，失败时输出错误信息并返回 0
+	GLuint InitShader(const char* vShaderFile, const char* fShaderFile)
+	{
+		ProgramBuild build;
+		if (!beginProgram(build, vShaderFile, fShaderFile))
+		{
+			compileProgram(build);
+			build.program = finishProgram(build);
+		}
+		if (build.program == 0)
+		{
+			exit(EXIT_FAILURE);	// 错误信息已输出，退出程序
+		}
+		return build.program;
+	}
+
+	/*异步编译*/
+	// 有 KHR_parallel_shader_compile 时由驱动的编译线程并行编译，ready() 查询 GL_COMPLETION_STATUS_KHR；
+	// 否则在 Windows 上由后台线程在共享对象的上下文中编译，链接完成后 glFinish，主上下文即可使用，
+	// 每个同时等待编译的程序一个线程和上下文(最多为 CPU 核数)，一起提交的程序并行编译；
+	// 其他平台没有该扩展时不能在后台编译：提交后由驱动自行安排(多数驱动会推迟到第一次查询状态时才编译)，
+	// ready() 无法查询，总是返回 true，get() 在主线程中等待编译完成，多个程序之间没有并行
+	struct ShaderFuture::State
+	{
+		enum Mode { Cached, Parallel, Worker, Submitted };
+
+		ProgramBuild             build;
+		Mode                     mode = Submitted;
+		bool                     finished = false;	// finishProgram 已完成，program 可用
+		bool                     exitOnFailure = true;	// 失败时退出程序，热重载时为 false
+		GLuint                   program = 0;
+
+		std::mutex               mutex;				// Worker 模式下保护 compiled
+		std::condition_variable  compiledSignal;
+		bool                     compiled = false;	// 后台线程已完成编译和链接
+	};
+
+#ifdef _WIN32
+	// 后台编译线程池：每个线程有一个与主上下文共享对象的上下文，从同一个队列中取程序编译。
+	// 上下文在主线程中创建(此时主上下文为当前上下文)，提交时所有线程都在忙就再加一个线程
+	class ShaderCompileWorkers
+	{
+		HDC _dc = NULL;
+		HGLRC _main = NULL;
+		std::vector<HGLRC> _contexts;
+		std::vector<std::thread> _threads;
+		std::mutex _mutex;
+		std::condition_variable _wake;
+		std::deque<std::shared_ptr<ShaderFuture::State>> _queue;
+		size_t _busy = 0;		// 正在编译的线程数
+		bool _stop = false;
+		bool _failed = false;	// 不能创建共享上下文，不再尝试
+
+		void run(HGLRC context)
+		{
+			wglMakeCurrent(_dc, context);
+			for (;;)
+			{
+				std::shared_ptr<ShaderFuture::State> state;
+				{
+					std::unique_lock<std::mutex> lock(_mutex);
+					_wake.wait(lock, [this] { return _stop || !_queue.empty(); });
+					if (_queue.empty())
+					{
+						break;
+					}
+					state = _queue.front();
+					_queue.pop_front();
+					_busy++;
+				}
+
+				compileProgram(state->build);
+				glFinish();	// 编译链接完成后其他上下文才能安全使用
+
+				{
+					std::lock_guard<std::mutex> lock(state->mutex);
+					state->compiled = true;
+					state->compiledSignal.notify_all();
+				}
+				std::lock_guard<std::mutex> lock(_mutex);
+				_busy--;
+			}
+			wglMakeCurrent(NULL, NULL);
+		}
+
+		// 创建与主上下文共享对象的上下文：用与主上下文相同的版本、标志和配置文件创建，
+		// 与 freeglut 用 glutInitContextVersion 等创建的上下文兼容；没有 WGL_ARB_create_context 时用旧的方法
+		HGLRC createContext()
+		{
+			if (WGLEW_ARB_create_context)
+			{
+				GLint major = 0, minor = 0, flags = 0, profile = 0;
+				glGetIntegerv(GL_MAJOR_VERSION, &major);
+				glGetIntegerv(GL_MINOR_VERSION, &minor);
+				glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+				if (major > 3 || (major == 3 && minor >= 2))
+				{
+					glGetIntegerv(GL_CONTEXT_PROFILE_MASK, &profile);	// 与 WGL_CONTEXT_*_PROFILE_BIT_ARB 的值相同
+				}
+				int wglFlags = 0;
+				if (flags & GL_CONTEXT_FLAG_FORWARD_COMPATIBLE_BIT)
+				{
+					wglFlags |= WGL_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB;
+				}
+				if (flags & GL_CONTEXT_FLAG_DEBUG_BIT)
+				{
+					wglFlags |= WGL_CONTEXT_DEBUG_BIT_ARB;
+				}
+				int attribs[] =
+				{
+					WGL_CONTEXT_MAJOR_VERSION_ARB, major,
+					WGL_CONTEXT_MINOR_VERSION_ARB, minor,
+					WGL_CONTEXT_FLAGS_ARB, wglFlags,
+					profile ? WGL_CONTEXT_PROFILE_MASK_ARB : 0, profile,
+					0
+				};
+				return wglCreateContextAttribsARB(_dc, _main, attribs);	// 创建时即共享对象
+			}
+
+			HGLRC context = wglCreateContext(_dc);
+			if (context && !wglShareLists(_main, context))
+			{
+				wglDeleteContext(context);
+				context = NULL;
+			}
+			return context;
+		}
+
+		// 加一个线程和它的上下文，失败时返回 false
+		bool addWorker()
+		{
+			if (_contexts.empty())
+			{
+				_dc = wglGetCurrentDC();
+				_main = wglGetCurrentContext();
+			}
+			HGLRC context = _main ? createContext() : NULL;
+			if (context == NULL)
+			{
+				return false;
+			}
+			_contexts.push_back(context);
+			_threads.emplace_back(&ShaderCompileWorkers::run, this, context);
+			return true;
+		}
+
+	public:
+		~ShaderCompileWorkers()
+		{
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_stop = true;
+			}
+			_wake.notify_all();
+			for (std::thread& thread : _threads)
+			{
+				thread.join();
+			}
+			for (HGLRC context : _contexts)
+			{
+				wglDeleteContext(context);
+			}
+		}
+
+		// 交给后台线程编译，不能创建共享上下文时返回 false
+		bool submit(const std::shared_ptr<ShaderFuture::State>& state)
+		{
+			if (_failed)
+			{
+				return false;
+			}
+			std::unique_lock<std::mutex> lock(_mutex);
+			size_t maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+			if (_busy + _queue.size() >= _threads.size() && _threads.size() < maxWorkers)
+			{
+				lock.unlock();
+				if (!addWorker() && _threads.empty())
+				{
+					_failed = true;
+					return false;
+				}
+				lock.lock();
+			}
+			_queue.push_back(state);
+			lock.unlock();
+			_wake.notify_one();
+			return true;
+		}
+	};
+
+	static ShaderCompileWorkers compileWorkers;
+#endif
+
+	// 提交编译后立即返回，所有程序一起提交时并行编译
+	ShaderFuture InitShaderAsync(const char* vShaderFile, const char* fShaderFile, GLuint attribLocationsFrom)
+	{
+		static bool parallel = false;
+		static bool checked = false;
+		if (!checked)
+		{
+			checked = true;
+			parallel = GLEW_KHR_parallel_shader_compile != 0;
+			if (parallel)
+			{
+				glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);	// 由驱动决定编译线程数
+			}
+		}
+
+		ShaderFuture future;
+		future._state = std::make_shared<ShaderFuture::State>();
+		ShaderFuture::State& state = *future._state;
+		state.build.attribLocationsFrom = attribLocationsFrom;
+		state.exitOnFailure = attribLocationsFrom == 0;
+		if (beginProgram(state.build, vShaderFile, fShaderFile))
+		{
+			state.mode = ShaderFuture::State::Cached;
+			state.program = state.build.program;
+			state.finished = true;
+			return future;
+		}
+
+		if (parallel)
+		{
+			state.mode = ShaderFuture::State::Parallel;
+			compileProgram(state.build);
+			return future;
+		}
+#ifdef _WIN32
+		state.mode = ShaderFuture::State::Worker;
+		if (compileWorkers.submit(future._state))
+		{
+			return future;
+		}
+#endif
+		state.mode = ShaderFuture::State::Submitted;
+		compileProgram(state.build);
+		return future;
+	}
+
+	bool ShaderFuture::ready() const
+	{
+		if (!_state || _state->finished)
+		{
+			return true;
+		}
+		switch (_state->mode)
+		{
+		case State::Parallel:
+		{
+			GLint completed = GL_FALSE;
+			glGetProgramiv(_state->build.program, GL_COMPLETION_STATUS_KHR, &completed);
+			return completed == GL_TRUE;
+		}
+		case State::Worker:
+		{
+			std::lock_guard<std::mutex> lock(_state->mutex);
+			return _state->compiled;
+		}
+		default:
+			return true;
+		}
+	}
+
+	GLuint ShaderFuture::get()
+	{
+		if (!_state)
+		{
+			return 0;
+		}
+		if (!_state->finished)
+		{
+			if (_state->mode == State::Worker)
+			{
+				std::unique_lock<std::mutex> lock(_state->mutex);
+				_state->compiledSignal.wait(lock, [this] { return _state->compiled; });
+			}
+			_state->program = finishProgram(_state->build);
+			_state->finished = true;
+		}
+		if (_state->program == 0 && _state->exitOnFailure)
+		{
+			exit(EXIT_FAILURE);	// 错误信息已输出，退出程序
+		}
+		return _state->program;
+	}
+
+	/*热重载*/
+	// WatchShader 登记的程序在源文件修改后用 InitShaderAsync 在后台重新编译(属性位置与原程序相同)，
+	// 由 GLUT 定时器每 ShaderReloadInterval 毫秒检查一次：编译成功时把原程序中 uniform 变量的值复制过去，
+	// 替换程序变量、重新获取 WatchUniform 登记的位置后删除原程序；失败时输出错误信息并保留原程序
+	// (重新编译时 attribLocationsFrom 非 0，失败不退出程序)。
+	// Linux 上用 inotify 监视源文件所在目录，其他平台比较文件的修改时间
+	const unsigned ShaderReloadInterval = 200;
+
+	struct WatchedFile
+	{
+		std::string  directory;		// 所在目录，空串表示工作目录
+		std::string  name;
+		long long    modified = 0;	// 修改时间(不使用 inotify 时)，Windows 上以 100 ns 为单位，其他平台以 ns 为单位
+	};
+
+	struct WatchedProgram
+	{
+		GLuint*       program;
+		std::string   shaderFiles[2];	// 传给 InitShader 的文件名
+		WatchedFile   files[2];
+		std::vector<std::pair<GLuint*, std::string>> uniforms;
+		bool          changed = false;
+		bool          compiling = false;
+		ShaderFuture  pending;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	static std::list<WatchedProgram> watchedPrograms;
+
+	static WatchedFile watchedFile(const std::string& path)
+	{
+		WatchedFile file;
+		size_t slash = path.find_last_of("/\\");
+		if (slash != std::string::npos)
+		{
+			file.directory = path.substr(0, slash);
+		}
+		file.name = slash == std::string::npos ? path : path.substr(slash + 1);
+		return file;
+	}
+
+#ifdef __linux__
+	static int inotifyFd = -1;
+	static std::map<int, std::string> inotifyDirectories;	// 监视描述符 -> 目录
+
+	static void watchDirectory(const std::string& directory)
+	{
+		if (inotifyFd < 0)
+		{
+			inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		}
+		// 编辑器保存时可能先写临时文件再改名，所以同时监视写入关闭和移入
+		int wd = inotify_add_watch(inotifyFd, directory.empty() ? "." : directory.c_str(),
+			IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (wd >= 0)
+		{
+			inotifyDirectories[wd] = directory;
+		}
+	}
+
+	// 读出所有未处理的事件，标记受影响的程序
+	static void pollFileChanges()
+	{
+		if (inotifyFd < 0)
+		{
+			return;
+		}
+		alignas(inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* p = buffer; p < buffer + length; )
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+				p += sizeof(inotify_event) + event->len;
+				if (event->len == 0)
+				{
+					continue;
+				}
+				const std::string& directory = inotifyDirectories[event->wd];
+				for (WatchedProgram& watched : watchedPrograms)
+				{
+					for (const WatchedFile& file : watched.files)
+					{
+						if (file.directory == directory && file.name == event->name)
+						{
+							watched.changed = true;
+						}
+					}
+				}
+			}
+		}
+	}
+#else
+	// 文件的修改时间，取不到时返回 0。st_mtime 只精确到秒，同一秒内的两次保存会漏掉第二次，所以用更精确的时间
+	static long long fileModifiedTime(const WatchedFile& file)
+	{
+		std::string path = file.directory.empty() ? file.name : file.directory + "/" + file.name;
+#ifdef _WIN32
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data))
+		{
+			return 0;
+		}
+		return (long long)data.ftLastWriteTime.dwHighDateTime << 32 | data.ftLastWriteTime.dwLowDateTime;
+#else
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0)
+		{
+			return 0;
+		}
+#  ifdef __APPLE__
+		return (long long)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#  else
+		return (long long)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#  endif
+#endif
+	}
+
+	static void watchDirectory(const std::string&)
+	{
+	}
+
+	static void pollFileChanges()
+	{
+		for (WatchedProgram& watched : watchedPrograms)
+		{
+			for (WatchedFile& file : watched.files)
+			{
+				long long modified = fileModifiedTime(file);
+				if (modified != file.modified)
+				{
+					file.modified = modified;
+					watched.changed = true;
+				}
+			}
+		}
+	}
+#endif
+
+	// 把 from 中所有 uniform 变量的当前值复制到 to 中同名的变量(to 必须是当前程序)
+	static void copyUniforms(GLuint from, GLuint to)
+	{
+		GLint count = 0, maxLength = 0;
+		glGetProgramiv(from, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(from, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+		std::vector<GLchar> name(maxLength + 16);
+		for (GLint i = 0; i < count; i++)
+		{
+			GLint size;
+			GLenum type;
+			glGetActiveUniform(from, i, (GLsizei)name.size(), NULL, &size, &type, name.data());
+
+			// 数组名以 "[0]" 结尾，逐个元素按 "name[k]" 复制
+			std::string base = name.data();
+			if (size > 1 && base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+			{
+				base.resize(base.size() - 3);
+			}
+			for (GLint k = 0; k < size; k++)
+			{
+				std::string element = size > 1 ? base + "[" + std::to_string(k) + "]" : base;
+				GLint src = glGetUniformLocation(from, element.c_str());
+				GLint dst = glGetUniformLocation(to, element.c_str());
+				if (src < 0 || dst < 0)
+				{
+					continue;
+				}
+
+				GLfloat f[16];
+				GLint n[4];
+				switch (type)
+				{
+				case GL_FLOAT: glGetUniformfv(from, src, f); glUniform1fv(dst, 1, f); break;
+				case GL_FLOAT_VEC2: glGetUniformfv(from, src, f); glUniform2fv(dst, 1, f); break;
+				case GL_FLOAT_VEC3: glGetUniformfv(from, src, f); glUniform3fv(dst, 1, f); break;
+				case GL_FLOAT_VEC4: glGetUniformfv(from, src, f); glUniform4fv(dst, 1, f); break;
+				case GL_FLOAT_MAT2: glGetUniformfv(from, src, f); glUniformMatrix2fv(dst, 1, GL_FALSE, f); break;
+				case GL_FLOAT_MAT3: glGetUniformfv(from, src, f); glUniformMatrix3fv(dst, 1, GL_FALSE, f); break;
+				case GL_FLOAT_MAT4: glGetUniformfv(from, src, f); glUniformMatrix4fv(dst, 1, GL_FALSE, f); break;
+				case GL_INT_VEC2: case GL_BOOL_VEC2: glGetUniformiv(from, src, n); glUniform2iv(dst, 1, n); break;
+				case GL_INT_VEC3: case GL_BOOL_VEC3: glGetUniformiv(from, src, n); glUniform3iv(dst, 1, n); break;
+				case GL_INT_VEC4: case GL_BOOL_VEC4: glGetUniformiv(from, src, n); glUniform4iv(dst, 1, n); break;
+				default:
+					// int、bool、unsigned int 与各种采样器都按一个整数复制，其余类型不复制
+					if (type == GL_INT || type == GL_BOOL || type == GL_UNSIGNED_INT ||
+						type == GL_SAMPLER_1D || type == GL_SAMPLER_2D || type == GL_SAMPLER_3D ||
+						type == GL_SAMPLER_CUBE || type == GL_SAMPLER_BUFFER || type == GL_INT_SAMPLER_BUFFER ||
+						type == GL_UNSIGNED_INT_SAMPLER_BUFFER || type == GL_SAMPLER_2D_RECT)
+					{
+						glGetUniformiv(from, src, n);
+						glUniform1iv(dst, 1, n);
+					}
+					break;
+				}
+			}
+		}
+	}
+
+	// 编译成功后替换程序：复制 uniform 值、重新获取登记的位置，删除原程序
+	static void swapProgram(WatchedProgram& watched, GLuint program)
+	{
+		GLuint old = *watched.program;
+		GLint current = 0;
+		glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+
+		glUseProgram(program);
+		if (old)
+		{
+			copyUniforms(old, program);
+		}
+		*watched.program = program;
+		for (auto& uniform : watched.uniforms)
+		{
+			*uniform.first = glGetUniformLocation(program, uniform.second.c_str());
+		}
+		glUseProgram((GLuint)current == old ? program : (GLuint)current);
+		if (old)
+		{
+			glDeleteProgram(old);
+		}
+	}
+
+	static void pollShaderReload(int)
+	{
+		pollFileChanges();
+
+		for (WatchedProgram& watched : watchedPrograms)
+		{
+			if (watched.compiling && watched.pending.ready())
+			{
+				watched.compiling = false;
+				GLuint program = watched.pending.get();
+				double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - watched.start).count();
+				if (program)
+				{
+					swapProgram(watched, program);
+					printf("%s + %s: reloaded in %.2f ms\n", watched.shaderFiles[0].c_str(), watched.shaderFiles[1].c_str(), ms);
+					glutPostRedisplay();
+				}
+				else
+				{
+					printf("%s + %s: reload failed, keeping the previous program\n",
+						watched.shaderFiles[0].c_str(), watched.shaderFiles[1].c_str());
+				}
+			}
+
+			// 编译期间又有修改时，等这次编译结束后再编译一次
+			if (watched.changed && !watched.compiling)
+			{
+				watched.changed = false;
+				watched.compiling = true;
+				watched.start = std::chrono::steady_clock::now();
+				watched.pending = InitShaderAsync(watched.shaderFiles[0].c_str(), watched.shaderFiles[1].c_str(), *watched.program);
+			}
+		}
+
+		glutTimerFunc(ShaderReloadInterval, pollShaderReload, 0);
+	}
+
+	void WatchShader(GLuint& program, const char* vShaderFile, const char* fShaderFile)
+	{
+#ifdef ANGEL_EMBED_SHADERS
+		// 嵌入的 shader 没有源文件可以监视
+		(void)program;
+		(void)vShaderFile;
+		(void)fShaderFile;
+#else
+		if (watchedPrograms.empty())
+		{
+			glutTimerFunc(ShaderReloadInterval, pollShaderReload, 0);
+		}
+
+		watchedPrograms.emplace_back();
+		WatchedProgram& watched = watchedPrograms.back();
+		watched.program = &program;
+		const char* shaderFiles[2] = { vShaderFile, fShaderFile };
+		for (int i = 0; i < 2; i++)
+		{
+			watched.shaderFiles[i] = shaderFiles[i];
+			std::string path = resolveShaderPath(shaderFiles[i]);
+			watched.files[i] = watchedFile(path.empty() ? shaderFiles[i] : path);
+			watchDirectory(watched.files[i].directory);
+#ifndef __linux__
+			watched.files[i].modified = fileModifiedTime(watched.files[i]);	// 记下当前的修改时间
+#endif
+		}
+#endif
+	}
+
+	void WatchUniform(GLuint& program, const char* name, GLuint& location)
+	{
+		location = glGetUniformLocation(program, name);
+		for (WatchedProgram& watched : watchedPrograms)
+		{
+			if (watched.program == &program)
+			{
+				watched.uniforms.emplace_back(&location, name);
+			}
+		}
+	}
+
 }
\ No newline at end of file
@@ -4,147 +4,218 @@
 //		Use, modificationand distribution are subject to the "MIT License"
 //------------------------------------------------------------------------------
 
+//------------------------------------------------------------------------------
+//	Sierpinski 四面体
+//	使用说明：
+//	命令行参数为初始的细分次数(默认 4)，如 Sierpinski.exe 9
+//	按 + / - 键 增加/减少细分次数
+//	按 I 键 切换索引绘制 / 实例化绘制
+//	每次细分后在控制台输出顶点数、内存占用和生成时间
+//	按 ESC 键 退出
+//------------------------------------------------------------------------------
+
 #include "Angel.h"
+#include <chrono>
 
 typedef vec3 point3;
-typedef vec3 color3;
 
-const int NumTimesToSubdivide = 4; // 迭代次数
-const int NumTetrahedrons = 256; // 生成四面体个数 4^4
-const int NumTriangles = 4 * NumTetrahedrons; // 产生三角形个数 每个四面体 4 个三角形
-const int NumVertices = 3 * NumTriangles; // 顶点数
+const int MaxTimesToSubdivide = 11; // 最大细分次数：4^11 个四面体，索引约 200 MB
 
-point3 points[NumVertices]; // 顶点位置数组
-color3 colors[NumVertices]; // 顶点颜色数组
+int NumTimesToSubdivide = 4; // 细分次数
 
-// 将三角形顶点坐标 和 颜色 加入数组中
-void Triangle(point3 a, point3 b, point3 c, int colorIndex)
+// 初始四面体(编译期常量)
+constexpr point3 vertices[4] =
 {
-	static color3 base_color[] =
+	point3(0.0, 0.0, -1.0),
+	point3(0.0, 0.942809, 0.333333),
+	point3(-0.816497, -0.471405, 0.333333),
+	point3(0.816497, -0.471405, 0.333333)
+};
+
+// 四个面的颜色
+constexpr point3 base_color[] =
+{
+	point3(1.0, 0.0, 0.0),
+	point3(0.0, 1.0, 0.0),
+	point3(0.0, 0.0, 1.0),
+	point3(0.0, 0.0, 0.0),
+};
+
+bool bInstanced = false; // 使用实例化绘制
+
+// 索引绘制：相邻的小四面体共用顶点，位置按 snorm16x4 上传(8 字节)，每个三角形 3 个索引
+// 索引按四面体的四个面分为四段，每段用一种颜色(常量顶点属性)绘制
+GLuint vao;
+GLuint program;
+MeshBuffers sierpinski;
+
+GLuint vPosition; // shader 中 in 变量 vPosition 的索引
+GLuint vColor; // shader 中 in 变量 vColor 的索引
+
+// 实例化绘制：所有小四面体形状相同，只上传一个(12 个顶点，格点坐标 + 颜色)，
+// 每个小四面体为一个实例，其格点原点存放在纹理缓冲区中(RGBA16UI，8 字节)，shader 中按 gl_InstanceID 读取
+// OpenGL 3.1 没有 glVertexAttribDivisor，用纹理缓冲区代替每实例的顶点属性
+GLuint vaoInstanced;
+GLuint programInstanced;
+GLuint tetraBuffer;	// 小四面体的 12 个顶点(格点坐标 + 颜色)
+GLuint offsetBuffer;
+GLuint offsetTexture;
+GLsizei numInstances;
+GLuint Lattice; // shader 中 uniform 变量 Lattice 的索引
+
+// 生成细分 deep 次的 Sierpinski 四面体并上传，替换原来的缓冲区
+void DivideTetra(int deep)
+{
+	// 生成器直接写入映射的顶点/索引缓冲区，生成和上传合为一步
+	auto start = std::chrono::steady_clock::now();
+	SierpinskiGenerator generator = { { vertices[0], vertices[1], vertices[2], vertices[3] }, deep };
+	sierpinski.release();
+	sierpinski = EmitMesh(generator);
+	if (program)
 	{
-		color3(1.0, 0.0, 0.0),
-		color3(0.0, 1.0, 0.0),
-		color3(0.0, 0.0, 1.0),
-		color3(0.0, 0.0, 0.0),
-	};
-
-	static int index = 0;
-
-	points[index] = a;
-	colors[index] = base_color[colorIndex];
-	index++;
-
-	points[index] = b;
-	colors[index] = base_color[colorIndex];
-	index++;
-
-	points[index] = c;
-	colors[index] = base_color[colorIndex];
-	index++;
-
+		// 缓冲区换了，重建 VAO；初始化时 shader 还在编译，由 Init 在取得程序后创建
+		glDeleteVertexArrays(1, &vao);
+		vao = sierpinski.vertexArray(vPosition);
+	}
+	glFinish();
+	auto emitted = std::chrono::steady_clock::now();
+
+	// 原来展开为三角形时每个顶点 24 字节(point3 位置 + color3 颜色，都是 vec3)
+	size_t tetrahedra = (size_t)1 << (2 * deep);
+	size_t soupBytes = tetrahedra * 12 * (sizeof(point3) + sizeof(point3));
+	printf("depth %2d: %9zu tetrahedra, %9zu vertices, %10zu indices, "
+		"GPU %8.2f MB (triangle soup %8.2f MB), build + upload %8.2f ms\n",
+		deep, tetrahedra, (size_t)sierpinski.vertexCount, (size_t)sierpinski.indexCount,
+		sierpinski.bytes / 1048576.0, soupBytes / 1048576.0,
+		std::chrono::duration<double, std::milli>(emitted - start).count());
 }
 
-// 生成一个四面体
-void Tetra(point3 a, point3 b, point3 c, point3 d)
+// 生成细分 deep 次后每个小四面体的格点原点并上传到纹理缓冲区
+void InstanceTetra(int deep)
 {
-	Triangle(a, b, c, 0);
-	Triangle(a, c, d, 1);
-	Triangle(a, d, b, 2);
-	Triangle(b, d, c, 3);
-}
+	// 纹理缓冲区的大小有上限(OpenGL 3.1 只保证 65536 个)，放不下时只能用索引绘制
+	GLint maxTexels;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	size_t tetrahedra = (size_t)1 << (2 * deep);
+	if (tetrahedra > (size_t)maxTexels)
+	{
+		printf("depth %2d: %zu instances exceed GL_MAX_TEXTURE_BUFFER_SIZE (%d), instanced mode disabled\n",
+			deep, tetrahedra, maxTexels);
+		numInstances = 0;
+		return;
+	}
 
-// deep 迭代次数
-void DivideTetra(point3 a, point3 b, point3 c, point3 d, int deep)
-{
-	if (deep > 0)
+	// 格点原点直接写入映射的纹理缓冲区；解除映射时内容丢失则重写，
+	// 映射失败或重试 MapBufferRetries 次仍失败时改用 BufferData 上传
+	auto start = std::chrono::steady_clock::now();
+	size_t bytes = 4 * tetrahedra * sizeof(GLushort);
+	glBindBuffer(GL_TEXTURE_BUFFER, offsetBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, bytes, NULL, GL_STATIC_DRAW);
+	bool written = false;
+	for (int attempt = 0; attempt < MapBufferRetries && !written; attempt++)
 	{
-		point3 mid[6];
-
-		mid[0] = (a + b) / 2.0;
-		mid[1] = (a + c) / 2.0;
-		mid[2] = (a + d) / 2.0;
-		mid[3] = (b + c) / 2.0;
-		mid[4] = (c + d) / 2.0;
-		mid[5] = (b + d) / 2.0;
-
-		DivideTetra(a, mid[0], mid[1], mid[2], deep - 1);
-		DivideTetra(mid[0], b, mid[3], mid[5], deep - 1);
-		DivideTetra(mid[1], mid[3], c, mid[4], deep - 1);
-		DivideTetra(mid[2], mid[5], mid[4], d, deep - 1);
+		span<GLushort> offsets = MapBufferRange<GLushort>(GL_TEXTURE_BUFFER, 0, 4 * tetrahedra,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (offsets.empty())
+		{
+			break;
+		}
+		EmitSierpinskiOffsets(deep, offsets);
+		written = glUnmapBuffer(GL_TEXTURE_BUFFER) == GL_TRUE;
 	}
-	else
+	if (!written)
 	{
-		// 记录最终的数据
-		Tetra(a, b, c, d);
+		BufferData(GL_TEXTURE_BUFFER, make_span(BuildSierpinskiOffsets(deep)), GL_STATIC_DRAW);
 	}
+	glFinish();
+	auto emitted = std::chrono::steady_clock::now();
+	numInstances = (GLsizei)tetrahedra;
+
+	printf("depth %2d: %9zu instances, GPU %8.2f MB, build + upload %8.2f ms\n",
+		deep, tetrahedra, bytes / 1048576.0,
+		std::chrono::duration<double, std::milli>(emitted - start).count());
 }
 
-void Init()
+// 细分次数改变时重新生成两种绘制方式的数据
+void Subdivide(int deep)
 {
-	// 初始四面体
-	point3 vertices[4] =
-	{
-		point3(0.0, 0.0, -1.0),
-		point3(0.0, 0.942809, 0.333333),
-		point3(-0.816497, -0.471405, 0.333333),
-		point3(0.816497, -0.471405, 0.333333)
-	};
-
-	// 细分
-	DivideTetra(vertices[0], vertices[1], vertices[2], vertices[3], NumTimesToSubdivide);
-
-	// 创建一个顶点数组对象 VAO vertex_array_object
-	GLuint vao;
-	glGenVertexArrays(1, &vao); // 生成一个未用的 VAO ID，存于 vao 中
-	glBindVertexArray(vao);		// 创建 id 为 vao 的 VAO，并绑定为当前 VAO
-
-	// 创建并初始化一个缓冲区对象（Buffer Object）
-	GLuint buffer;
-	glGenBuffers(1, &buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, buffer); // 创建 id 为 buffer 的 Array Buffer 对象，并绑定为单前 Array Buffer 对象
+	DivideTetra(deep);
+	InstanceTetra(deep);
+}
 
-	// 为 Buffer 对象在 GPU 端申请空间，并提供数据
-	glBufferData(GL_ARRAY_BUFFER,	// Buffer 类型
-		sizeof(points) + sizeof(colors), // 申请空间大小（以字节为单位）位置 + 颜色
-		NULL,					//  数据指针
-		GL_STATIC_DRAW);			// 表明将如何使用 Buffer 的标志（GL_STATIC_DRAW ：一次提供数据，多次绘制）
+// 实例化绘制的小四面体和纹理缓冲区，不需要 shader，可以在 shader 编译期间进行
+void InitInstancedBuffers()
+{
+	// 小四面体四个角的格点坐标 a(0,0,0) b(1,0,0) c(0,1,0) d(0,0,1)，按面 (a,b,c)(a,c,d)(a,d,b)(b,d,c) 展开
+	const unorm8x4 a(0, 0, 0), b(1, 0, 0), c(0, 1, 0), d(0, 0, 1);
+	const unorm8x4 corners[12] = { a, b, c, a, c, d, a, d, b, b, d, c };
+	unorm8x4 colors[12];
+	for (int i = 0; i < 12; i++)
+	{
+		colors[i] = unorm8x4(base_color[i / 3]);
+	}
 
+	glGenBuffers(1, &tetraBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, tetraBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corners) + sizeof(colors), NULL, GL_STATIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(corners), corners);
+	glBufferSubData(GL_ARRAY_BUFFER, sizeof(corners), sizeof(colors), colors);
+
+	// 纹理缓冲区，每个纹素为一个实例的格点原点
+	glGenBuffers(1, &offsetBuffer);
+	glGenTextures(1, &offsetTexture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_BUFFER, offsetTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA16UI, offsetBuffer);
+}
 
-	// 存入顶点数据
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(points), points);
+// 实例化绘制的 shader 和 VAO
+void InitInstanced(ShaderFuture& shader)
+{
+	programInstanced = shader.get();
+	glUseProgram(programInstanced);
+
+	// 格点 (i, j, k) 的坐标为 a + i * (b - a) / 2^n + ...，n 为细分次数；
+	// 实例的格点原点按 2^n 分之一为单位，所以 Lattice 每次细分都要更新，见 Display
+	glUniform3fv(glGetUniformLocation(programInstanced, "Origin"), 1, vertices[0]);
+	glUniform1i(glGetUniformLocation(programInstanced, "Offsets"), 0);
+	Lattice = glGetUniformLocation(programInstanced, "Lattice");
+
+	glGenVertexArrays(1, &vaoInstanced);
+	glBindVertexArray(vaoInstanced);
+	glBindBuffer(GL_ARRAY_BUFFER, tetraBuffer);
+
+	GLuint loc = glGetAttribLocation(programInstanced, "vPosition");
+	glEnableVertexAttribArray(loc);
+	VertexAttribPointer<unorm8x4>(loc, 0, 0);
+
+	GLuint color = glGetAttribLocation(programInstanced, "vColor");
+	glEnableVertexAttribArray(color);
+	VertexAttribPointer<unorm8x4>(color, 0, 12 * sizeof(unorm8x4));
+}
 
-	// 存入颜色数据
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(points), sizeof(colors), colors);
+void Init()
+{
+	// 初始化 shader：两个程序一起提交并行编译，使用前再取得结果
+	ShaderFuture shader = InitShaderAsync("vSierpinski.glsl", "fSierpinski.glsl");
+	ShaderFuture shaderInstanced = InitShaderAsync("vSierpinskiInstanced.glsl", "fSierpinski.glsl");
 
+	// 编译期间细分并上传顶点和索引，以及实例的格点原点
+	InitInstancedBuffers();
+	Subdivide(NumTimesToSubdivide);
 
-	// 初始化 shader
-	GLuint program = InitShader("vSierpinski.glsl", "fSierpinski.glsl");
+	program = shader.get();
 	glUseProgram(program);
 
 	// 获取 shader 程序中变量地址
-	GLuint loc = glGetAttribLocation(program, "vPosition");
-	glEnableVertexAttribArray(loc); // 启用顶点属性数组
-
-	// 为顶点属性数组提供数据（数据存放在之前 buffer 对象中）
-	glVertexAttribPointer(
-		loc,		// 属性变量索引
-		3,			// 每个顶点属性的分量个数
-		GL_FLOAT,	// 数组数据类型
-		GL_FALSE,	// 是否进行归一化
-		0,			// 在数组中相邻属性成员间的间隔（以字节为单位）
-		BUFFER_OFFSET(0)); // 第一个属性值在 buffer 中的偏移量
-
-	// 颜色
-	GLuint vColor = glGetAttribLocation(program, "vColor");
-	glEnableVertexAttribArray(vColor);
-
-	glVertexAttribPointer(
-		vColor,		// 属性变量索引
-		3,			// 每个顶点属性的分量个数
-		GL_FLOAT,	// 数组数据类型
-		GL_FALSE,	// 是否进行归一化
-		0,			// 在数组中相邻属性成员间的间隔（以字节为单位）
-		BUFFER_OFFSET(sizeof(points))); // 第一个属性值在 buffer 中的偏移量
+	vPosition = glGetAttribLocation(program, "vPosition");
+	// 颜色不使用顶点数组，绘制每个面之前用 glVertexAttrib3f 设置
+	vColor = glGetAttribLocation(program, "vColor");
+
+	// 创建顶点数组对象 VAO，设置位置属性并绑定索引缓冲区
+	vao = sierpinski.vertexArray(vPosition);
+
+	InitInstanced(shaderInstanced);
 
 	glEnable(GL_DEPTH_TEST); // 启用深度检测
 
@@ -157,15 +228,78 @@ void Display()
 	// 将帧缓存的深度值刷新为初始深度值
 	glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
 
-	glDrawArrays(GL_TRIANGLES, 0, NumVertices);
+	if (bInstanced && numInstances > 0)
+	{
+		// 一次绘制所有小四面体
+		GLfloat size = (GLfloat)(1 << NumTimesToSubdivide);
+		mat3 lattice = transpose(mat3(
+			(vertices[1] - vertices[0]) / size,
+			(vertices[2] - vertices[0]) / size,
+			(vertices[3] - vertices[0]) / size));
+
+		glUseProgram(programInstanced);
+		glUniformMatrix3fv(Lattice, 1, GL_TRUE, lattice);
+		glBindVertexArray(vaoInstanced);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 12, numInstances);
+
+		glFlush();
+		return;
+	}
+
+	glUseProgram(program);
+	glBindVertexArray(vao);
+	GLsizei faceLength = sierpinski.indexCount / 4;
+	for (int face = 0; face < 4; face++)
+	{
+		glVertexAttrib3fv(vColor, base_color[face]);
+		sierpinski.draw(face * faceLength, faceLength);
+	}
 
 	glFlush();
 }
 
+void Keyboard(unsigned char key, int x, int y)
+{
+	switch (key)
+	{
+	case '+':
+	case '=':
+		if (NumTimesToSubdivide < MaxTimesToSubdivide)
+		{
+			Subdivide(++NumTimesToSubdivide);
+		}
+		break;
+	case '-':
+	case '_':
+		if (NumTimesToSubdivide > 0)
+		{
+			Subdivide(--NumTimesToSubdivide);
+		}
+		break;
+	case 'i':
+	case 'I':
+		bInstanced = !bInstanced;
+		printf("%s\n", bInstanced ? "instanced" : "indexed");
+		break;
+	case 27:	// Esc键
+		exit(EXIT_SUCCESS);
+		break;
+	default:
+		break;
+	}
+
+	glutPostRedisplay();
+}
+
 int main(int argc, char** argv)
 {
 	glutInit(&argc, argv);
 
+	if (argc > 1)
+	{
+		NumTimesToSubdivide = std::min(std::max(atoi(argv[1]), 0), MaxTimesToSubdivide);
+	}
+
 	// 以下窗口初始化 属性 和 上下文（Context）的函数必须在 glutCreateWindow 前调用
 	glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB);
 	glutInitWindowSize(500, 500);
@@ -196,6 +330,7 @@ int main(int argc, char** argv)
 
 	// 注册显示回调函数 必须有
 	glutDisplayFunc(Display);
+	glutKeyboardFunc(Keyboard);
 
 	glutMainLoop();
 
@@ -0,0 +1,18 @@
+﻿#version 140
+
+// 实例化绘制 Sierpinski 四面体：所有小四面体形状相同，只是位置不同
+// 顶点位置为小四面体顶点的格点坐标(0 或 1)，加上实例的格点原点后换算为坐标
+in vec4 vPosition; // 小四面体顶点的格点坐标
+in vec3 vColor; // 顶点颜色属性
+out vec4 color; // 输出颜色
+
+uniform usamplerBuffer Offsets; // 每个实例(小四面体)的格点原点，按 gl_InstanceID 读取
+uniform vec3 Origin; // 格点 (0, 0, 0) 的坐标，即初始四面体的顶点 a
+uniform mat3 Lattice; // 三列分别为格点坐标 i、j、k 加 1 时坐标的增量
+
+void main()
+{
+	vec3 lattice = vec3(texelFetch(Offsets, gl_InstanceID).xyz) + vPosition.xyz;
+	gl_Position = vec4(Origin + Lattice * lattice, 1.0);
+	color = vec4(vColor, 1.0);
+}
\ No newline at end of file
@@ -12,7 +12,7 @@
 //	按 "s" 键单步执行动画
 //	按 "t" 键切换透视和俯视图
 //	方向键 上下箭头 用于控制动画中每一帧的时间间隔,每次按键时间间隔乘2或除2
-//	按ESC键退出
+//	按ESC键退出，退出时输出 glUniform* 调用和跳过的次数
 //------------------------------------------------------------------------------
 
 #include "Angel.h"
@@ -35,118 +35,18 @@ float AnimateIncrement = 24.0;  // 动画步长变量，表示时间间隔, 以
 float ErothAxialAngle = -23.44; // 地球轴与 Y 轴夹角
 float ViewAngle = 15.0; // 观察角度
 
-MatrixStack mvStack;  // 模视矩阵栈
 mat4 proj;	// 投影矩阵
 
-GLuint MVPMatrix;	// Shader中uniform变量"MVPMatrix"的索引
-GLuint uColor;		// Shader中uniform变量"uColor"的索引
+// 球和环的南北极在z轴方向，绕x轴旋转90度使其沿y轴；常量在编译期求值
+constexpr quat quatRotateX90 = QuatRotateX(90.0);
 
-GLsizei NumVertices;	// 一个球的顶点数
-point3* sphere;			// 存放一个球的顶点坐标数据的指针
+Program program;	// shader程序，设置 uniform 时值没有变化就不调用 glUniform*
 
-GLsizei NumRing = 72; // 一个环的顶点数
-point3* ring; // 存放一个环的顶点数
+Program::Uniform MVPMatrix;	// Shader中uniform变量"MVPMatrix"的句柄
+Program::Uniform uColor;	// Shader中uniform变量"uColor"的句柄，相邻物体颜色相同时跳过
 
-// 用于生成一个中心在原点的球的顶点坐标数据(南北极在z轴方向)
-// 返回值为球的顶点数，参数为球的半径及经线和纬线数
-GLsizei BuildSphere(GLfloat radius, GLsizei columns, GLsizei rows)
-{
-	int index = 0;	// 数组索引
-	point3* vertices = new point3[(rows + 1) * (columns + 1)]; // 存放不同顶点的数组
-
-	for (int r = 0; r <= rows; r++)
-	{
-		float v = (float)r / (float)rows;  // [0,1]
-		float theta1 = v * (float)M_PI;	   // [0,PI]
-
-		point3 temp(0, 0, 1);
-		point3 n = temp;
-		GLfloat cosTheta1 = cos(theta1);
-		GLfloat sinTheta1 = sin(theta1);
-		n.x = temp.x * cosTheta1 + temp.z * sinTheta1;
-		n.z = -temp.x * sinTheta1 + temp.z * cosTheta1;
-
-		for (int c = 0; c <= columns; c++)
-		{
-			float u = (float)c / (float)columns; // [0,1]
-			float theta2 = u * (float)(M_PI * 2); // [0,2PI]
-			point3 pos = n;
-			temp = n;
-			GLfloat cosTheta2 = cos(theta2);
-			GLfloat sinTheta2 = sin(theta2);
-
-			pos.x = temp.x * cosTheta2 - temp.y * sinTheta2;
-			pos.y = temp.x * sinTheta2 + temp.y * cosTheta2;
-
-			point3 posFull = pos;
-			posFull *= radius;
-
-			vertices[index++] = posFull;
-		}
-	}
-
-	/*生成最终顶点数组数据*/
-	if (sphere)
-	{
-		delete[] sphere;	// 如果sphere已经有数据，先回收
-	}
-	NumVertices = rows * columns * 6; // 顶点数
-	sphere = new point3[NumVertices];
-
-	int colLength = columns + 1;
-	index = 0;
-	for (int r = 0; r < rows; r++)
-	{
-		int offset = r * colLength;
-
-		for (int c = 0; c < columns; c++)
-		{
-			int ul = offset + c;						// 左上
-			int ur = offset + c + 1;					// 右上
-			int br = offset + (c + 1 + colLength);	// 右下
-			int bl = offset + (c + 0 + colLength);	// 左下
-
-			// 由两条经线和纬线围成的矩形
-			sphere[index++] = vertices[ul];
-			sphere[index++] = vertices[bl];
-			sphere[index++] = vertices[br];
-			sphere[index++] = vertices[ul];
-			sphere[index++] = vertices[br];
-			sphere[index++] = vertices[ur];
-		}
-	}
-
-	delete[] vertices;
-
-	return NumVertices;
-}
-
-void BuildRing(GLfloat radius, GLsizei num)
-{
-	int index = 0;	// 数组索引
-	/*生成最终顶点数组数据*/
-	if (ring)
-	{
-		delete[] ring;	// 如果 ring 已经有数据，先回收
-	}
-	ring = new point3[num]; // 存放不同顶点的数组
-	NumRing = num;
-
-	for (int i = 0; i < num; i++)
-	{
-		float v = (float)i / (float)num;  // [0,1] 当前第几段
-		float theta1 = v * 2.0 * (float)M_PI;	   // [0,PI]
-
-		point3 n(0, 0, 0);
-		GLfloat cosTheta1 = cos(theta1);
-		GLfloat sinTheta1 = sin(theta1);
-		n.x = radius * cosTheta1;
-		n.y = radius * sinTheta1;
-
-		ring[i] = n;
-	}
-
-}
+const MeshBuffers* sphere;	// 球的顶点和索引缓冲区
+const MeshBuffers* ring;	// 轨道环的顶点缓冲区
 
 // 显示回调函数
 void Animate(void)
@@ -164,106 +64,94 @@ void Animate(void)
 		DayOfYear = DayOfYear - ((int)(DayOfYear / 365)) * 365;
 	}
 
-	mat4 mv;	// 定义模视矩阵，默认初始化为恒等矩阵
+	// 模视变换用 TransformChain 组合，默认为恒等变换
+	// 每一步直接更新 3x4 仿射矩阵，只有乘投影矩阵时才得到 4x4 矩阵
+	TransformChain mv;
 
 	// 在观察坐标系(照相机坐标系)下思考，定位整个场景(第一种观点)或世界坐标系(第二种观点)
 	// 向负z轴方向平移15个单位
-	mv *= Translate(0.0, 0.0, -15.0);
+	mv.translate(0.0, 0.0, -15.0);
 
 	// 将太阳系绕x轴旋转15度以便在xy-平面上方观察
-	mv *= Rotate(ViewAngle, 1.0, 0.0, 0.0);
-	//mv *= Rotate(90.0, 1.0, 0.0, 0.0); // 俯视角度
+	mv.rotateX(ViewAngle);
+	//mv.rotateX(90.0); // 俯视角度
 
 	/*下面开始构建整个3D世界，在世界坐标系下考虑问题*/
+	// 保存/恢复变换状态直接复制 mv 即可(只有 12 个 float)
+	TransformChain m;
+
 	// 太阳直接画在原点，无须变换，用一个黄色的球体表示
-	mvStack.push(mv); // 保存矩阵状态
-	mv *= Rotate(90.0, 1.0, 0.0, 0.0);
+	m = mv;
+	m.rotateX90().scale(0.8);
 	glBindVertexArray(vaoSphere);
-	glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, proj * mv * Scale(0.8, 0.8, 0.8)); // 传模视投影矩阵
-	glUniform3f(uColor, 1.0, 1.0, 0.0);  // 黄色
-	glDrawArrays(GL_TRIANGLES, 0, NumVertices);
-	mv = mvStack.pop();
+	program.set(MVPMatrix, proj * m); // 传模视投影矩阵
+	program.set(uColor, vec3(1.0, 1.0, 0.0));  // 黄色
+	sphere->draw();
 
 	// 绘制地球轨道
-	mvStack.push(mv);
-	mv *= Rotate(90.0, 1.0, 0.0, 0.0);
+	m = mv;
+	m.rotateX90().scale(4.0);
 	glBindVertexArray(vaoRing);
-	glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, proj * mv * Scale(4, 4, 4)); // 传模视投影矩阵
-	glUniform3f(uColor, 0.0, 0.0, 1.0);  // 蓝色
-	glDrawArrays(GL_LINE_LOOP, 0, NumRing);
-	mv = mvStack.pop();
+	program.set(MVPMatrix, proj * m); // 传模视投影矩阵
+	program.set(uColor, vec3(0.0, 0.0, 1.0));  // 蓝色
+	ring->draw();
 
 	/*对地球系统定位，绕太阳放置它*/
 	// 用DayOfYear来控制其绕太阳的旋转
-	mv *= Rotate(360.0 * DayOfYear / 365.0, 0.0, 1.0, 0.0);
-	mv *= Translate(4.0, 0.0, 0.0);
+	float yearAngle = 360.0 * DayOfYear / 365.0;
+	mv.rotateY(yearAngle).translate(4.0, 0.0, 0.0);
 
 	/*下面开始在地球系统的小世界坐标系下考虑问题*/
-	// 绘制地球，地球的自转不应该影响月球
-	mvStack.push(mv); // 保存矩阵状态
-
-	// 抵消公转对自身倾斜方向的影响，保证公转后 仍然向右倾斜
-	mv *= Rotate(-360.0 * DayOfYear / 365.0, 0.0, 1.0, 0.0);
-
-	// 地球向 右倾斜 23.44度
-	mv *= Rotate(ErothAxialAngle, 0.0, 0.0, 1.0);
+	// 地球系统中连续的旋转用四元数组合，每个物体只转换一次矩阵
+	// 地轴方向：抵消公转对自身倾斜方向的影响，保证公转后 仍然向右倾斜，再向 右倾斜 23.44度
+	quat qAxis = QuatRotateY(-yearAngle) * QuatRotateZ(ErothAxialAngle);
 	// 地球自转，用HourOfDay进行控制
-	mv *= Rotate(360.0 * HourOfDay / 24.0, 0.0, 1.0, 0.0);
-	mv *= Rotate(90.0, 1.0, 0.0, 0.0);
+	quat qSpin = QuatRotateY(360.0 * HourOfDay / 24.0);
+
+	// 绘制地球，地球的自转不应该影响月球
+	m = mv;
+	m *= Rotate(qAxis * qSpin * quatRotateX90);
 	// 最后，画一个蓝色的球来表示地球
 	glBindVertexArray(vaoSphere);
-	glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, proj * mv * Scale(0.4, 0.4, 0.4)); // 传模视投影矩阵
-	glUniform3f(uColor, 0.2, 0.2, 1.0);  // 蓝色
-	glDrawArrays(GL_TRIANGLES, 0, NumVertices);
-	mv = mvStack.pop(); // 恢复矩阵状态
+	program.set(MVPMatrix, proj * m.scale(0.4)); // 传模视投影矩阵
+	program.set(uColor, vec3(0.2, 0.2, 1.0));  // 蓝色
+	sphere->draw();
 
 	// 绘制地球同步卫星轨道
-	mvStack.push(mv);
-	// 抵消地球公转对自身倾斜方向的影响，保证公转后 仍然向右倾斜
-	mv *= Rotate(-360.0 * DayOfYear / 365.0, 0.0, 1.0, 0.0);
-
-	mv *= Rotate(ErothAxialAngle, 0.0, 0.0, 1.0);
-	mv *= Rotate(90.0, 1.0, 0.0, 0.0);
+	m = mv;
+	m *= Rotate(qAxis * quatRotateX90);
 	glBindVertexArray(vaoRing);
-	glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, proj * mv * Scale(0.5, 0.5, 0.5));
-	glUniform3f(uColor, 0.5, 0.0, 0.5);  // 紫色
-	glDrawArrays(GL_LINE_LOOP, 0, NumRing);
-	mv = mvStack.pop();
-
-	// 地球同步卫星
-	mvStack.push(mv);
-	// 抵消地球公转对自身倾斜方向的影响，保证公转后 仍然向右倾斜
-	mv *= Rotate(-360.0 * DayOfYear / 365.0, 0.0, 1.0, 0.0);
-
-	mv *= Rotate(ErothAxialAngle, 0.0, 0.0, 1.0);
-	mv *= Rotate(360.0 * HourOfDay / 24.0, 0.0, 1.0, 0.0); // 旋转速度与地球相同
-	mv *= Translate(0.5, 0.0, 0.0);
-	mv *= Rotate(90.0, 1.0, 0.0, 0.0);
+	program.set(MVPMatrix, proj * m.scale(0.5));
+	program.set(uColor, vec3(0.5, 0.0, 0.5));  // 紫色
+	ring->draw();
+
+	// 地球同步卫星，旋转速度与地球相同
+	// 用对偶四元数组合 旋转 * 平移 * 旋转
+	m = mv;
+	m *= Transform(dualquat(qAxis * qSpin) * dualquat(quatRotateX90, vec3(0.5, 0.0, 0.0)));
 	glBindVertexArray(vaoSphere);
-	glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, proj * mv * Scale(0.05, 0.05, 0.05)); // 传模视投影矩阵
-	glUniform3f(uColor, 0.5, 0.0, 0.5);  // 紫色
-	glDrawArrays(GL_TRIANGLES, 0, NumVertices);
-	mv = mvStack.pop();
+	program.set(MVPMatrix, proj * m.scale(0.05)); // 传模视投影矩阵
+	program.set(uColor, vec3(0.5, 0.0, 0.5));  // 紫色
+	sphere->draw();
 
 	// 绘制月球轨道
-	mvStack.push(mv);
-	mv *= Rotate(90.0, 1.0, 0.0, 0.0);
+	m = mv;
+	m.rotateX90().scale(0.7);
 	glBindVertexArray(vaoRing);
-	glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, proj * mv * Scale(0.7, 0.7, 0.7));
-	glUniform3f(uColor, 0.3, 0.7, 0.3);
-	glDrawArrays(GL_LINE_LOOP, 0, NumRing);
-	mv = mvStack.pop();
+	program.set(MVPMatrix, proj * m);
+	program.set(uColor, vec3(0.3, 0.7, 0.3));
+	ring->draw();
 
 	/*画月球*/
 	// 用DayOfYear来控制其绕地球的旋转
-	mv *= Rotate(360.0 * 12.0 * DayOfYear / 365.0, 0.0, 1.0, 0.0);
-	mv *= Translate(0.7, 0.0, 0.0);
-	mv *= Scale(0.1, 0.1, 0.1);
-	mv *= Rotate(90.0, 1.0, 0.0, 0.0);
+	mv.rotateY(360.0 * 12.0 * DayOfYear / 365.0);
+	mv.translate(0.7, 0.0, 0.0);
+	mv.scale(0.1);
+	mv.rotateX90();
 	glBindVertexArray(vaoSphere);
-	glUniformMatrix4fv(MVPMatrix, 1, GL_TRUE, proj * mv); // 传模视投影矩阵
-	glUniform3f(uColor, 0.3, 0.7, 0.3);
-	glDrawArrays(GL_TRIANGLES, 0, NumVertices);
+	program.set(MVPMatrix, proj * mv); // 传模视投影矩阵
+	program.set(uColor, vec3(0.3, 0.7, 0.3));
+	sphere->draw();
 
 	glutSwapBuffers();					// 交换缓存
 
@@ -273,96 +161,49 @@ void Animate(void)
 	}
 }
 
-void InitSphere()
+// 参数为球的半径及经线和纬线数
+void InitSphere(GLfloat radius, GLsizei columns, GLsizei rows)
 {
-	/*创建一个顶点数组对象(VAO)*/
-	glGenVertexArrays(1, &vaoSphere);  // 生成一个未用的VAO ID，存于变量vao中
-	glBindVertexArray(vaoSphere);      // 创建id为vao的VAO，并绑定为当前VAO
-
-	/*创建并初始化一个缓冲区对象(Buffer Object)*/
-	GLuint buffer;
-	glGenBuffers(1, &buffer); // 生成一个未用的缓冲区对象ID，存于变量buffer中
-	// 创建id为buffer的Array Buffer对象，并绑定为当前Array Buffer对象
-	glBindBuffer(GL_ARRAY_BUFFER, buffer);
-	// 为Buffer对象在GPU端申请空间，并提供数据
-	glBufferData(GL_ARRAY_BUFFER,	// Buffer类型
-		sizeof(point3) * NumVertices,  // 申请空间大小(注意不能是sizeof(sphere),否则是指针变量的大小——4字节)
-		sphere,			 // 提供数据
-		GL_STATIC_DRAW	// 表明将如何使用Buffer的标志(GL_STATIC_DRAW含义是一次提供数据，多遍绘制)
-	);
-
-	delete[] sphere; // 数据已传到 GPU，可删除顶点数据
-
-	glEnableVertexAttribArray(vPosition);	// 启用顶点属性数组
-	// 为顶点属性数组提供数据(数据存放在之前buffer对象中)
-	glVertexAttribPointer(
-		vPosition,			// 属性变量索引
-		3,					// 每个顶点属性的分量个数
-		GL_FLOAT,			// 数组数据类型
-		GL_FALSE,			// 是否进行归一化处理
-		0,  // 在数组中相邻属性成员起始位置间的间隔(以字节为单位)
-		BUFFER_OFFSET(0)    // 第一个属性值在buffer中的偏移量
-	);
+	// 球的顶点和索引由 MeshCache 生成并上传，相同参数的球只上传一次
+	// 球的半径为 1，坐标在 [-1, 1] 内，按 snorm16 上传(每个顶点由 12 字节减为 8 字节)
+	sphere = &MeshCache::Sphere(radius, columns, rows);
+
+	/*创建一个顶点数组对象(VAO)，设置顶点属性并绑定索引缓冲区*/
+	vaoSphere = sphere->vertexArray(vPosition);
 }
 
-void InitRing()
+// 参数为环的半径和顶点数
+void InitRing(GLfloat radius, GLsizei num)
 {
+	ring = &MeshCache::Ring(radius, num);
+
 	/*创建一个顶点数组对象(VAO)*/
-	glGenVertexArrays(1, &vaoRing);  // 生成一个未用的VAO ID，存于变量vao中
-	glBindVertexArray(vaoRing);      // 创建id为vao的VAO，并绑定为当前VAO
-
-	/*创建并初始化一个缓冲区对象(Buffer Object)*/
-	GLuint bufferRing;
-	glGenBuffers(1, &bufferRing); // 生成一个未用的缓冲区对象ID，存于变量buffer中
-	// 创建id为buffer的Array Buffer对象，并绑定为当前Array Buffer对象
-	glBindBuffer(GL_ARRAY_BUFFER, bufferRing);
-	// 为Buffer对象在GPU端申请空间，并提供数据
-	glBufferData(GL_ARRAY_BUFFER,	// Buffer类型
-		sizeof(point3) * NumRing,  // 申请空间大小(注意不能是sizeof(sphere),否则是指针变量的大小——4字节)
-		ring,			 // 提供数据
-		GL_STATIC_DRAW	// 表明将如何使用Buffer的标志(GL_STATIC_DRAW含义是一次提供数据，多遍绘制)
-	);
-
-	delete[] ring; // 数据已传到 GPU，可删除顶点数据
-
-	glEnableVertexAttribArray(vPosition);	// 启用顶点属性数组
-	// 为顶点属性数组提供数据(数据存放在之前buffer对象中)
-	glVertexAttribPointer(
-		vPosition,			// 属性变量索引
-		3,					// 每个顶点属性的分量个数
-		GL_FLOAT,			// 数组数据类型
-		GL_FALSE,			// 是否进行归一化处理
-		0,  // 在数组中相邻属性成员起始位置间的间隔(以字节为单位)
-		BUFFER_OFFSET(0)    // 第一个属性值在buffer中的偏移量
-	);
+	vaoRing = ring->vertexArray(vPosition);
 }
 
 // 初始化OpenGL的状态
 void Init(void)
 {
-	// 生成中心在原点半径为1,15条经线和纬线的球的顶点
-	BuildSphere(1.0, 15, 15);
-	// 生成一个位于 x y 平面的轨道环 72个顶点
-	BuildRing(1.0, 72);
-
 	/*加载shader并使用所得到的shader程序*/
 	// InitShader为InitShader.cpp中定义的函数，参数分别为顶点和片元shader的文件名
-	// 返回值为shader程序对象的ID
-	GLuint program = InitShader("vSolar.glsl", "fSolar.glsl");
-	glUseProgram(program); // 使用该shader程序
+	// 返回值为shader程序对象的ID，由 Program 列出其中所有的 uniform 和属性变量
+	program = Program(InitShader("vSolar.glsl", "fSolar.glsl"));
+	program.use(); // 使用该shader程序
 
 	/*初始化顶点着色器中的顶点位置属性*/
 	// 获取shader程序中属性变量的位置(索引)
-	vPosition = glGetAttribLocation(program, "vPosition");
+	vPosition = program.attrib("vPosition");
 
-	InitSphere();
-	InitRing();
+	// 中心在原点半径为1,15条经线和纬线的球
+	InitSphere(1.0, 15, 15);
+	// 位于 x y 平面的轨道环 72个顶点
+	InitRing(1.0, 72);
 
-	// 获取shader中uniform变量"MVPMatrix"的索引
-	MVPMatrix = glGetUniformLocation(program, "MVPMatrix");
+	// 获取shader中uniform变量"MVPMatrix"的句柄
+	MVPMatrix = program.uniform("MVPMatrix");
 
-	// 获取shader中uniform变量"uColor"的索引
-	uColor = glGetUniformLocation(program, "uColor");
+	// 获取shader中uniform变量"uColor"的句柄
+	uColor = program.uniform("uColor");
 
 	glClearColor(0.0, 0.0, 0.0, 0.0);		// 背景为黑色				
 	glEnable(GL_DEPTH_TEST);				// 开启深度检测
@@ -426,6 +267,8 @@ void KeyPressFunc(unsigned char Key, int x, int y)
 		}
 		break;
 	case 27:	// Esc键
+		std::cout << "glUniform: " << program.stats().issued << " issued, "
+			<< program.stats().skipped << " skipped" << std::endl;
 		exit(EXIT_SUCCESS);
 	}
 }
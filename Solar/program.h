@@ -0,0 +1,406 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+//
+//  --- program.h ---
+//  shader 程序的反射：链接后列出所有活动的 uniform 和属性变量，按名字查位置只在初始化时做一次，
+//  设置 uniform 时与上次设置的值比较，值没有变化时不调用 glUniform*
+//
+//   Program            包装 InitShader 返回的程序 ID(不负责删除，需要时调用 release())
+//   Program::Uniform   uniform 变量的句柄，由 uniform(name) 取得，程序重新编译后仍然有效
+//   UniformStats       调用和跳过的 glUniform* 次数
+//
+//   例：
+//     Program phong(InitShader("vPhong.glsl", "fPhong.glsl"));
+//     phong.use();
+//     WatchShader(phong.id(), "vPhong.glsl", "fPhong.glsl");	// 可选：重新编译后自动重新反射
+//     Program::Uniform shininess = phong.uniform("Shininess");
+//     phong.set(shininess, 10.0f);	// 值与上次相同时跳过
+//
+//   与 glUniform* 相同，设置时该程序必须是当前程序；
+//   不要对同一个变量混用 set() 和直接的 glUniform*，否则记录的值与 GL 中的值不一致
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ANGEL_PROGRAM_H__
+#define __ANGEL_PROGRAM_H__
+
+#include <algorithm>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Angel
+{
+
+	// 一个 uniform 变量(数组的每个元素单独一项)
+	struct UniformInfo
+	{
+		std::string  name;			// 数组元素为 "name[k]"
+		GLint        location;
+		GLenum       type;
+		GLint        remaining;		// 从本元素到数组末尾的元素个数(不是数组时为 1)
+		size_t       bytes;			// 一个元素的字节数
+		size_t       offset;		// 上次设置的值在 shadow 中的偏移
+		bool         valid;			// shadow 中是否为 GL 中的当前值
+	};
+
+	// 一个活动的属性变量
+	struct AttribInfo
+	{
+		std::string  name;
+		GLint        location;
+		GLenum       type;
+		GLint        size;
+	};
+
+	struct UniformStats
+	{
+		unsigned long long issued = 0;	// 调用 glUniform* 的次数
+		unsigned long long skipped = 0;	// 值未变化而跳过的次数
+	};
+
+	//----------------------------------------------------------------------------
+	//
+	//  Program - 反射后的 shader 程序
+	//
+
+	class Program
+	{
+	public:
+		// uniform 变量的句柄：按名字登记，重新反射后自动对应到新程序中的同名变量
+		struct Uniform
+		{
+			int index = -1;
+		};
+
+	private:
+		GLuint _program = 0;
+		GLuint _reflected = 0;		// 上次反射的程序，与 _program 不同时说明程序已被替换
+		std::vector<UniformInfo> _uniforms;		// 同一数组的元素相邻存放
+		std::vector<AttribInfo> _attribs;
+		std::vector<GLubyte> _shadow;
+		std::unordered_map<std::string, int> _uniformByName;	// 数组名和 "name[0]" 都对应第 0 个元素
+
+		std::vector<std::string> _handleNames;	// 句柄登记的名字
+		std::vector<int> _handleUniforms;		// 句柄对应的 _uniforms 下标，变量不存在时为 -1
+
+		UniformStats _stats;
+
+	public:
+		Program() = default;
+		explicit Program(GLuint program) : _program(program) { reflect(); }
+
+		// 程序 ID；返回引用，可以交给 WatchShader，程序被替换后下次设置时重新反射
+		GLuint& id() { return _program; }
+		GLuint id() const { return _program; }
+
+		void use() { glUseProgram(_program); }
+
+		void release()
+		{
+			glDeleteProgram(_program);
+			_program = 0;
+			reflect();
+		}
+
+		const std::vector<UniformInfo>& uniforms() { refresh(); return _uniforms; }
+		const std::vector<AttribInfo>& attribs() { refresh(); return _attribs; }
+
+		const UniformStats& stats() const { return _stats; }
+		void resetStats() { _stats = UniformStats(); }
+
+		// 属性变量的位置，不存在时返回 -1
+		GLint attrib(const char* name)
+		{
+			refresh();
+			for (const AttribInfo& attrib : _attribs)
+			{
+				if (attrib.name == name)
+				{
+					return attrib.location;
+				}
+			}
+			return -1;
+		}
+
+		// uniform 变量(或数组元素 "name[k]")的句柄；变量不存在时句柄仍然有效，设置时什么都不做
+		Uniform uniform(const char* name)
+		{
+			refresh();
+			Uniform handle;
+			for (size_t i = 0; i < _handleNames.size(); i++)
+			{
+				if (_handleNames[i] == name)
+				{
+					handle.index = (int)i;
+					return handle;
+				}
+			}
+			handle.index = (int)_handleNames.size();
+			_handleNames.push_back(name);
+			_handleUniforms.push_back(findUniform(name));
+			return handle;
+		}
+
+		// 数组的第 element 个元素
+		Uniform uniform(const char* name, int element)
+		{
+			return uniform((std::string(name) + "[" + std::to_string(element) + "]").c_str());
+		}
+
+		// 取得 uniform 的位置(不经过 shadow，例如交给其他函数直接设置)，不存在时返回 -1
+		GLint location(Uniform u)
+		{
+			int i = lookup(u);
+			return i < 0 ? -1 : _uniforms[i].location;
+		}
+
+		//
+		//  --- 设置 uniform ---
+		//  矩阵与程序中其他地方一样按行优先传入(transpose 为 GL_TRUE)
+		//
+
+		void set(Uniform u, GLfloat v)
+		{
+			GLsizei count = 1;
+			GLint l = update(u, &v, sizeof(GLfloat), count);
+			if (l >= 0) glUniform1f(l, v);
+		}
+
+		void set(Uniform u, GLint v)
+		{
+			GLsizei count = 1;
+			GLint l = update(u, &v, sizeof(GLint), count);
+			if (l >= 0) glUniform1i(l, v);
+		}
+
+		void set(Uniform u, bool v)
+		{
+			set(u, GLint(v ? 1 : 0));
+		}
+
+		void set(Uniform u, const vec2& v)
+		{
+			GLsizei count = 1;
+			GLint l = update(u, static_cast<const GLfloat*>(v), 2 * sizeof(GLfloat), count);
+			if (l >= 0) glUniform2fv(l, 1, v);
+		}
+
+		void set(Uniform u, const vec3& v)
+		{
+			GLsizei count = 1;
+			GLint l = update(u, static_cast<const GLfloat*>(v), 3 * sizeof(GLfloat), count);
+			if (l >= 0) glUniform3fv(l, 1, v);
+		}
+
+		void set(Uniform u, const vec4& v)
+		{
+			GLsizei count = 1;
+			GLint l = update(u, static_cast<const GLfloat*>(v), 4 * sizeof(GLfloat), count);
+			if (l >= 0) glUniform4fv(l, 1, v);
+		}
+
+		void set(Uniform u, const mat3& m)
+		{
+			GLsizei count = 1;
+			GLint l = update(u, static_cast<const GLfloat*>(m), 9 * sizeof(GLfloat), count);
+			if (l >= 0) glUniformMatrix3fv(l, 1, GL_TRUE, m);
+		}
+
+		void set(Uniform u, const mat4& m)
+		{
+			GLsizei count = 1;
+			GLint l = update(u, static_cast<const GLfloat*>(m), 16 * sizeof(GLfloat), count);
+			if (l >= 0) glUniformMatrix4fv(l, 1, GL_TRUE, m);
+		}
+
+		// 从 u 开始的 count 个 vec4 数组元素，超出数组的部分忽略
+		void set(Uniform u, const vec4* v, GLsizei count)
+		{
+			GLint l = update(u, v, 4 * sizeof(GLfloat), count);
+			if (l >= 0) glUniform4fv(l, count, static_cast<const GLfloat*>(*v));
+		}
+
+		// 3x4 仿射矩阵按三个 vec4 传给 vec4 name[3]
+		void set(Uniform u, const affine3x4& m)
+		{
+			GLsizei count = 3;
+			GLint l = update(u, static_cast<const GLfloat*>(m), 4 * sizeof(GLfloat), count);
+			if (l >= 0) glUniform4fv(l, count, m);
+		}
+
+		// 按名字设置，每次都要查找句柄，只适合初始化等不频繁的地方
+		template <typename T>
+		void set(const char* name, const T& value)
+		{
+			set(uniform(name), value);
+		}
+
+		// 重新列出活动的 uniform 和属性变量，记录的值全部作废，已有的句柄按名字重新对应
+		void reflect()
+		{
+			_reflected = _program;
+			_uniforms.clear();
+			_attribs.clear();
+			_shadow.clear();
+			_uniformByName.clear();
+
+			if (_program)
+			{
+				reflectUniforms();
+				reflectAttribs();
+			}
+
+			for (size_t i = 0; i < _handleNames.size(); i++)
+			{
+				_handleUniforms[i] = findUniform(_handleNames[i]);
+			}
+		}
+
+	private:
+		// 程序被 WatchShader 替换后重新反射
+		void refresh()
+		{
+			if (_program != _reflected)
+			{
+				reflect();
+			}
+		}
+
+		int findUniform(const std::string& name) const
+		{
+			auto it = _uniformByName.find(name);
+			return it == _uniformByName.end() ? -1 : it->second;
+		}
+
+		int lookup(Uniform u)
+		{
+			refresh();
+			if (u.index < 0 || u.index >= (int)_handleUniforms.size())
+			{
+				return -1;
+			}
+			return _handleUniforms[u.index];
+		}
+
+		// 比较 count 个元素与上次设置的值：相同时返回 -1(跳过)，否则记下新值并返回位置
+		// 元素大小与变量类型不符时不比较，直接交给 GL(由 GL 报告错误)
+		GLint update(Uniform u, const void* value, size_t elementBytes, GLsizei& count)
+		{
+			int i = lookup(u);
+			if (i < 0 || _uniforms[i].location < 0)
+			{
+				return -1;
+			}
+
+			UniformInfo& first = _uniforms[i];
+			count = std::min(count, (GLsizei)first.remaining);
+			if (elementBytes != first.bytes)
+			{
+				for (GLsizei k = 0; k < count; k++)
+				{
+					_uniforms[i + k].valid = false;
+				}
+				_stats.issued++;
+				return first.location;
+			}
+
+			size_t bytes = elementBytes * count;
+			GLubyte* shadow = &_shadow[first.offset];
+			bool same = memcmp(shadow, value, bytes) == 0;
+			for (GLsizei k = 0; same && k < count; k++)
+			{
+				same = _uniforms[i + k].valid;
+			}
+			if (same)
+			{
+				_stats.skipped++;
+				return -1;
+			}
+
+			memcpy(shadow, value, bytes);
+			for (GLsizei k = 0; k < count; k++)
+			{
+				_uniforms[i + k].valid = true;
+			}
+			_stats.issued++;
+			return first.location;
+		}
+
+		// 一个元素的字节数，矩阵按紧密排列的 float 计算，int / bool / 采样器为一个 GLint
+		static size_t uniformBytes(GLenum type)
+		{
+			switch (type)
+			{
+			case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_BOOL_VEC2: return 8;
+			case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_BOOL_VEC3: return 12;
+			case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_BOOL_VEC4: case GL_FLOAT_MAT2: return 16;
+			case GL_FLOAT_MAT3: return 36;
+			case GL_FLOAT_MAT4: return 64;
+			default: return 4;
+			}
+		}
+
+		void reflectUniforms()
+		{
+			GLint count = 0, maxLength = 0;
+			glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &count);
+			glGetProgramiv(_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+			std::vector<GLchar> name(maxLength + 16);
+			for (GLint i = 0; i < count; i++)
+			{
+				GLint size;
+				GLenum type;
+				glGetActiveUniform(_program, i, (GLsizei)name.size(), NULL, &size, &type, name.data());
+
+				std::string base = name.data();
+				bool isArray = base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0;
+				if (isArray)
+				{
+					base.resize(base.size() - 3);
+				}
+				// uniform block 中的变量没有位置，不能用 glUniform* 设置
+				if (glGetUniformLocation(_program, name.data()) < 0)
+				{
+					continue;
+				}
+
+				// 每个元素单独一项，shadow 中的值与 glUniform*v 传入的数组一样连续存放
+				size_t bytes = uniformBytes(type);
+				_uniformByName[base] = (int)_uniforms.size();
+				for (GLint k = 0; k < size; k++)
+				{
+					UniformInfo info;
+					info.name = isArray ? base + "[" + std::to_string(k) + "]" : base;
+					info.location = glGetUniformLocation(_program, info.name.c_str());
+					info.type = type;
+					info.remaining = size - k;
+					info.bytes = bytes;
+					info.offset = _shadow.size();
+					info.valid = false;
+					_shadow.resize(_shadow.size() + bytes);
+					_uniformByName[info.name] = (int)_uniforms.size();
+					_uniforms.push_back(info);
+				}
+			}
+		}
+
+		void reflectAttribs()
+		{
+			GLint count = 0, maxLength = 0;
+			glGetProgramiv(_program, GL_ACTIVE_ATTRIBUTES, &count);
+			glGetProgramiv(_program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+			std::vector<GLchar> name(maxLength + 16);
+			for (GLint i = 0; i < count; i++)
+			{
+				AttribInfo attrib;
+				glGetActiveAttrib(_program, i, (GLsizei)name.size(), NULL, &attrib.size, &attrib.type, name.data());
+				attrib.name = name.data();
+				attrib.location = glGetAttribLocation(_program, name.data());
+				_attribs.push_back(attrib);
+			}
+		}
+	};
+
+}  // namespace Angel
+
+#endif // __ANGEL_PROGRAM_H__
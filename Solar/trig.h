@@ -0,0 +1,219 @@
+﻿//////////////////////////////////////////////////////////////////////////////
+//
+//  --- trig.h ---
+//  快速正弦/余弦(多项式近似)，供几何生成和 Rotate() 使用
+//
+//   SinCos(x, s, c)           单个角度，同时求 sin 和 cos
+//   SinCos(xs, ss, cs, count) 一批角度，按 mat.h 中的 SIMD 配置每次计算 4 个
+//   SinCosTable               等步长角度 start + i * step 的 sin/cos 表，
+//                             网格类几何(球、环、圆)每行/每列的角度相同，查表即可
+//
+//   误差：|x| <= 8192 时与双精度 sin/cos 的最大绝对误差为 9.3e-8(实测)，
+//         与 GLfloat 的舍入误差同一量级；|x| 更大时精度逐渐下降，不应使用。
+//   算法：按 PI/2 分段规约(Cody-Waite 三段常数)到 [-PI/4, PI/4]，
+//         再用 Cephes sinf/cosf 的极小化多项式求值，最后按象限交换/取负。
+//
+//   由 mat.h 包含，SIMD 实现的选择与 mat.h 的 SIMD 配置一致
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ANGEL_TRIG_H__
+#define __ANGEL_TRIG_H__
+
+#include <stddef.h>
+#include <vector>
+#include "vec.h"
+
+#if defined(ANGEL_SIMD_SSE)
+#  include <emmintrin.h>
+#endif
+
+namespace Angel
+{
+
+	namespace detail
+	{
+		const GLfloat TwoOverPi = 0.636619772367581343f;
+		// PI/2 = PiOver2A + PiOver2B + PiOver2C，前两段的有效位较少，与象限号相乘时没有舍入误差
+		const GLfloat PiOver2A = 1.5703125f;
+		const GLfloat PiOver2B = 4.837512969970703125e-4f;
+		const GLfloat PiOver2C = 7.54978995489188216e-8f;
+
+		// [-PI/4, PI/4] 上的极小化多项式，z = r * r
+		inline GLfloat sinPoly(GLfloat r, GLfloat z)
+		{
+			return r + r * z * ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f);
+		}
+
+		inline GLfloat cosPoly(GLfloat z)
+		{
+			return 1.0f - 0.5f * z + z * z * ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f);
+		}
+	}
+
+	// 同时计算 x(弧度)的正弦和余弦
+	inline void SinCos(GLfloat x, GLfloat& s, GLfloat& c)
+	{
+		// 象限号 q = round(x / (PI/2))，r = x - q * PI/2
+		GLfloat y = x * detail::TwoOverPi;
+		int q = (int)(y + (y >= 0.0f ? 0.5f : -0.5f));
+		GLfloat fq = (GLfloat)q;
+		GLfloat r = ((x - fq * detail::PiOver2A) - fq * detail::PiOver2B) - fq * detail::PiOver2C;
+		GLfloat z = r * r;
+
+		GLfloat sr = detail::sinPoly(r, z);
+		GLfloat cr = detail::cosPoly(z);
+
+		// 奇数象限交换 sin/cos，再按象限确定符号
+		s = (q & 1) ? cr : sr;
+		c = (q & 1) ? sr : cr;
+		if (q & 2)
+		{
+			s = -s;
+		}
+		if ((q + 1) & 2)
+		{
+			c = -c;
+		}
+	}
+
+	// 批量计算 count 个角度的正弦和余弦，s 或 c 可以为 NULL(不需要的结果不写)
+	inline void SinCos(const GLfloat* x, GLfloat* s, GLfloat* c, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(ANGEL_SIMD_SSE)
+		const __m128 twoOverPi = _mm_set1_ps(detail::TwoOverPi);
+		const __m128 piA = _mm_set1_ps(detail::PiOver2A);
+		const __m128 piB = _mm_set1_ps(detail::PiOver2B);
+		const __m128 piC = _mm_set1_ps(detail::PiOver2C);
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000));
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 v = _mm_loadu_ps(x + i);
+			__m128i q = _mm_cvtps_epi32(_mm_mul_ps(v, twoOverPi)); // 就近取整
+			__m128 fq = _mm_cvtepi32_ps(q);
+			__m128 r = _mm_sub_ps(v, _mm_mul_ps(fq, piA));
+			r = _mm_sub_ps(r, _mm_mul_ps(fq, piB));
+			r = _mm_sub_ps(r, _mm_mul_ps(fq, piC));
+			__m128 z = _mm_mul_ps(r, r);
+
+			__m128 sr = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), z), _mm_set1_ps(8.3321608736e-3f));
+			sr = _mm_sub_ps(_mm_mul_ps(sr, z), _mm_set1_ps(1.6666654611e-1f));
+			sr = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, z), sr));
+
+			__m128 cr = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), z), _mm_set1_ps(1.388731625493765e-3f));
+			cr = _mm_add_ps(_mm_mul_ps(cr, z), _mm_set1_ps(4.166664568298827e-2f));
+			cr = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_mul_ps(_mm_mul_ps(z, z), cr));
+
+			// 奇数象限交换，按象限取负(符号位异或)
+			__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+			__m128 sv = _mm_or_ps(_mm_and_ps(swap, cr), _mm_andnot_ps(swap, sr));
+			__m128 cv = _mm_or_ps(_mm_and_ps(swap, sr), _mm_andnot_ps(swap, cr));
+			__m128 sSign = _mm_and_ps(_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30)), signMask);
+			__m128 cSign = _mm_and_ps(_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30)), signMask);
+
+			if (s)
+			{
+				_mm_storeu_ps(s + i, _mm_xor_ps(sv, sSign));
+			}
+			if (c)
+			{
+				_mm_storeu_ps(c + i, _mm_xor_ps(cv, cSign));
+			}
+		}
+#elif defined(ANGEL_SIMD_NEON)
+		const float32x4_t twoOverPi = vdupq_n_f32(detail::TwoOverPi);
+		const uint32x4_t one = vdupq_n_u32(1);
+		const uint32x4_t two = vdupq_n_u32(2);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			float32x4_t v = vld1q_f32(x + i);
+			float32x4_t y = vmulq_f32(v, twoOverPi);
+			// 就近取整：加上与 y 同号的 0.5 后向零截断
+			uint32x4_t ySign = vandq_u32(vreinterpretq_u32_f32(y), vdupq_n_u32(0x80000000u));
+			float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), ySign));
+			int32x4_t q = vcvtq_s32_f32(vaddq_f32(y, half));
+			float32x4_t fq = vcvtq_f32_s32(q);
+			float32x4_t r = vmlsq_f32(v, fq, vdupq_n_f32(detail::PiOver2A));
+			r = vmlsq_f32(r, fq, vdupq_n_f32(detail::PiOver2B));
+			r = vmlsq_f32(r, fq, vdupq_n_f32(detail::PiOver2C));
+			float32x4_t z = vmulq_f32(r, r);
+
+			float32x4_t sr = vmlaq_f32(vdupq_n_f32(8.3321608736e-3f), vdupq_n_f32(-1.9515295891e-4f), z);
+			sr = vmlaq_f32(vdupq_n_f32(-1.6666654611e-1f), sr, z);
+			sr = vmlaq_f32(r, vmulq_f32(r, z), sr);
+
+			float32x4_t cr = vmlaq_f32(vdupq_n_f32(-1.388731625493765e-3f), vdupq_n_f32(2.443315711809948e-5f), z);
+			cr = vmlaq_f32(vdupq_n_f32(4.166664568298827e-2f), cr, z);
+			cr = vmlaq_f32(vmlsq_f32(vdupq_n_f32(1.0f), vdupq_n_f32(0.5f), z), vmulq_f32(z, z), cr);
+
+			uint32x4_t uq = vreinterpretq_u32_s32(q);
+			uint32x4_t swap = vceqq_u32(vandq_u32(uq, one), one);
+			float32x4_t sv = vbslq_f32(swap, cr, sr);
+			float32x4_t cv = vbslq_f32(swap, sr, cr);
+			uint32x4_t sSign = vshlq_n_u32(vandq_u32(uq, two), 30);
+			uint32x4_t cSign = vshlq_n_u32(vandq_u32(vaddq_u32(uq, one), two), 30);
+
+			if (s)
+			{
+				vst1q_f32(s + i, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(sv), sSign)));
+			}
+			if (c)
+			{
+				vst1q_f32(c + i, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(cv), cSign)));
+			}
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			GLfloat sv, cv;
+			SinCos(x[i], sv, cv);
+			if (s)
+			{
+				s[i] = sv;
+			}
+			if (c)
+			{
+				c[i] = cv;
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------
+	//
+	//  SinCosTable - 等步长角度的正弦/余弦表
+	//
+	//    第 i 项对应角度 start + i * step(弧度)，每项直接由角度计算，不做累加，没有误差积累
+	//
+
+	class SinCosTable
+	{
+		std::vector<GLfloat> _sin;
+		std::vector<GLfloat> _cos;
+
+	public:
+		SinCosTable(GLfloat start, GLfloat step, size_t count) :
+			_sin(count), _cos(count)
+		{
+			std::vector<GLfloat> angles(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				angles[i] = start + step * (GLfloat)i;
+			}
+			SinCos(angles.data(), _sin.data(), _cos.data(), count);
+		}
+
+		size_t size() const { return _sin.size(); }
+
+		GLfloat sin(size_t i) const { return _sin[i]; }
+		GLfloat cos(size_t i) const { return _cos[i]; }
+	};
+
+}  // namespace Angel
+
+#endif // __ANGEL_TRIG_H__